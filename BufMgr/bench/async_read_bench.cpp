@@ -0,0 +1,120 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+// Compares blocking BufMgr::readPage() with coroutines awaiting
+// BufMgr::readPageAsync() on misses.
+//
+// Usage: async_read_bench [pages] [frames]
+//
+// A file of <pages> pages is read once in random order through a pool of
+// <frames> frames.  Before every run the file is evicted from the OS page
+// cache with posix_fadvise(), so each miss really goes to the device.  The
+// async runs spawn one coroutine per page and vary the number of I/O threads.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "async_io.h"
+#include "buffer.h"
+#include "exceptions/file_not_found_exception.h"
+#include "file.h"
+#include "page.h"
+
+using namespace badgerdb;
+
+namespace {
+
+void dropCache(const std::string& filename) {
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+  }
+}
+
+void report(const char* name, const int num_pages,
+            const std::chrono::steady_clock::time_point start) {
+  const double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  std::printf("%-16s %8d reads %10.3f s %12.0f pages/s\n", name, num_pages,
+              seconds, num_pages / seconds);
+}
+
+Task touch(BufMgr* buf_mgr, File* file, const PageId page_number,
+           std::size_t& bytes) {
+  PageGuard guard = co_await buf_mgr->readPageAsync(file, page_number);
+  bytes += guard->getFreeSpace();
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  const int num_pages = argc > 1 ? std::atoi(argv[1]) : 4000;
+  const int num_frames = argc > 2 ? std::atoi(argv[2]) : 256;
+  const std::string filename = "async_read_bench.db";
+  try {
+    File::remove(filename);
+  } catch (FileNotFoundException&) {
+  }
+
+  {
+    File file = File::create(filename);
+    for (int i = 0; i < num_pages; ++i) {
+      Page page = file.allocatePage();
+      page.insertRecord(std::string(4000, 'x'));
+      file.writePage(page);
+    }
+    file.sync();
+
+    std::vector<PageId> order;
+    for (int i = 1; i <= num_pages; ++i) {
+      order.push_back(i);
+    }
+    std::mt19937 rng(42);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::size_t bytes = 0;
+    {
+      BufMgr buf_mgr(num_frames);
+      dropCache(filename);
+      const auto start = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i < order.size(); ++i) {
+        Page* page;
+        buf_mgr.readPage(&file, order[i], page);
+        bytes += page->getFreeSpace();
+        buf_mgr.unPinPage(&file, order[i], false /* dirty */);
+      }
+      report("readPage", num_pages, start);
+    }
+
+    const std::uint32_t threads[] = {1, 4, 16, 64};
+    for (std::size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t) {
+      BufMgr buf_mgr(num_frames);
+      EventLoop loop(threads[t]);
+      dropCache(filename);
+      const auto start = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i < order.size(); ++i) {
+        loop.spawn(touch(&buf_mgr, &file, order[i], bytes));
+      }
+      loop.run();
+      char name[32];
+      std::snprintf(name, sizeof(name), "async x%u", threads[t]);
+      report(name, num_pages, start);
+    }
+    std::printf("(checksum %zu)\n", bytes);
+  }
+  File::remove(filename);
+  return 0;
+}
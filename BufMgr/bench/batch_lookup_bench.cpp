@@ -0,0 +1,103 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+// Measures BufHashTbl probe throughput of single lookups against batched,
+// group-prefetched lookups.
+//
+// Usage: batch_lookup_bench [entries] [lookups]
+//
+// The table holds <entries> pages, inserted in random order so that chain
+// buckets are scattered over the heap, and is sized well beyond the caches.
+// <lookups> random probes of present pages are then issued one at a time
+// with lookup() and in batches of 1 to 64 with lookupBatch().
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bufHashTbl.h"
+#include "exceptions/file_not_found_exception.h"
+#include "file.h"
+
+using namespace badgerdb;
+
+namespace {
+
+void report(const char* name, const std::size_t lookups,
+            const std::chrono::steady_clock::time_point start,
+            const std::uint64_t checksum) {
+  const double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  std::printf("%-14s %10zu lookups %8.3f s %8.1f M/s  (checksum %llu)\n", name,
+              lookups, seconds, lookups / seconds / 1e6,
+              static_cast<unsigned long long>(checksum));
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  const int entries = argc > 1 ? std::atoi(argv[1]) : 1 << 22;
+  const std::size_t lookups = argc > 2 ? std::atol(argv[2]) : 1 << 23;
+  const std::string filename = "batch_lookup_bench.db";
+  try {
+    File::remove(filename);
+  } catch (FileNotFoundException&) {
+  }
+
+  {
+    File file = File::create(filename);
+    BufHashTbl table(entries);
+    std::vector<PageId> pages;
+    for (int i = 1; i <= entries; ++i) {
+      pages.push_back(i);
+    }
+    std::mt19937 rng(42);
+    std::shuffle(pages.begin(), pages.end(), rng);
+    for (std::size_t i = 0; i < pages.size(); ++i) {
+      table.insert(&file, pages[i], i);
+    }
+
+    std::vector<PageId> probes(lookups);
+    std::uniform_int_distribution<PageId> page_dist(1, entries);
+    for (std::size_t i = 0; i < lookups; ++i) {
+      probes[i] = page_dist(rng);
+    }
+
+    {
+      std::uint64_t checksum = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i < lookups; ++i) {
+        FrameId frame;
+        table.lookup(&file, probes[i], frame);
+        checksum += frame;
+      }
+      report("lookup", lookups, start, checksum);
+    }
+
+    FrameId frames[BufHashTbl::MAX_BATCH];
+    bool found[BufHashTbl::MAX_BATCH];
+    for (std::size_t batch = 1; batch <= BufHashTbl::MAX_BATCH; batch *= 2) {
+      std::uint64_t checksum = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i + batch <= lookups; i += batch) {
+        table.lookupBatch(&file, &probes[i], batch, frames, found);
+        for (std::size_t j = 0; j < batch; ++j) {
+          checksum += frames[j];
+        }
+      }
+      char name[32];
+      std::snprintf(name, sizeof(name), "batch %zu", batch);
+      report(name, lookups - lookups % batch, start, checksum);
+    }
+  }
+  File::remove(filename);
+  return 0;
+}
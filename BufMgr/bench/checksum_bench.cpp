@@ -0,0 +1,115 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+// Measures the cost of page checksums on the buffer pool miss path.
+//
+// Usage: checksum_bench [pages] [rounds]
+//
+// First the raw CRC32C speed over one page is measured for the hardware and
+// the table-driven implementation.  Then a file of <pages> pages is read
+// <rounds> times through a BufMgr too small to hold it, so every read is a
+// miss, once with checksum verification off and once with it on.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "buffer.h"
+#include "crc32c.h"
+#include "exceptions/file_not_found_exception.h"
+#include "file.h"
+#include "page.h"
+
+using namespace badgerdb;
+
+namespace {
+
+template <typename Function>
+double seconds(const Function& function) {
+  const auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+void crcSpeed() {
+  const std::string page(Page::SIZE, 'x');
+  const int iterations = 200000;
+  volatile std::uint32_t sink = 0;
+  const double hardware = seconds([&]() {
+    for (int i = 0; i < iterations; ++i) {
+      sink = crc32c(page.data(), page.size(), sink);
+    }
+  });
+  const double software = seconds([&]() {
+    for (int i = 0; i < iterations; ++i) {
+      sink = crc32cSoftware(page.data(), page.size(), sink);
+    }
+  });
+  std::printf("crc32c %-9s %8.1f ns/page\n",
+              crc32cHardwareAvailable() ? "(sse4.2)" : "(table)",
+              hardware * 1e9 / iterations);
+  std::printf("crc32c %-9s %8.1f ns/page\n", "(table)",
+              software * 1e9 / iterations);
+}
+
+void missPath(const int num_pages, const int rounds) {
+  const std::string filename = "checksum_bench.db";
+  try {
+    File::remove(filename);
+  } catch (FileNotFoundException&) {
+  }
+
+  {
+    File file = File::create(filename);
+    for (int i = 0; i < num_pages; ++i) {
+      Page page = file.allocatePage();
+      page.insertRecord(std::string(4000, 'x'));
+      file.writePage(page);
+    }
+    file.sync();
+
+    for (int verify = 0; verify <= 1; ++verify) {
+      file.setChecksumVerification(verify != 0);
+      BufMgr buf_mgr(16);
+      const double elapsed = seconds([&]() {
+        for (int round = 0; round < rounds; ++round) {
+          for (PageId page_number = 1; page_number <= (PageId)num_pages;
+               ++page_number) {
+            Page* page;
+            buf_mgr.readPage(&file, page_number, page);
+            buf_mgr.unPinPage(&file, page_number, false);
+          }
+        }
+      });
+      std::printf("miss path, verify %-3s %8.1f ns/page\n",
+                  verify ? "on" : "off",
+                  elapsed * 1e9 / (static_cast<double>(rounds) * num_pages));
+    }
+  }
+  File::remove(filename);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  const int num_pages = argc > 1 ? std::atoi(argv[1]) : 2000;
+  const int rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  // Known answer of the CRC32C specification.
+  const char check[] = "123456789";
+  if (crc32c(check, 9) != 0xE3069283 ||
+      crc32cSoftware(check, 9) != 0xE3069283) {
+    std::printf("crc32c check value mismatch\n");
+    return 1;
+  }
+
+  crcSpeed();
+  missPath(num_pages, rounds);
+  return 0;
+}
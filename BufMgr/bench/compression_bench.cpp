@@ -0,0 +1,99 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+// Compares disk footprint, I/O bytes and time with page compression off and
+// on.
+//
+// Usage: compression_bench [pages] [fill_percent]
+//
+// <pages> slotted pages are filled to <fill_percent> of their capacity with
+// text-like records, written through a BufMgr and flushed, then read back
+// through a BufMgr too small to hold them so that every read is a miss.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/stat.h>
+
+#include "buffer.h"
+#include "exceptions/file_not_found_exception.h"
+#include "file.h"
+#include "page.h"
+
+using namespace badgerdb;
+
+namespace {
+
+void run(const bool compress, const int num_pages, const int fill_percent) {
+  const std::string filename = "compression_bench.db";
+  try {
+    File::remove(filename);
+  } catch (FileNotFoundException&) {
+  }
+
+  {
+    File file = File::create(filename);
+    file.setCompression(compress);
+    std::srand(42);
+
+    BufMgr writer(64);
+    const auto write_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_pages; ++i) {
+      PageId page_number;
+      Page* page;
+      writer.allocPage(&file, page_number, page);
+      while (page->getFreeSpace() >
+             Page::DATA_SIZE * (100 - fill_percent) / 100 + 200) {
+        char record[128];
+        std::snprintf(record, sizeof(record),
+                      "order %08d customer %06d status %s amount %7.2f",
+                      std::rand() % 100000000, std::rand() % 1000000,
+                      std::rand() % 2 ? "SHIPPED" : "PENDING",
+                      (std::rand() % 100000) / 100.0);
+        page->insertRecord(record);
+      }
+      writer.unPinPage(&file, page_number, true);
+    }
+    writer.flushFile(&file);
+    const double write_seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - write_start).count();
+    const std::uint64_t written = file.bytesWritten();
+
+    BufMgr reader(16);
+    const std::uint64_t read_before = file.bytesRead();
+    const auto read_start = std::chrono::steady_clock::now();
+    for (PageId page_number = 1; page_number <= (PageId)num_pages;
+         ++page_number) {
+      Page* page;
+      reader.readPage(&file, page_number, page);
+      reader.unPinPage(&file, page_number, false);
+    }
+    const double read_seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - read_start).count();
+    const std::uint64_t read = file.bytesRead() - read_before;
+    reader.flushFile(&file);
+
+    struct stat st;
+    ::stat(filename.c_str(), &st);
+    std::printf("compression %-3s disk %8.1f KB  written %8.1f KB  "
+                "read %8.1f KB  write %6.3f s  read %6.3f s\n",
+                compress ? "on" : "off", st.st_blocks * 512 / 1024.0,
+                written / 1024.0, read / 1024.0, write_seconds, read_seconds);
+  }
+  File::remove(filename);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  const int num_pages = argc > 1 ? std::atoi(argv[1]) : 2000;
+  const int fill_percent = argc > 2 ? std::atoi(argv[2]) : 50;
+  run(false, num_pages, fill_percent);
+  run(true, num_pages, fill_percent);
+  return 0;
+}
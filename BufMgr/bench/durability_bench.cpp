@@ -0,0 +1,87 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+// Measures page write throughput of File under each durability mode.
+//
+// Usage: durability_bench [pages] [sync_every]
+//
+// A file of <pages> pages is written in random page order; sync() is called
+// after every <sync_every> writes, which is what a group commit or checkpoint
+// would do.  DURABILITY_FSYNC_PER_WRITE ignores <sync_every>.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "exceptions/file_not_found_exception.h"
+#include "file.h"
+#include "page.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const char* modeName(const DurabilityMode mode) {
+  switch (mode) {
+    case DURABILITY_NONE: return "none";
+    case DURABILITY_FLUSH_ON_SYNC: return "flush-on-sync";
+    case DURABILITY_FDATASYNC_ON_SYNC: return "fdatasync-on-sync";
+    case DURABILITY_FSYNC_PER_WRITE: return "fsync-per-write";
+  }
+  return "?";
+}
+
+void run(const DurabilityMode mode, const int num_pages, const int sync_every) {
+  const std::string filename = "durability_bench.db";
+  try {
+    File::remove(filename);
+  } catch (FileNotFoundException&) {
+  }
+
+  {
+    File file = File::create(filename);
+    std::vector<Page> pages;
+    for (int i = 0; i < num_pages; ++i) {
+      pages.push_back(file.allocatePage());
+      pages.back().insertRecord(std::string(2000, 'x'));
+    }
+    file.sync();
+    file.setDurability(mode);
+
+    std::srand(42);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_pages; ++i) {
+      file.writePage(pages[std::rand() % num_pages]);
+      if ((i + 1) % sync_every == 0) {
+        file.sync();
+      }
+    }
+    file.sync();
+    const double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-18s %8d writes %10.3f s %12.0f pages/s\n", modeName(mode),
+                num_pages, seconds, num_pages / seconds);
+  }
+  File::remove(filename);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  const int num_pages = argc > 1 ? std::atoi(argv[1]) : 2000;
+  const int sync_every = argc > 2 ? std::atoi(argv[2]) : 64;
+
+  run(DURABILITY_NONE, num_pages, sync_every);
+  run(DURABILITY_FLUSH_ON_SYNC, num_pages, sync_every);
+  run(DURABILITY_FDATASYNC_ON_SYNC, num_pages, sync_every);
+  run(DURABILITY_FSYNC_PER_WRITE, num_pages, sync_every);
+  return 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+// Compares the cost of a buffer pool hit for the specializations of BufMgrT.
+//
+// Usage: latching_bench [pages] [accesses] [threads]
+//
+// All <pages> pages of a file stay resident, and each access pins and unpins
+// one of them, so only the page table, the replacement policy hooks and the
+// latch are measured.  The pool with AtomicLatching is also shared by
+// <threads> threads, each making <accesses> accesses.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "buffer.h"
+#include "buffer_traits.h"
+#include "exceptions/file_not_found_exception.h"
+#include "file.h"
+#include "midpoint_lru.h"
+#include "page.h"
+
+using namespace badgerdb;
+
+namespace {
+
+template <class Manager>
+void access(Manager* buf_mgr, File* file, const std::vector<PageId>& sequence) {
+  for (std::size_t i = 0; i < sequence.size(); ++i) {
+    Page* page;
+    buf_mgr->readPage(file, sequence[i], page);
+    buf_mgr->unPinPage(file, sequence[i], false /* dirty */);
+  }
+}
+
+template <class Manager>
+void run(const char* name, Manager* buf_mgr, File* file, const int num_pages,
+         const std::vector<PageId>& sequence, const int threads) {
+  for (PageId page_number = 1; page_number <= PageId(num_pages);
+       ++page_number) {
+    Page* page;
+    buf_mgr->readPage(file, page_number, page);
+    buf_mgr->unPinPage(file, page_number, false /* dirty */);
+  }
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int t = 1; t < threads; ++t) {
+    workers.push_back(std::thread([&] { access(buf_mgr, file, sequence); }));
+  }
+  access(buf_mgr, file, sequence);
+  for (std::size_t t = 0; t < workers.size(); ++t) {
+    workers[t].join();
+  }
+  const double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  std::printf("%-34s %2d thread(s)  %8.1f ns/access\n", name, threads,
+              seconds * 1e9 / (sequence.size() * threads));
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  const int num_pages = argc > 1 ? std::atoi(argv[1]) : 1000;
+  const std::size_t accesses = argc > 2 ? std::atol(argv[2]) : 2000000;
+  const int threads = argc > 3 ? std::atoi(argv[3]) : 4;
+  const std::string filename = "latching_bench.db";
+  try {
+    File::remove(filename);
+  } catch (FileNotFoundException&) {
+  }
+
+  {
+    File file = File::create(filename);
+    for (int i = 0; i < num_pages; ++i) {
+      Page page = file.allocatePage();
+      file.writePage(page);
+    }
+
+    std::vector<PageId> sequence;
+    std::mt19937 rng(42);
+    for (std::size_t i = 0; i < accesses; ++i) {
+      sequence.push_back(1 + rng() % num_pages);
+    }
+
+    {
+      BufMgrT<> buf_mgr(num_pages);
+      run("clock, no latching", &buf_mgr, &file, num_pages, sequence, 1);
+    }
+    {
+      BufMgr buf_mgr(num_pages);
+      run("BufMgr, no policy set", &buf_mgr, &file, num_pages, sequence, 1);
+    }
+    {
+      BufMgr buf_mgr(num_pages);
+      MidpointLru midpoint(37, std::chrono::milliseconds(1));
+      buf_mgr.setReplacementPolicy(&midpoint);
+      run("BufMgr, midpoint lru", &buf_mgr, &file, num_pages, sequence, 1);
+      buf_mgr.setReplacementPolicy(NULL);
+    }
+    {
+      BufMgrT<ClockPolicy, BufHashTbl, AtomicLatching> buf_mgr(num_pages);
+      run("clock, atomic latching", &buf_mgr, &file, num_pages, sequence, 1);
+    }
+    if (threads > 1) {
+      BufMgrT<ClockPolicy, BufHashTbl, AtomicLatching> buf_mgr(num_pages);
+      run("clock, atomic latching", &buf_mgr, &file, num_pages, sequence,
+          threads);
+    }
+  }
+  File::remove(filename);
+  return 0;
+}
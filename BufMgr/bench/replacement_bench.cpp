@@ -0,0 +1,103 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+// Compares the hit ratio and the cost per access of the replacement
+// policies.
+//
+// Usage: replacement_bench [pages] [frames] [accesses]
+//
+// A file of <pages> pages is accessed <accesses> times through a pool of
+// <frames> frames.  Most accesses follow a skewed distribution over the file;
+// every so often a scan reads a run of pages once.  The same sequence is
+// replayed with the clock, midpoint-insertion LRU and sampled LRU and LFU.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "exceptions/file_not_found_exception.h"
+#include "file.h"
+#include "midpoint_lru.h"
+#include "page.h"
+#include "replacement_policy.h"
+#include "sampled_eviction.h"
+
+using namespace badgerdb;
+
+namespace {
+
+void run(const char* name, ReplacementPolicy* policy, File* file,
+         const std::uint32_t frames, const std::vector<PageId>& sequence) {
+  BufMgr buf_mgr(frames);
+  buf_mgr.setReplacementPolicy(policy);
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < sequence.size(); ++i) {
+    Page* page;
+    buf_mgr.readPage(file, sequence[i], page);
+    buf_mgr.unPinPage(file, sequence[i], false /* dirty */);
+  }
+  const double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  const TenantStats& stats = buf_mgr.getTenantStats(0);
+  std::printf("%-14s hit ratio %6.2f%%  %8.1f ns/access\n", name,
+              100.0 * stats.hits / (stats.hits + stats.misses),
+              seconds * 1e9 / sequence.size());
+  buf_mgr.setReplacementPolicy(NULL);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  const int num_pages = argc > 1 ? std::atoi(argv[1]) : 8192;
+  const std::uint32_t num_frames = argc > 2 ? std::atoi(argv[2]) : 1024;
+  const std::size_t accesses = argc > 3 ? std::atol(argv[3]) : 500000;
+  const std::string filename = "replacement_bench.db";
+  try {
+    File::remove(filename);
+  } catch (FileNotFoundException&) {
+  }
+
+  {
+    File file = File::create(filename);
+    for (int i = 0; i < num_pages; ++i) {
+      Page page = file.allocatePage();
+      file.writePage(page);
+    }
+
+    // Skewed accesses: page ~ num_pages * u^4, plus a scan of 2 * frames
+    // pages after every 50000 accesses.
+    std::vector<PageId> sequence;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    while (sequence.size() < accesses) {
+      if (sequence.size() % 50000 == 49999) {
+        const PageId first = 1 + rng() % num_pages;
+        for (std::uint32_t i = 0; i < 2 * num_frames; ++i) {
+          sequence.push_back(1 + (first + i) % num_pages);
+        }
+      } else {
+        sequence.push_back(1 + static_cast<PageId>(
+            num_pages * std::pow(unit(rng), 4.0)) % num_pages);
+      }
+    }
+
+    run("clock", NULL, &file, num_frames, sequence);
+    MidpointLru midpoint(37, std::chrono::milliseconds(1));
+    run("midpoint lru", &midpoint, &file, num_frames, sequence);
+    SampledEviction sampled_lru(SampledEviction::LRU, 5, 16);
+    run("sampled lru", &sampled_lru, &file, num_frames, sequence);
+    SampledEviction sampled_lfu(SampledEviction::LFU, 5, 16);
+    run("sampled lfu", &sampled_lfu, &file, num_frames, sequence);
+  }
+  File::remove(filename);
+  return 0;
+}
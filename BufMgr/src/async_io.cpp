@@ -0,0 +1,290 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "async_io.h"
+
+#include <cerrno>
+#include <sys/uio.h>
+
+#include "exceptions/buffer_exceeded_exception.h"
+#include "exceptions/file_io_exception.h"
+#include "exceptions/invalid_page_exception.h"
+
+namespace badgerdb {
+
+void Task::FinalAwaiter::await_suspend(
+    std::coroutine_handle<promise_type> handle) noexcept {
+  handle.promise().loop()->finish(handle);
+}
+
+PageGuard::PageGuard(PageGuard&& other) noexcept
+    : buf_mgr_(other.buf_mgr_),
+      file_(other.file_),
+      page_number_(other.page_number_),
+      page_(other.page_),
+      dirty_(other.dirty_) {
+  other.page_ = NULL;
+}
+
+PageGuard& PageGuard::operator=(PageGuard&& other) noexcept {
+  if (this != &other) {
+    release();
+    buf_mgr_ = other.buf_mgr_;
+    file_ = other.file_;
+    page_number_ = other.page_number_;
+    page_ = other.page_;
+    dirty_ = other.dirty_;
+    other.page_ = NULL;
+  }
+  return *this;
+}
+
+void PageGuard::release() {
+  if (page_ != NULL) {
+    page_ = NULL;
+    buf_mgr_->unPinPage(file_, page_number_, dirty_);
+  }
+}
+
+bool ReadPageAwaiter::await_ready() {
+  return buf_mgr_->pinIfResident(file_, page_number_, page_);
+}
+
+void ReadPageAwaiter::await_suspend(
+    std::coroutine_handle<Task::promise_type> handle) {
+  handle_ = handle;
+  handle.promise().loop()->submit(this);
+}
+
+PageGuard ReadPageAwaiter::await_resume() {
+  if (exception_) {
+    std::rethrow_exception(exception_);
+  }
+  return PageGuard(buf_mgr_, file_, page_number_, page_);
+}
+
+EventLoop::EventLoop(const std::uint32_t io_threads)
+    : live_tasks_(0),
+      reads_issued_(0),
+      reads_shared_(0),
+      reads_delayed_(0),
+      max_in_flight_(0),
+      stopping_(false) {
+  for (std::uint32_t i = 0; i < io_threads; ++i) {
+    io_threads_.push_back(std::thread(&EventLoop::serveReads, this));
+  }
+}
+
+EventLoop::~EventLoop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  has_work_.notify_all();
+  for (std::size_t i = 0; i < io_threads_.size(); ++i) {
+    io_threads_[i].join();
+  }
+  // Only tasks that never ran can be left; they hold no pins.
+  while (!ready_.empty()) {
+    ready_.front().destroy();
+    ready_.pop_front();
+  }
+}
+
+void EventLoop::spawn(Task task) {
+  task.handle_.promise().loop_ = this;
+  ready_.push_back(task.handle_);
+  task.handle_ = NULL;
+  ++live_tasks_;
+}
+
+void EventLoop::run() {
+  while (live_tasks_ > 0) {
+    while (!ready_.empty()) {
+      std::coroutine_handle<> handle = ready_.front();
+      ready_.pop_front();
+      handle.resume();
+    }
+    retryDelayed();
+    if (!ready_.empty()) {
+      continue;
+    }
+    if (pending_.empty()) {
+      break;
+    }
+
+    std::vector<PendingRead*> done;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      has_completions_.wait(lock, [this] { return !completed_.empty(); });
+      done.swap(completed_);
+    }
+    for (std::size_t i = 0; i < done.size(); ++i) {
+      complete(done[i]);
+    }
+  }
+
+  if (exception_) {
+    std::exception_ptr exception = exception_;
+    exception_ = NULL;
+    std::rethrow_exception(exception);
+  }
+}
+
+void EventLoop::submit(ReadPageAwaiter* waiter) {
+  if (delayed_.empty() && startRead(waiter)) {
+    return;
+  }
+  delayed_.push_back(waiter);
+  ++reads_delayed_;
+}
+
+bool EventLoop::startRead(ReadPageAwaiter* waiter) {
+  const ReadKey key(waiter->buf_mgr_,
+                    std::make_pair(waiter->file_, waiter->page_number_));
+  std::map<ReadKey, std::unique_ptr<PendingRead> >::iterator iter =
+      pending_.find(key);
+  if (iter != pending_.end()) {
+    iter->second->waiters.push_back(waiter);
+    ++reads_shared_;
+    return true;
+  }
+
+  FrameId frame;
+  try {
+    frame = waiter->buf_mgr_->reserveFrame(waiter->file_, waiter->page_number_);
+  } catch (BufferExceededException&) {
+    // Every frame is pinned; a read in flight will free one when its
+    // coroutines finish.  Without one the pool is simply too small.
+    if (pending_.empty()) {
+      throw;
+    }
+    return false;
+  }
+
+  std::unique_ptr<PendingRead> read(new PendingRead);
+  read->buf_mgr = waiter->buf_mgr_;
+  read->file = waiter->file_;
+  read->page_number = waiter->page_number_;
+  read->frame = frame;
+  // Pages written through the stream must reach the descriptor first.
+  read->fd = waiter->file_->descriptor();
+  waiter->file_->stream_->flush();
+  read->result = 0;
+  read->error = 0;
+  read->waiters.push_back(waiter);
+
+  PendingRead* submitted = read.get();
+  pending_[key] = std::move(read);
+  ++reads_issued_;
+  if (pending_.size() > max_in_flight_) {
+    max_in_flight_ = pending_.size();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    submitted_.push_back(submitted);
+  }
+  has_work_.notify_one();
+  return true;
+}
+
+void EventLoop::retryDelayed() {
+  while (!delayed_.empty()) {
+    ReadPageAwaiter* waiter = delayed_.front();
+    try {
+      if (waiter->buf_mgr_->pinIfResident(waiter->file_, waiter->page_number_,
+                                          waiter->page_)) {
+        ready_.push_back(waiter->handle_);
+      } else if (!startRead(waiter)) {
+        return;
+      }
+    } catch (...) {
+      waiter->exception_ = std::current_exception();
+      ready_.push_back(waiter->handle_);
+    }
+    delayed_.pop_front();
+  }
+}
+
+void EventLoop::complete(PendingRead* read) {
+  const ReadKey key(read->buf_mgr,
+                    std::make_pair(read->file, read->page_number));
+  std::unique_ptr<PendingRead> owned = std::move(pending_[key]);
+  pending_.erase(key);
+
+  Page* page = NULL;
+  std::exception_ptr exception;
+  try {
+    if (read->result < 0) {
+      throw FileIOException(read->file->filename(), "preadv", read->error);
+    }
+    // A compressed page stores only its header and compressed bytes, so the
+    // last page of a compressed file may end before its slot does.
+    const PageHeader& header = read->buf_mgr->bufPool[read->frame].header_;
+    const std::size_t stored = header.stored_length == 0
+        ? Page::SIZE : sizeof(header) + header.stored_length;
+    if (read->result < static_cast<ssize_t>(sizeof(header)) ||
+        static_cast<std::size_t>(read->result) < stored) {
+      // The page lies beyond the end of the file.
+      throw InvalidPageException(read->page_number, read->file->filename());
+    }
+    read->file->finishRead(read->buf_mgr->bufPool[read->frame],
+                           read->page_number, false /* allow_free */);
+    page = read->buf_mgr->installFrame(read->frame, read->waiters.size());
+  } catch (...) {
+    exception = std::current_exception();
+    read->buf_mgr->releaseFrame(read->frame);
+  }
+
+  for (std::size_t i = 0; i < read->waiters.size(); ++i) {
+    ReadPageAwaiter* waiter = read->waiters[i];
+    waiter->page_ = page;
+    waiter->exception_ = exception;
+    ready_.push_back(waiter->handle_);
+  }
+}
+
+void EventLoop::finish(std::coroutine_handle<Task::promise_type> handle) {
+  if (handle.promise().exception_ && !exception_) {
+    exception_ = handle.promise().exception_;
+  }
+  handle.destroy();
+  --live_tasks_;
+}
+
+void EventLoop::serveReads() {
+  while (true) {
+    PendingRead* read;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      has_work_.wait(lock, [this] { return stopping_ || !submitted_.empty(); });
+      if (submitted_.empty()) {
+        return;
+      }
+      read = submitted_.front();
+      submitted_.pop_front();
+    }
+
+    Page& page = read->buf_mgr->bufPool[read->frame];
+    struct iovec iov[2];
+    iov[0].iov_base = &page.header_;
+    iov[0].iov_len = sizeof(page.header_);
+    iov[1].iov_base = &page.data_[0];
+    iov[1].iov_len = Page::DATA_SIZE;
+    read->result = ::preadv(read->fd, iov, 2,
+                            File::pagePosition(read->page_number));
+    read->error = errno;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      completed_.push_back(read);
+    }
+    has_completions_.notify_one();
+  }
+}
+
+}
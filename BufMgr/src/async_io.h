@@ -0,0 +1,384 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sys/types.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+class EventLoop;
+
+/**
+ * @brief Coroutine run by an EventLoop.
+ *
+ * A function returning Task may co_await BufMgr::readPageAsync().  Calling it
+ * only creates the coroutine; it starts running once it is handed to
+ * EventLoop::spawn(), which owns it from then on and destroys it when it
+ * finishes.
+ */
+class Task {
+ public:
+  class promise_type;
+
+  /**
+   * Suspends a finished coroutine and hands it back to its loop.
+   */
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+    void await_resume() const noexcept {}
+  };
+
+  /**
+   * Promise of a Task coroutine.
+   */
+  class promise_type {
+   public:
+    Task get_return_object() {
+      return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void return_void() const {}
+    void unhandled_exception() { exception_ = std::current_exception(); }
+
+    /**
+     * Returns the loop running the coroutine.
+     */
+    EventLoop* loop() const { return loop_; }
+
+   private:
+    friend class EventLoop;
+
+    EventLoop* loop_ = NULL;
+    std::exception_ptr exception_;
+  };
+
+  Task(Task&& other) noexcept : handle_(other.handle_) {
+    other.handle_ = NULL;
+  }
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  /**
+   * Destroys the coroutine if it was never spawned.
+   */
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+
+ private:
+  friend class EventLoop;
+
+  explicit Task(std::coroutine_handle<promise_type> handle)
+      : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+/**
+ * @brief Pin on a buffer pool page that is released when the guard goes out
+ *        of scope.
+ */
+class PageGuard {
+ public:
+  /**
+   * Constructs an empty guard.
+   */
+  PageGuard()
+      : buf_mgr_(NULL), file_(NULL), page_number_(Page::INVALID_NUMBER),
+        page_(NULL), dirty_(false) {}
+
+  /**
+   * Takes over one pin of a page.
+   *
+   * @param buf_mgr     Buffer manager holding the page.
+   * @param file        File of the page.
+   * @param page_number Number of the page.
+   * @param page        Frame holding the page.
+   */
+  PageGuard(BufMgr* buf_mgr, File* file, const PageId page_number, Page* page)
+      : buf_mgr_(buf_mgr), file_(file), page_number_(page_number),
+        page_(page), dirty_(false) {}
+
+  PageGuard(PageGuard&& other) noexcept;
+  PageGuard& operator=(PageGuard&& other) noexcept;
+  PageGuard(const PageGuard&) = delete;
+  PageGuard& operator=(const PageGuard&) = delete;
+
+  /**
+   * Unpins the page.
+   */
+  ~PageGuard() { release(); }
+
+  /**
+   * Unpins the page now, marking it dirty if markDirty() was called.  Does
+   * nothing if the guard is empty.
+   */
+  void release();
+
+  /**
+   * Makes release() mark the page dirty.
+   */
+  void markDirty() { dirty_ = true; }
+
+  /**
+   * Returns the pinned page, or NULL if the guard is empty.
+   */
+  Page* get() const { return page_; }
+  Page* operator->() const { return page_; }
+  Page& operator*() const { return *page_; }
+
+  /**
+   * Returns the number of the pinned page.
+   */
+  PageId page_number() const { return page_number_; }
+
+ private:
+  BufMgr* buf_mgr_;
+  File* file_;
+  PageId page_number_;
+  Page* page_;
+  bool dirty_;
+};
+
+/**
+ * @brief Awaitable returned by BufMgr::readPageAsync().
+ */
+class ReadPageAwaiter {
+ public:
+  ReadPageAwaiter(BufMgr* buf_mgr, File* file, const PageId page_number)
+      : buf_mgr_(buf_mgr), file_(file), page_number_(page_number),
+        page_(NULL) {}
+
+  /**
+   * Pins the page right away if it is resident.
+   */
+  bool await_ready();
+
+  /**
+   * Queues the read of a missing page on the loop running <handle>, or joins
+   * a read of the same page that is already in flight.
+   *
+   * @throws  BufferExceededException If all frames are pinned and no read is
+   *                                  in flight.
+   */
+  void await_suspend(std::coroutine_handle<Task::promise_type> handle);
+
+  /**
+   * Returns a guard on the pinned page.
+   *
+   * @throws  InvalidPageException  If the page does not exist.
+   * @throws  FileIOException       If the read failed.
+   * @throws  ChecksumMismatchException  If the page is corrupt.
+   */
+  PageGuard await_resume();
+
+ private:
+  friend class EventLoop;
+
+  BufMgr* buf_mgr_;
+  File* file_;
+  PageId page_number_;
+  Page* page_;
+  std::coroutine_handle<> handle_;
+  std::exception_ptr exception_;
+};
+
+/**
+ * @brief Runs Task coroutines on the calling thread and performs their page
+ *        reads on a pool of I/O threads.
+ *
+ * BufMgr is not threadsafe, so only the thread inside run() touches it: it
+ * resumes coroutines, pins resident pages, reserves frames for misses and
+ * installs pages once they have been read.  The I/O threads do nothing but
+ * preadv() a page slot directly into its reserved frame, so with N I/O
+ * threads up to N misses are served by the disk at the same time while any
+ * number of coroutines wait for them.  Decompression and checksum
+ * verification happen on the loop thread when the read completes.
+ *
+ * A miss that finds every frame pinned waits until a read in flight has
+ * completed and its coroutines have released their pins, so far more
+ * coroutines than frames can be active at once.  Only when no read is in
+ * flight to free a frame does the request fail with BufferExceededException.
+ * Write-backs of evicted dirty pages stay synchronous on the loop thread.
+ */
+class EventLoop {
+ public:
+  /**
+   * Starts the I/O threads.
+   *
+   * @param io_threads  Number of reads that may be in progress at once.
+   */
+  explicit EventLoop(const std::uint32_t io_threads);
+
+  /**
+   * Stops the I/O threads.  Spawned tasks that did not run are destroyed.
+   */
+  ~EventLoop();
+
+  /**
+   * Schedules a task.  It starts at the next run().
+   *
+   * @param task  Task to run.
+   */
+  void spawn(Task task);
+
+  /**
+   * Runs until every spawned task has finished.
+   *
+   * @throws  The first exception that escaped a task, once all tasks are done.
+   */
+  void run();
+
+  /**
+   * Returns the number of page reads submitted to the I/O threads.
+   */
+  std::uint64_t readsIssued() const { return reads_issued_; }
+
+  /**
+   * Returns the number of requests that joined a read already in flight.
+   */
+  std::uint64_t readsShared() const { return reads_shared_; }
+
+  /**
+   * Returns the number of requests that had to wait for a free frame.
+   */
+  std::uint64_t readsDelayed() const { return reads_delayed_; }
+
+  /**
+   * Returns the largest number of reads that were in flight at once.
+   */
+  std::size_t maxInFlight() const { return max_in_flight_; }
+
+ private:
+  friend class ReadPageAwaiter;
+  friend struct Task::FinalAwaiter;
+
+  /**
+   * A miss being read into a reserved frame.
+   */
+  struct PendingRead {
+    BufMgr* buf_mgr;
+    File* file;
+    PageId page_number;
+    FrameId frame;
+    int fd;
+    ssize_t result;
+    int error;
+    std::vector<ReadPageAwaiter*> waiters;
+  };
+
+  typedef std::pair<const BufMgr*, std::pair<const File*, PageId> > ReadKey;
+
+  /**
+   * Starts the request of <waiter>, or queues it behind earlier requests
+   * still waiting for a frame.
+   */
+  void submit(ReadPageAwaiter* waiter);
+
+  /**
+   * Attaches <waiter> to a read of its page, submitting one if none is in
+   * flight.
+   *
+   * @return  False if no frame is free for the read yet.
+   * @throws  BufferExceededException If no frame is free and no read is in
+   *                                  flight.
+   */
+  bool startRead(ReadPageAwaiter* waiter);
+
+  /**
+   * Starts delayed requests in order for as long as frames are available.
+   */
+  void retryDelayed();
+
+  /**
+   * Installs the page of a finished read and makes its waiters ready.
+   */
+  void complete(PendingRead* read);
+
+  /**
+   * Destroys a finished task, keeping its exception for run().
+   */
+  void finish(std::coroutine_handle<Task::promise_type> handle);
+
+  /**
+   * Body of an I/O thread.
+   */
+  void serveReads();
+
+  /**
+   * Coroutines ready to be resumed.  Loop thread only.
+   */
+  std::deque<std::coroutine_handle<> > ready_;
+
+  /**
+   * Requests waiting for a free frame, oldest first.  Loop thread only.
+   */
+  std::deque<ReadPageAwaiter*> delayed_;
+
+  /**
+   * Reads in flight by page.  Loop thread only.
+   */
+  std::map<ReadKey, std::unique_ptr<PendingRead> > pending_;
+
+  /**
+   * Number of spawned tasks that have not finished.
+   */
+  std::size_t live_tasks_;
+
+  /**
+   * First exception that escaped a task.
+   */
+  std::exception_ptr exception_;
+
+  std::uint64_t reads_issued_;
+  std::uint64_t reads_shared_;
+  std::uint64_t reads_delayed_;
+  std::size_t max_in_flight_;
+
+  /**
+   * Protects <submitted_>, <completed_> and <stopping_>.
+   */
+  std::mutex mutex_;
+
+  /**
+   * Signalled when a read is submitted or the loop is stopping.
+   */
+  std::condition_variable has_work_;
+
+  /**
+   * Signalled when a read completes.
+   */
+  std::condition_variable has_completions_;
+
+  std::deque<PendingRead*> submitted_;
+  std::vector<PendingRead*> completed_;
+  bool stopping_;
+
+  std::vector<std::thread> io_threads_;
+};
+
+}
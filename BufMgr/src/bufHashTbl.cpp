@@ -83,6 +83,56 @@ void BufHashTbl::lookup(const File* file, const PageId pageNo, FrameId &frameNo)
   throw HashNotFoundException(file->filename(), pageNo);
 }
 
+std::size_t BufHashTbl::lookupBatch(const File* file, const PageId* pageNos,
+                                    const std::size_t count, FrameId* frameNos, bool* found)
+{
+  std::size_t hits = 0;
+  int index[MAX_BATCH];
+  hashBucket* cursor[MAX_BATCH];
+  for (std::size_t first = 0; first < count; first += MAX_BATCH) {
+    std::size_t n = count - first;
+    if (n > MAX_BATCH)
+      n = MAX_BATCH;
+
+    // Hash every key and prefetch its slot of the bucket array.
+    for (std::size_t i = 0; i < n; i++) {
+      index[i] = hash(file, pageNos[first + i]);
+      __builtin_prefetch(&ht[index[i]]);
+    }
+    // Load the chain heads and prefetch the first buckets.
+    for (std::size_t i = 0; i < n; i++) {
+      found[first + i] = false;
+      cursor[i] = ht[index[i]];
+      if (cursor[i])
+        __builtin_prefetch(cursor[i]);
+    }
+    // Advance every unfinished lookup by one bucket per round, prefetching
+    // the bucket it will look at in the next round.
+    std::size_t active = n;
+    while (active > 0) {
+      active = 0;
+      for (std::size_t i = 0; i < n; i++) {
+        hashBucket* tmpBuc = cursor[i];
+        if (!tmpBuc)
+          continue;
+        if (tmpBuc->file == file && tmpBuc->pageNo == pageNos[first + i]) {
+          frameNos[first + i] = tmpBuc->frameNo;
+          found[first + i] = true;
+          hits++;
+          cursor[i] = NULL;
+        } else {
+          cursor[i] = tmpBuc->next;
+          if (cursor[i]) {
+            __builtin_prefetch(cursor[i]);
+            active++;
+          }
+        }
+      }
+    }
+  }
+  return hits;
+}
+
 void BufHashTbl::remove(const File* file, const PageId pageNo) {
 
   int index = hash(file, pageNo);
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <cstddef>
+
 #include "file.h"
 
 namespace badgerdb {
@@ -65,6 +67,11 @@ class BufHashTbl
 
  public:
 	/**
+	 * Number of lookups lookupBatch() interleaves at a time
+	 */
+  static constexpr std::size_t MAX_BATCH = 64;
+
+	/**
    * Constructor of BufHashTbl class
 	 */
 	BufHashTbl(const int htSize);  // constructor
@@ -96,6 +103,22 @@ class BufHashTbl
 	 */
   void lookup(const File* file, const PageId pageNo, FrameId &frameNo);
 
+	/**
+   * Looks up several pages of a file at once.  Instead of walking one chain to its end before
+   * starting the next, the lookups advance in lockstep one bucket at a time (group prefetching):
+   * every round first prefetches the next bucket of each unfinished lookup, so the cache misses
+   * of up to MAX_BATCH independent chains overlap instead of being paid one after another.
+	 *
+	 * @param file  	File object
+	 * @param pageNos	Page numbers in the file
+	 * @param count 	Number of pages to look up
+	 * @param frameNos Receives the frame of every page that was found
+	 * @param found 	Receives for every page whether it is in the hash table
+	 * @return  			Number of pages found
+	 */
+  std::size_t lookupBatch(const File* file, const PageId* pageNos, const std::size_t count,
+                          FrameId* frameNos, bool* found);
+
 	/**
    * Delete entry (file,pageNo) from hash table.
 	 *
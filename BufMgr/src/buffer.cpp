@@ -5,10 +5,24 @@
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
 
+#include <algorithm>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <iostream>
+#include <sched.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "buffer.h"
+#include "async_io.h"
+#include "double_write_buffer.h"
+#include "log_manager.h"
+#include "replacement_policy.h"
+#include "tiny_lfu.h"
+#include "shared_page_cache.h"
 #include "exceptions/buffer_exceeded_exception.h"
+#include "exceptions/invalid_quota_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
 #include "exceptions/bad_buffer_exception.h"
@@ -16,8 +30,24 @@
 
 namespace badgerdb {
 
-BufMgr::BufMgr(std::uint32_t bufs)
-	: numBufs(bufs) {
+namespace {
+
+//机器上是否至少有nodes个NUMA节点。
+bool haveNumaNodes(std::uint32_t nodes)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%u", nodes - 1);
+    struct stat info;
+    return stat(path, &info) == 0;
+}
+
+}
+
+thread_local int bufMgrThreadNode = -1;
+
+template <class Policy, class PageTable, class Latching>
+BufMgrT<Policy, PageTable, Latching>::BufMgrT(std::uint32_t bufs, std::uint32_t numaNodes, const Policy& replacementPolicy)
+	: numBufs(bufs), logManager(NULL), doubleWriteBuffer(NULL), sharedCache(NULL), policy(replacementPolicy), admission(NULL) {
 	bufDescTable = new BufDesc[bufs];
 
   for (FrameId i = 0; i < bufs; i++) 
@@ -26,41 +56,183 @@ BufMgr::BufMgr(std::uint32_t bufs)
   	bufDescTable[i].valid = false;
   }
 
-  bufPool = new Page[bufs];
-
 	int htsize = ((((int) (bufs * 1.2))*2)/2)+1;
-  hashTable = new BufHashTbl (htsize);  // allocate the buffer hash table
+  hashTable = new PageTable (htsize);  // allocate the buffer hash table
+
+  // split the frames into partitions of equal size, each with its own clock
+  numPartitions = std::max(1u, std::min(numaNodes, std::min(bufs, 64u)));
+  partitionSize = (bufs + numPartitions - 1) / numPartitions;
+  numPartitions = (bufs + partitionSize - 1) / partitionSize;
+  for (std::uint32_t p = 0; p < numPartitions; p++)
+    clockHands.push_back(std::min(bufs, (p + 1) * partitionSize) - 1);
+
+  // the pages of each partition live in their own region, bound to its node
+  partitionsBound = numPartitions > 1 && haveNumaNodes(numPartitions);
+  allocatePartitions();
 
-  clockHand = bufs - 1;
+  TenantStats defaultTenant = {"default", 0, bufs, 0, 0, 0};
+  tenants.push_back(defaultTenant);
 }
 
 //BufMgr类的析构函数。将缓冲池中所有脏页写回磁盘，然后释放缓冲池、BufDesc表和哈希表占用的
 //内存。
 // BufMgr 类的析构函数，用于释放缓冲池管理器的资源
-BufMgr::~BufMgr() {
+template <class Policy, class PageTable, class Latching>
+BufMgrT<Policy, PageTable, Latching>::~BufMgrT() {
     // 遍历缓冲池中的每一页
     for (FrameId i = 0; i < numBufs; i++) {
         // 检查当前页是否被修改过（dirty标志）
         if (bufDescTable[i].dirty) {
             // 如果页被修改过，则将修改后的内容写回到对应的文件中
-            bufDescTable[i].file->writePage(bufPool[i]);
+            writeBack(i);
             bufDescTable[i].dirty = false; // 将dirty标志重置为false，表示页已经写回
         }
     }
+    finishWriteBack();
     // 释放缓冲池哈希表的内存空间
     delete hashTable;
     // 释放缓冲描述符表的内存空间
     delete[] bufDescTable;
-    // 释放缓冲池的内存空间
-    delete[] bufPool;
+    // 释放缓冲池的内存空间，页框的页面数据归还所在分区后再释放各分区的内存
+    for (FrameId i = 0; i < numBufs; i++) {
+        bufPool[i].~Page();
+    }
+    ::operator delete(bufPool);
+    for (std::uint32_t p = 0; p < arenas.size(); p++) {
+        delete arenas[p];
+    }
+}
+
+
+
+//顺时针旋转分区partition的时钟表针，将其指向该分区中下一个页框。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::advanceClock(std::uint32_t partition)
+{
+    const FrameId first = partition * partitionSize;
+    const FrameId end = std::min(numBufs, first + partitionSize);
+    clockHands[partition]++;
+    if (clockHands[partition] == end) {
+        clockHands[partition] = first;
+    }
+}
+
+
+
+//为每个分区映射一段按内存页对齐的区域存放其页框的页面数据。分区对应真实NUMA节点时，区域在
+//首次写入前绑定到该节点，否则由首次写入的线程所在节点决定位置。页框在构造时写入页面数据，物理页
+//随之分配；绑定失败时保持原样，只影响性能。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::allocatePartitions()
+{
+    bufPool = static_cast<Page*>(::operator new(numBufs * sizeof(Page)));
+    bool bound = partitionsBound;
+    for (std::uint32_t p = 0; p < numPartitions; p++) {
+        const FrameId first = p * partitionSize;
+        const FrameId end = std::min(numBufs, first + partitionSize);
+        arenas.push_back(new FrameArena(end - first, Page::SIZE, partitionsBound ? (int)p : -1));
+        bound = bound && arenas[p]->bound();
+        for (FrameId i = first; i < end; i++) {
+            new (&bufPool[i]) Page(arenas[p]);
+        }
+    }
+    partitionsBound = bound;
+}
+
+
+
+//调用线程所在NUMA节点对应的分区。模拟分区时由setThreadNode()决定，默认为分区0。
+template <class Policy, class PageTable, class Latching>
+std::uint32_t BufMgrT<Policy, PageTable, Latching>::currentPartition() const
+{
+    if (numPartitions == 1) {
+        return 0;
+    }
+    if (bufMgrThreadNode >= 0) {
+        return bufMgrThreadNode % numPartitions;
+    }
+    unsigned cpu, node;
+    if (partitionsBound && getcpu(&cpu, &node) == 0) {
+        return node % numPartitions;
+    }
+    return 0;
+}
+
+
+
+//按页框所在分区是否为调用线程的本地分区，统计本地访问或远程访问。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::noteAccess(FrameId frame)
+{
+    if (partitionOf(frame) == currentPartition()) {
+        bufStats.localAccesses++;
+    } else {
+        bufStats.remoteAccesses++;
+    }
+}
+
+
+
+//将页框中的页面写回磁盘。如果设置了日志管理器，必须先把日志刷到该页面的LSN为止(WAL规则)，
+//保证任何修改都不会先于它的日志记录落盘。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::writeBack(FrameId frame)
+{
+    if (logManager != NULL && bufPool[frame].page_lsn() != 0) {
+        logManager->flush(bufPool[frame].page_lsn());
+    }
+    if (doubleWriteBuffer != NULL) {
+        doubleWriteBuffer->write(bufDescTable[frame].file, bufPool[frame]);
+    } else {
+        bufDescTable[frame].file->writePage(bufPool[frame]);
+    }
+    if (sharedCache != NULL) {
+        sharedCache->write(bufDescTable[frame].file, bufPool[frame], false);
+    }
+    bufDescTable[frame].dirty = false;
+    bufDescTable[frame].recLsn = 0;
+    bufStats.diskwrites++;
+}
+
+
+
+//结束一组写回。设置了双写缓冲区时，交给它的页面在这里作为一批写出；页面离开缓冲池或
+//被认为已落盘之前必须调用，否则之后从磁盘读到的可能是旧页面。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::finishWriteBack()
+{
+    if (doubleWriteBuffer != NULL) {
+        doubleWriteBuffer->flush();
+    }
+}
+
+
+
+//设置了共享缓冲池时，页面的最后一个固定被释放后把它交还给共享缓冲池并释放页框。脏页面以脏
+//页存入共享缓冲池，之前按WAL规则先把日志刷到该页面的LSN，因为之后可能由任何进程写回。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::releaseShared(FrameId frame)
+{
+    if (bufDescTable[frame].dirty) {
+        if (logManager != NULL && bufPool[frame].page_lsn() != 0) {
+            logManager->flush(bufPool[frame].page_lsn());
+        }
+        sharedCache->write(bufDescTable[frame].file, bufPool[frame], true, bufDescTable[frame].recLsn);
+    }
+    hashTable->remove(bufDescTable[frame].file, bufDescTable[frame].pageNo);
+    clearFrame(frame);
 }
 
 
 
-//顺时针旋转时钟算法中的表针，将其指向缓冲池中下一个页框。
-void BufMgr::advanceClock()
+//记录页框在干净状态下被固定时的日志末尾LSN。之后对该页面的任何修改的日志记录都不会早于它，
+//所以检查点把它作为该页面的恢复起点(recLSN)。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::noteRecLsn(FrameId frame)
 {
-    clockHand = (clockHand + 1) % numBufs;
+    if (logManager != NULL && !bufDescTable[frame].dirty && bufDescTable[frame].recLsn == 0) {
+        bufDescTable[frame].recLsn = logManager->nextLsn();
+    }
 }
 
 
@@ -70,21 +242,94 @@ void BufMgr::advanceClock()
 //法，它会被下面介绍的readPage()和allocPage()方法调用。请注意，如果被分配的页框中包含一个
 //有效页面，则必须将该页面从哈希表中删除。最后，分配的页框的编号通过参数frame返回。
 //用于分配缓冲帧
-void BufMgr::allocBuf(FrameId & frame) 
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::allocBuf(FrameId & frame, TenantId tenant, const File* file) 
 {
-    while (true){
-        //遍历每一页
-			for (int i = 0; i != (signed)numBufs; i++) {
-				advanceClock();
+    //租户已经用满上限时只能替换它自己的页面。否则第一轮只在空闲页框和超出最低配额的租户(包括
+    //它自己)的页框中选择，让占用超出配额的租户先让出页框；都没有时才替换它自己在最低配额以内的
+    //页面。每一轮都先在调用线程的本地分区中分配，本地分区没有可替换的页框时再依次尝试其他分区
+    const bool atMax = tenants[tenant].frames >= tenants[tenant].maxFrames;
+    const std::uint32_t home = currentPartition();
+    for (int pass = atMax ? VICTIM_OWN : VICTIM_SURPLUS; pass <= VICTIM_OWN; pass++) {
+        const VictimScope scope = static_cast<VictimScope>(pass);
+        for (std::uint32_t k = 0; k < numPartitions; k++) {
+            const std::uint32_t partition = (home + k) % numPartitions;
+            if (allocBufIn(partition, frame, tenant, scope)) {
+                if (k > 0) {
+                    bufStats.remoteAllocs++;
+                }
+                //设置了准入过滤器且必须替换页面时，读入的页面先进入窗口。窗口已满时，最久未被访问的
+                //窗口页面与选出的牺牲页面竞争：它更频繁时被接纳为普通页面，替换牺牲页面；否则替换
+                //这个窗口页面
+                const bool windowed = admission != NULL && file != NULL && bufDescTable[frame].valid;
+                FrameId candidate;
+                if (windowed && !bufDescTable[frame].windowed && window.size() >= admission->windowFrames() &&
+                    takeWindowFrame(partition, tenant, scope, candidate)) {
+                    if (admission->admit(bufDescTable[candidate].file, bufDescTable[candidate].pageNo,
+                                         bufDescTable[frame].file, bufDescTable[frame].pageNo)) {
+                        bufDescTable[candidate].windowed = false;
+                        window.erase(std::find(window.begin(), window.end(), candidate));
+                    } else {
+                        frame = candidate;
+                    }
+                }
+                evictFrame(frame);
+                if (windowed) {
+                    bufDescTable[frame].windowed = true;
+                    window.push_back(frame);
+                }
+                return;
+            }
+        }
+    }
+    //所有可替换的页框都被锁定，抛出缓冲池溢出异常
+    throw BufferExceededException();
+}
+
+
+
+//在分区partition内运行时钟算法选择要替换的页框，但不清空它。跳过不在scope以内的页框。第一圈清除refbit，第二圈必
+//然能找到未被固定的可替换页框；两圈都没有找到说明该分区没有可替换的页框，返回false。
+template <class Policy, class PageTable, class Latching>
+bool BufMgrT<Policy, PageTable, Latching>::allocBufIn(std::uint32_t partition, FrameId & frame, TenantId tenant, VictimScope scope)
+{
+    //设置了替换策略时由它选择页框。先不考虑提示为常驻(HINT_KEEP_HOT)的页面，没有其他可替换
+    //的页框时才替换它们
+    if (policy.active()) {
+        for (int keepHot = 0; keepHot < 2; keepHot++) {
+            ReplacementPolicy::Evictable evictable = [&](FrameId f) {
+                return (keepHot == 1 || bufDescTable[f].hint != HINT_KEEP_HOT) &&
+                    isEvictable(f, partition, tenant, scope);
+            };
+            if (policy.pickVictim(evictable, frame)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    bool keepHotFound = false;
+    FrameId keepHotFrame = 0;
+    const FrameId first = partition * partitionSize;
+    const std::uint32_t size = std::min(numBufs, first + partitionSize) - first;
+    FrameId& clockHand = clockHands[partition];
+			for (std::uint32_t i = 0; i != 2 * size; i++) {
+				advanceClock(partition);
 				//当某个帧的valid位为false时，说明这个页面不可用，
 				//它就可以被清理掉从而腾出需要的空闲帧，函数返回
 				if (!bufDescTable[clockHand].valid) {
+					if (scope == VICTIM_OWN) {
+						continue;
+					}
 					frame = clockHand;
-					return;
+					return true;
+				}
+				//不在scope以内的页面不能替换
+				if (!withinScope(bufDescTable[clockHand], tenant, scope)) {
+					continue;
 				}
 				//当某个帧的refbit位为true时，说明这个页面最近被使用过并且未被替换，
-				//因此该位置不是空闲帧，进入下一次循环
-				if (bufDescTable[clockHand].refbit) {
+				//因此该位置不是空闲帧，进入下一次循环。提示为尽快替换的页面忽略refbit
+				if (bufDescTable[clockHand].refbit && bufDescTable[clockHand].hint != HINT_EVICT_SOON) {
 					bufDescTable[clockHand].refbit = false;
 					continue;
 				}
@@ -92,40 +337,171 @@ void BufMgr::allocBuf(FrameId & frame)
 				if (bufDescTable[clockHand].pinCnt > 0) {
 					continue;
 				}
-				//当某个帧的dirty位为true时，说明这个页面是脏的，应当将该页面写回磁盘
-				if (bufDescTable[clockHand].dirty) {
-					bufDescTable[clockHand].file->writePage(bufPool[clockHand]);
-				}
-
-				try {
-					if (bufDescTable[clockHand].file) {
-						hashTable->remove(bufDescTable[clockHand].file,
-						bufDescTable[clockHand].pageNo);
-						bufDescTable[clockHand].Clear();
-					}
-				}catch (HashNotFoundException &e) {
+				//提示为常驻的页面只在没有其他可替换页框时才被替换，先记下第一个
+				if (bufDescTable[clockHand].hint == HINT_KEEP_HOT) {
+					if (!keepHotFound) {
+						keepHotFound = true;
+						keepHotFrame = clockHand;
 					}
+					continue;
+				}
 				frame = clockHand;
-				return;
+				return true;
 			}
+    if (keepHotFound) {
+        frame = keepHotFrame;
+        return true;
+    }
+    return false;
+}
 
-			//当所有的页面都被占用时，检查是否所有页面都被锁定
-			bool allPinned = false;
-			for (int i = 0; i < (signed)numBufs; i++) {
-				if (!bufDescTable[i].pinCnt) {
-					allPinned = true;
-					break;
-				}
-			}
-            //如果所有页面都被锁定，抛出缓冲池溢出异常
-			if (!allPinned) {
-				throw BufferExceededException();
-			}
-		}
+
+
+//页框能否为分区partition中tenant的分配而被替换。
+template <class Policy, class PageTable, class Latching>
+bool BufMgrT<Policy, PageTable, Latching>::isEvictable(FrameId frame, std::uint32_t partition, TenantId tenant, VictimScope scope) const
+{
+    const BufDesc& desc = bufDescTable[frame];
+    if (partitionOf(frame) != partition || desc.pinCnt > 0) {
+        return false;
+    }
+    if (!desc.valid) {
+        return scope != VICTIM_OWN;
+    }
+    return withinScope(desc, tenant, scope);
+}
+
+
+
+//有效页框的租户是否允许在scope以内为tenant替换它：VICTIM_SURPLUS只允许超出最低配额的租户
+//的页框，VICTIM_ANY还允许tenant自己的页框，VICTIM_OWN只允许tenant自己的页框。
+template <class Policy, class PageTable, class Latching>
+bool BufMgrT<Policy, PageTable, Latching>::withinScope(const BufDesc& desc, TenantId tenant, VictimScope scope) const
+{
+    const TenantStats& owner = tenants[desc.tenant];
+    const bool surplus = owner.frames > owner.minFrames;
+    switch (scope) {
+    case VICTIM_SURPLUS:
+        return surplus;
+    case VICTIM_ANY:
+        return desc.tenant == tenant || surplus;
+    default:
+        return desc.tenant == tenant;
+    }
 }
 
 
 
+//在窗口页框中找出最久未被访问的可替换页框。找不到时frame保持不变，返回false。
+template <class Policy, class PageTable, class Latching>
+bool BufMgrT<Policy, PageTable, Latching>::takeWindowFrame(std::uint32_t partition, TenantId tenant, VictimScope scope, FrameId & frame)
+{
+    for (std::deque<FrameId>::iterator iter = window.begin(); iter != window.end(); ++iter) {
+        if (isEvictable(*iter, partition, tenant, scope)) {
+            frame = *iter;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+
+//命中已在缓冲池中的页面：统计命中，通知替换策略和准入过滤器。窗口按LRU顺序排列。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::noteHit(FrameId frame)
+{
+    BufDesc& desc = bufDescTable[frame];
+    tenants[desc.tenant].hits++;
+    policy.pageAccessed(frame);
+    if (admission != NULL) {
+        admission->recordAccess(desc.file, desc.pageNo);
+        if (desc.windowed) {
+            window.erase(std::find(window.begin(), window.end(), frame));
+            window.push_back(frame);
+        }
+    }
+}
+
+
+
+//应用页框被固定或取消固定时给出的访问提示。常驻提示一直保留到给出尽快替换提示为止；普通提示
+//只取消尽快替换提示。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::applyHint(FrameId frame, AccessHint hint)
+{
+    BufDesc& desc = bufDescTable[frame];
+    if (hint == HINT_NORMAL && desc.hint == HINT_KEEP_HOT) {
+        hint = HINT_KEEP_HOT;
+    }
+    if (hint == HINT_EVICT_SOON) {
+        desc.refbit = false;
+    }
+    if (hint != desc.hint) {
+        desc.hint = hint;
+        policy.pageHinted(frame, hint);
+    }
+}
+
+
+
+//清空将被替换的页框。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::evictFrame(FrameId frame)
+{
+    //当某个帧的dirty位为true时，说明这个页面是脏的，应当将该页面写回磁盘
+    if (bufDescTable[frame].dirty) {
+        writeBackVictim(frame);
+    }
+
+    try {
+        if (bufDescTable[frame].file) {
+            hashTable->remove(bufDescTable[frame].file,
+            bufDescTable[frame].pageNo);
+            clearFrame(frame);
+        }
+    }catch (HashNotFoundException &e) {
+        }
+}
+
+
+
+
+//写回将被替换的脏页。设置了双写缓冲区时每批写回都要同步三次，所以从时钟指针处起顺序收集
+//分区中接下来会被替换的、未被固定的脏页，与它凑成一批一起写回。这些页面留在缓冲池中，只是
+//变干净了，轮到它们被替换时不必再写。日志只需刷到这批页面中最大的LSN为止一次。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::writeBackVictim(FrameId frame)
+{
+    std::vector<FrameId> batch(1, frame);
+    if (doubleWriteBuffer != NULL) {
+        const std::uint32_t partition = partitionOf(frame);
+        const FrameId first = partition * partitionSize;
+        const std::uint32_t size = std::min(numBufs, first + partitionSize) - first;
+        for (std::uint32_t i = 1; i <= size && batch.size() < doubleWriteBuffer->batchPages(); i++) {
+            const FrameId next = first + (clockHands[partition] - first + i) % size;
+            if (next != frame && bufDescTable[next].valid && bufDescTable[next].dirty &&
+                bufDescTable[next].pinCnt == 0) {
+                batch.push_back(next);
+            }
+        }
+    }
+    if (logManager != NULL) {
+        Lsn maxLsn = 0;
+        for (std::size_t i = 0; i < batch.size(); i++) {
+            maxLsn = std::max(maxLsn, bufPool[batch[i]].page_lsn());
+        }
+        if (maxLsn != 0) {
+            logManager->flush(maxLsn);
+        }
+    }
+    for (std::size_t i = 0; i < batch.size(); i++) {
+        writeBack(batch[i]);
+    }
+    finishWriteBack();
+}
+
+
 
 //首先调用哈希表的lookup()方法检查待读取的页面(file, PageNo)是否已经在缓冲池中。如果该页面
 //已经在缓冲池中，则通过参数page返回指向该页面所在的页框的指针；如果该页面不在缓冲池中，则
@@ -140,24 +516,47 @@ void BufMgr::allocBuf(FrameId & frame)
 
 	
 // BufMgr 类的 readPage 函数，用于从文件中读取页到缓冲池
-void BufMgr::readPage(File* file, const PageId pageNo, Page*& page) {
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::readPage(File* file, const PageId pageNo, Page*& page, const AccessHint hint) {
+    std::lock_guard<Latching> guard(latch);
+    readPageLatched(file, pageNo, page, hint);
+}
+
+
+//已持有latch时的readPage()。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::readPageLatched(File* file, const PageId pageNo, Page*& page, const AccessHint hint) {
     FrameId id;
     try {
         // 尝试在缓冲池中查找对应的页面
         hashTable->lookup(file, pageNo, id);
         bufDescTable[id].pinCnt++; // 将对应缓冲帧的引用计数加一
-    } catch (HashNotFoundException e) {
+        noteHit(id);
+    } catch (HashNotFoundException &e) {
         // 页面不在缓冲池中
         // 分配一个缓冲帧，从磁盘读取页面
         // 将页面插入哈希表，设置缓冲帧信息
-        Page pageTemp = file->readPage(pageNo);
-        this->allocBuf(id);
+        // 设置了共享缓冲池时通过它读取：不在其中的页面由它从磁盘读入
+        Page pageTemp;
+        if (sharedCache != NULL) {
+            sharedCache->read(file, pageNo, pageTemp);
+        } else {
+            pageTemp = file->readPage(pageNo);
+        }
+        if (admission != NULL) {
+            admission->recordAccess(file, pageNo);
+        }
+        this->allocBuf(id, tenantOf(file), file);
         bufPool[id] = pageTemp;
         hashTable->insert(file, pageNo, id);
-        bufDescTable[id].Set(file, pageNo);
+        assignFrame(id, file, pageNo);
+        tenants[bufDescTable[id].tenant].misses++;
     }
 
     bufDescTable[id].refbit = true; // 设置 refbit 为 true，表示页面最近被访问过
+    applyHint(id, hint);
+    noteRecLsn(id);
+    noteAccess(id);
 
     // 返回指向包含该页面的缓冲帧的指针
     page = &bufPool[id];
@@ -165,17 +564,173 @@ void BufMgr::readPage(File* file, const PageId pageNo, Page*& page) {
 
 
 
+//批量读取页面。先用一次lookupBatch()找出已在缓冲池中的页面，并预取它们的页框描述符，再
+//统一固定；必须先固定所有命中的页面，否则后面未命中页面的allocBuf()可能会替换掉它们。最后
+//逐个调用readPage()读入未命中的页面。出错时撤销本次调用已经固定的页面。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::readPages(File* file, const PageId* pageNos, const std::size_t count, Page** pages) {
+    std::lock_guard<Latching> guard(latch);
+    FrameId frames[PageTable::MAX_BATCH];
+    bool found[PageTable::MAX_BATCH];
+    for (std::size_t i = 0; i < count; i++) {
+        pages[i] = NULL;
+    }
+    try {
+        for (std::size_t first = 0; first < count; first += PageTable::MAX_BATCH) {
+            std::size_t n = count - first;
+            if (n > PageTable::MAX_BATCH) {
+                n = PageTable::MAX_BATCH;
+            }
+            if (hashTable->lookupBatch(file, pageNos + first, n, frames, found) > 0) {
+                for (std::size_t i = 0; i < n; i++) {
+                    if (found[i]) {
+                        __builtin_prefetch(&bufDescTable[frames[i]], 1 /* write */);
+                    }
+                }
+                for (std::size_t i = 0; i < n; i++) {
+                    if (found[i]) {
+                        bufDescTable[frames[i]].pinCnt++;
+                        noteHit(frames[i]);
+                        bufDescTable[frames[i]].refbit = true;
+                        noteRecLsn(frames[i]);
+                        noteAccess(frames[i]);
+                        pages[first + i] = &bufPool[frames[i]];
+                    }
+                }
+            }
+            for (std::size_t i = 0; i < n; i++) {
+                if (!found[i]) {
+                    readPageLatched(file, pageNos[first + i], pages[first + i], HINT_NORMAL);
+                }
+            }
+        }
+    } catch (...) {
+        for (std::size_t i = 0; i < count; i++) {
+            if (pages[i] != NULL) {
+                unPinPageLatched(file, pageNos[i], false, HINT_NORMAL);
+                pages[i] = NULL;
+            }
+        }
+        throw;
+    }
+}
+
+
+//readPage()的异步版本，只构造等待对象；命中与未命中的处理见ReadPageAwaiter。
+template <class Policy, class PageTable, class Latching>
+ReadPageAwaiter BufMgrT<Policy, PageTable, Latching>::readPageAsync(File* file, const PageId pageNo)
+    requires std::is_same_v<BufMgrT, BufMgr> {
+    return ReadPageAwaiter(this, file, pageNo);
+}
+
+
+//如果页面已在缓冲池中，则像readPage()的情况2一样固定它并返回true。设置了共享缓冲池时
+//未固定的页面都在共享缓冲池中，直接通过它读取并返回true。
+template <class Policy, class PageTable, class Latching>
+bool BufMgrT<Policy, PageTable, Latching>::pinIfResident(File* file, const PageId pageNo, Page*& page) {
+    std::lock_guard<Latching> guard(latch);
+    if (sharedCache != NULL) {
+        readPageLatched(file, pageNo, page, HINT_NORMAL);
+        return true;
+    }
+    FrameId id;
+    try {
+        hashTable->lookup(file, pageNo, id);
+    } catch (HashNotFoundException &e) {
+        return false;
+    }
+    bufDescTable[id].pinCnt++;
+    bufDescTable[id].refbit = true;
+    noteHit(id);
+    noteRecLsn(id);
+    noteAccess(id);
+    page = &bufPool[id];
+    return true;
+}
+
+
+//为即将异步读入的页面分配页框。页框被固定(pinCnt为1)，时钟算法不会替换它；但在读完之前
+//不插入哈希表，其他请求不会看到尚未读入的内容。
+template <class Policy, class PageTable, class Latching>
+FrameId BufMgrT<Policy, PageTable, Latching>::reserveFrame(File* file, const PageId pageNo) {
+    std::lock_guard<Latching> guard(latch);
+    FrameId id;
+    if (admission != NULL) {
+        admission->recordAccess(file, pageNo);
+    }
+    allocBuf(id, tenantOf(file), file);
+    assignFrame(id, file, pageNo);
+    tenants[bufDescTable[id].tenant].misses++;
+    return id;
+}
+
+
+//异步读完成后把页框插入哈希表，pinCnt设为等待该页面的请求数。如果期间同一页面已被同步的
+//readPage()读入了另一个页框，则释放预留的页框，改为固定那个页框。
+template <class Policy, class PageTable, class Latching>
+Page* BufMgrT<Policy, PageTable, Latching>::installFrame(FrameId frame, const std::uint32_t pins) {
+    std::lock_guard<Latching> guard(latch);
+    File* file = bufDescTable[frame].file;
+    const PageId pageNo = bufDescTable[frame].pageNo;
+    FrameId id;
+    try {
+        hashTable->lookup(file, pageNo, id);
+        clearFrame(frame);
+        bufDescTable[id].pinCnt += pins;
+    } catch (HashNotFoundException &e) {
+        id = frame;
+        hashTable->insert(file, pageNo, id);
+        bufDescTable[id].pinCnt = pins;
+    }
+    bufDescTable[id].refbit = true;
+    noteRecLsn(id);
+    noteAccess(id);
+    return &bufPool[id];
+}
+
+
+//异步读失败时释放预留的页框。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::releaseFrame(FrameId frame) {
+    std::lock_guard<Latching> guard(latch);
+    clearFrame(frame);
+}
+
+
+
 
 //将缓冲区中包含(file, PageNo)表示的页面所在的页框的pinCnt值减1。如果参数dirty等于true，则
 //将页框的dirty位置为true。如果pinCnt值已经是0，则抛出PAGENOTPINNED异常。如果该页面不在哈
 //希表中，则什么都不用做。
 // BufMgr 类的 unPinPage 函数，用于取消对页面的引用
-void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty) {
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::unPinPage(File* file, const PageId pageNo, const bool dirty, const AccessHint hint) {
+    std::lock_guard<Latching> guard(latch);
+    unPinPageLatched(file, pageNo, dirty, hint);
+}
+
+
+//把被固定页面的recLSN降低到recLsn。恢复时重做的修改来自较早的日志记录，固定页面时设置的
+//recLSN(日志末尾)会让下一次恢复跳过它们。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::lowerRecLsn(const File* file, const PageId pageNo, const Lsn recLsn) {
+    std::lock_guard<Latching> guard(latch);
+    FrameId frameId;
+    hashTable->lookup(file, pageNo, frameId);
+    if (bufDescTable[frameId].recLsn == 0 || recLsn < bufDescTable[frameId].recLsn) {
+        bufDescTable[frameId].recLsn = recLsn;
+    }
+}
+
+
+//已持有latch时的unPinPage()。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::unPinPageLatched(File* file, const PageId pageNo, const bool dirty, const AccessHint hint) {
     FrameId frameId;
     try {
         // 尝试在哈希表中查找对应的页面
         hashTable->lookup(file, pageNo, frameId);
-    } catch (HashNotFoundException e) {
+    } catch (HashNotFoundException &e) {
         // 如果页面不在哈希表中，什么都不做，直接返回
         return;
     }
@@ -188,6 +743,14 @@ void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty) {
     if (dirty) {
         bufDescTable[frameId].dirty = true;
     }
+    // 普通提示保留固定时给出的提示
+    if (hint != HINT_NORMAL) {
+        applyHint(frameId, hint);
+    }
+    // 设置了共享缓冲池时只有被固定的页面留在这里
+    if (sharedCache != NULL && bufDescTable[frameId].pinCnt == 0) {
+        releaseShared(frameId);
+    }
 }
 
 
@@ -198,8 +761,10 @@ void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty) {
 //如果文件file的某些页面被固定住(pinned)，则抛出BadBufferException异常。如果检索到文件file的
 //某个无效页，则抛出BadBufferException异常。
 // BufMgr 类的 flushFile 函数，用于刷新指定文件的所有页面到磁盘
-void BufMgr::flushFile(const File* file) {
-    // 遍历缓冲池中的每一页
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::flushFile(const File* file) {
+    std::lock_guard<Latching> guard(latch);
+    // 先检查所有页框再写回：写回一部分后抛出异常会把页面留在双写缓冲区中，而页框已被清空
     for (FrameId k = 0; k < numBufs; k++) {
         // 如果缓冲帧对应的文件为目标文件
         if (bufDescTable[k].file == file) {
@@ -211,20 +776,50 @@ void BufMgr::flushFile(const File* file) {
             else if (!bufDescTable[k].valid) {
                 throw BadBufferException(k, bufDescTable[k].dirty, bufDescTable[k].valid, bufDescTable[k].refbit);
             }
-            // 缓冲帧可用且未被锁定
-            else {
-                // 如果缓冲帧是脏的，将其内容写回磁盘
-                if (bufDescTable[k].dirty) {
-                    bufDescTable[k].file->writePage(bufPool[k]);
-                    bufDescTable[k].dirty = false;
-                }
-                // 从哈希表中移除缓冲帧对应的文件和页号
-                hashTable->remove(file, bufDescTable[k].pageNo);
-                // 清空缓冲帧的信息
-                bufDescTable[k].Clear();
+        }
+    }
+    // 遍历缓冲池中的每一页，缓冲帧都可用且未被锁定
+    for (FrameId k = 0; k < numBufs; k++) {
+        if (bufDescTable[k].file == file) {
+            // 如果缓冲帧是脏的，将其内容写回磁盘
+            if (bufDescTable[k].dirty) {
+                writeBack(k);
+                bufDescTable[k].dirty = false;
             }
+            // 从哈希表中移除缓冲帧对应的文件和页号
+            hashTable->remove(file, bufDescTable[k].pageNo);
+            // 清空缓冲帧的信息
+            clearFrame(k);
         }
     }
+    finishWriteBack();
+    if (sharedCache != NULL) {
+        sharedCache->flushFile(file);
+    }
+    // 按文件的持久化模式把写回的页面真正落盘
+    file->sync();
+}
+
+
+//如果页面(file, pageNo)在缓冲池中且是脏的，则把它写回磁盘，但不从缓冲池中移除；然后按文件
+//的持久化模式落盘。页面可以被固定。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::flushPage(const File* file, const PageId pageNo) {
+    std::lock_guard<Latching> guard(latch);
+    FrameId frameId;
+    try {
+        hashTable->lookup(file, pageNo, frameId);
+        if (bufDescTable[frameId].dirty) {
+            writeBack(frameId);
+            bufDescTable[frameId].dirty = false;
+        }
+    } catch (HashNotFoundException &e) {
+        if (sharedCache != NULL) {
+            sharedCache->flush(file, pageNo);
+        }
+    }
+    finishWriteBack();
+    file->sync();
 }
 
 
@@ -233,18 +828,37 @@ void BufMgr::flushFile(const File* file) {
 //中插入一条项目，并调用Set()方法正确设置页框的状态。该方法既通过pageNo参数返回新分配的页
 //面的页号，还通过page参数返回指向缓冲池中包含该页面的页框的指针。
 // BufMgr 类的 allocPage 函数，用于在指定文件中分配一个空白页
-void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page) {
-    FrameId frameId;
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::allocPage(File* file, PageId &pageNo, Page*& page, const AccessHint hint) {
+    std::lock_guard<Latching> guard(latch);
     // 在指定文件中分配一个空白页
-    PageId newPageId = file->allocatePage().page_number();
+    installNewPage(file, file->allocatePage().page_number(), pageNo, page, hint);
+}
+
+
+//与allocPage()相同，但新页面总是加在文件末尾，不重用空闲页面。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::appendPage(File* file, PageId &pageNo, Page*& page, const AccessHint hint) {
+    std::lock_guard<Latching> guard(latch);
+    installNewPage(file, file->appendPage().page_number(), pageNo, page, hint);
+}
+
+
+//为文件中刚分配的页面newPageId分配页框并固定它。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::installNewPage(File* file, const PageId newPageId, PageId &pageNo, Page*& page, const AccessHint hint) {
+    FrameId frameId;
     // 分配一个缓冲帧
-    allocBuf(frameId);
+    allocBuf(frameId, tenantOf(file));
     // 将新分配的页内容读入到缓冲帧中
     bufPool[frameId] = file->readPage(newPageId);
     // 将新页的信息插入哈希表
     hashTable->insert(file, newPageId, frameId);
     // 设置缓冲帧的信息
-    bufDescTable[frameId].Set(file, newPageId);
+    assignFrame(frameId, file, newPageId);
+    applyHint(frameId, hint);
+    noteRecLsn(frameId);
+    noteAccess(frameId);
     // 返回新分配的页号和指向缓冲帧的指针
     pageNo = newPageId;
     page = &bufPool[frameId];
@@ -256,24 +870,222 @@ void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page) {
 //该方法从文件file中删除页号为pageNo的页面。在删除之前，如果该页面在缓冲池中，需要将该页面
 //所在的页框清空并从哈希表中删除该页面。
 // BufMgr 类的 disposePage 函数，用于释放指定文件中的一页
-void BufMgr::disposePage(File* file, const PageId PageNo) {
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::disposePage(File* file, const PageId PageNo) {
+    std::lock_guard<Latching> guard(latch);
     FrameId frameId;
     try {
         // 确保要删除的页面在缓冲池中有分配对应的缓冲帧
         hashTable->lookup(file, PageNo, frameId);
         // 清空对应缓冲帧的信息
-        bufDescTable[frameId].Clear();
+        clearFrame(frameId);
         // 从哈希表中移除对应的文件和页号
         hashTable->remove(file, PageNo);
-    } catch (HashNotFoundException e) {
+    } catch (HashNotFoundException &e) {
         // 捕获哈希表异常，忽略
     }
+    if (sharedCache != NULL) {
+        sharedCache->invalidate(file, PageNo);
+    }
     // 调用文件对象的 deletePage 方法删除指定页
     file->deletePage(PageNo);
 }
 
 
-void BufMgr::printSelf(void) 
+//创建一个租户。上限为0、下限大于上限或者所有租户的下限之和超过缓冲池大小时无法保证配额，
+//抛出InvalidQuotaException异常。
+template <class Policy, class PageTable, class Latching>
+TenantId BufMgrT<Policy, PageTable, Latching>::createTenant(const std::string& name, std::uint32_t minFrames, std::uint32_t maxFrames)
+{
+    std::lock_guard<Latching> guard(latch);
+    if (maxFrames == 0 || minFrames > maxFrames) {
+        throw InvalidQuotaException(name, "minimum must not exceed a non-zero maximum");
+    }
+    std::uint64_t reserved = minFrames;
+    for (std::size_t i = 0; i < tenants.size(); i++) {
+        reserved += tenants[i].minFrames;
+    }
+    if (reserved > numBufs) {
+        throw InvalidQuotaException(name, "minimums exceed the buffer pool size");
+    }
+    TenantStats tenant = {name, minFrames, std::min(maxFrames, numBufs), 0, 0, 0};
+    tenants.push_back(tenant);
+    return tenants.size() - 1;
+}
+
+
+//把文件之后读入的页面记到租户tenant名下。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::assignFile(const File* file, TenantId tenant)
+{
+    std::lock_guard<Latching> guard(latch);
+    if (tenant >= tenants.size()) {
+        throw InvalidQuotaException(std::to_string(tenant), "no such tenant");
+    }
+    if (tenant == 0) {
+        fileTenants.erase(file);
+    } else {
+        fileTenants[file] = tenant;
+    }
+}
+
+
+//文件所属的租户，未指定时为默认租户0。
+template <class Policy, class PageTable, class Latching>
+TenantId BufMgrT<Policy, PageTable, Latching>::tenantOf(const File* file) const
+{
+    if (fileTenants.empty()) {
+        return 0;
+    }
+    std::map<const File*, TenantId>::const_iterator iter = fileTenants.find(file);
+    return iter == fileTenants.end() ? 0 : iter->second;
+}
+
+
+//把页框分配给页面，并记到页面所属文件的租户名下。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::assignFrame(FrameId frame, File* file, const PageId pageNo)
+{
+    bufDescTable[frame].Set(file, pageNo);
+    bufDescTable[frame].tenant = tenantOf(file);
+    tenants[bufDescTable[frame].tenant].frames++;
+    policy.pageInstalled(frame);
+}
+
+
+//清空页框，并从其租户的占用中扣除。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::clearFrame(FrameId frame)
+{
+    if (bufDescTable[frame].valid) {
+        tenants[bufDescTable[frame].tenant].frames--;
+        policy.pageRemoved(frame);
+        if (bufDescTable[frame].windowed) {
+            window.erase(std::find(window.begin(), window.end(), frame));
+        }
+    }
+    bufDescTable[frame].Clear();
+}
+
+
+//设置替换策略，并把已在缓冲池中的页面告诉它。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::setReplacementPolicy(ReplacementPolicy* replacementPolicy)
+    requires std::is_same_v<Policy, DynamicPolicy>
+{
+    std::lock_guard<Latching> guard(latch);
+    policy.set(replacementPolicy);
+    policy.reset(numBufs);
+    for (FrameId i = 0; i < numBufs; i++) {
+        if (bufDescTable[i].valid) {
+            policy.pageInstalled(i);
+        }
+    }
+}
+
+
+//设置准入过滤器。取消时窗口页面成为普通页面。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::setAdmissionFilter(TinyLfu* filter)
+{
+    std::lock_guard<Latching> guard(latch);
+    admission = filter;
+    for (std::size_t i = 0; i < window.size(); i++) {
+        bufDescTable[window[i]].windowed = false;
+    }
+    window.clear();
+}
+
+
+//设置双写缓冲区。切换之前先把旧缓冲区中尚未写出的页面写出。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::setDoubleWriteBuffer(DoubleWriteBuffer* dwb)
+{
+    std::lock_guard<Latching> guard(latch);
+    finishWriteBack();
+    doubleWriteBuffer = dwb;
+}
+
+
+//收集脏页表：每个脏页框对应一项(文件名, 页号, recLSN)，供模糊检查点记录到日志中。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::getDirtyPages(std::vector<DirtyPageEntry>& dirtyPages)
+{
+    std::lock_guard<Latching> guard(latch);
+    for (FrameId i = 0; i < numBufs; i++) {
+        if (bufDescTable[i].valid && bufDescTable[i].dirty) {
+            DirtyPageEntry entry;
+            entry.filename = bufDescTable[i].file->filename();
+            entry.page_number = bufDescTable[i].pageNo;
+            entry.rec_lsn = bufDescTable[i].recLsn;
+            dirtyPages.push_back(entry);
+        }
+    }
+    if (sharedCache != NULL) {
+        sharedCache->dirtyPages(dirtyPages);
+    }
+}
+
+
+
+//复制文件file在缓冲池中的所有脏页。这些页面比磁盘上的版本新，快照开始时需要把它们当作
+//时间点映像保存下来。
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::copyDirtyPages(const File* file, std::vector<Page>& pages)
+{
+    std::lock_guard<Latching> guard(latch);
+    for (FrameId i = 0; i < numBufs; i++) {
+        if (bufDescTable[i].valid && bufDescTable[i].dirty && bufDescTable[i].file == file) {
+            pages.push_back(bufPool[i]);
+        }
+    }
+    if (sharedCache != NULL) {
+        sharedCache->copyDirtyPages(file, pages);
+    }
+}
+
+
+
+//把recLSN早于recLsnLimit的、未被固定的脏页写回磁盘，最多写maxPages个。
+//写回之前按(文件名, 页号)排序，使写入尽量顺序；写回后页面仍留在缓冲池中，只是变干净了。
+template <class Policy, class PageTable, class Latching>
+std::uint32_t BufMgrT<Policy, PageTable, Latching>::writeBackDirty(Lsn recLsnLimit, std::uint32_t maxPages)
+{
+    std::lock_guard<Latching> guard(latch);
+    std::vector<FrameId> candidates;
+    for (FrameId i = 0; i < numBufs; i++) {
+        if (bufDescTable[i].valid && bufDescTable[i].dirty &&
+            bufDescTable[i].pinCnt == 0 && bufDescTable[i].recLsn < recLsnLimit) {
+            candidates.push_back(i);
+        }
+    }
+    // 优先写最老的脏页，它们决定了恢复需要从日志的哪里开始
+    std::sort(candidates.begin(), candidates.end(), [this](FrameId a, FrameId b) {
+        return bufDescTable[a].recLsn < bufDescTable[b].recLsn;
+    });
+    if (candidates.size() > maxPages) {
+        candidates.resize(maxPages);
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](FrameId a, FrameId b) {
+        if (bufDescTable[a].file != bufDescTable[b].file) {
+            return bufDescTable[a].file->filename() < bufDescTable[b].file->filename();
+        }
+        return bufDescTable[a].pageNo < bufDescTable[b].pageNo;
+    });
+    for (std::size_t i = 0; i < candidates.size(); i++) {
+        writeBack(candidates[i]);
+    }
+    finishWriteBack();
+    std::uint32_t written = candidates.size();
+    if (sharedCache != NULL) {
+        written += sharedCache->writeBackDirty(recLsnLimit, maxPages - written);
+    }
+    return written;
+}
+
+
+template <class Policy, class PageTable, class Latching>
+void BufMgrT<Policy, PageTable, Latching>::printSelf(void) 
 {
   BufDesc* tmpbuf;
 	int validFrames = 0;
@@ -291,4 +1103,8 @@ void BufMgr::printSelf(void)
 	std::cout << "Total Number of Valid Frames:" << validFrames << "\n";
 }
 
+template class BufMgrT<ClockPolicy, BufHashTbl, NoLatching>;
+template class BufMgrT<ClockPolicy, BufHashTbl, AtomicLatching>;
+template class BufMgrT<DynamicPolicy, BufHashTbl, NoLatching>;
+
 }
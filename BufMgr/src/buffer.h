@@ -7,22 +7,79 @@
 
 #pragma once
 
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
 #include "file.h"
 #include "bufHashTbl.h"
+#include "buffer_traits.h"
 
 namespace badgerdb {
 
 /**
-* forward declaration of BufMgr class 
+* forward declaration of BufMgrT class template
+*/
+template <class Policy, class PageTable, class Latching>
+class BufMgrT;
+
+/**
+* The buffer manager used throughout BadgerDB: clock replacement that a ReplacementPolicy can replace at run time,
+* BufHashTbl as page table and no latching
 */
-class BufMgr;
+typedef BufMgrT<DynamicPolicy, BufHashTbl, NoLatching> BufMgr;
+
+/**
+* forward declaration of LogManager class 
+*/
+class LogManager;
+
+/**
+* NUMA node the calling thread pretends to run on, or -1; shared by all specializations of BufMgrT
+*/
+extern thread_local int bufMgrThreadNode;
+
+/**
+* forward declaration of DoubleWriteBuffer class 
+*/
+class DoubleWriteBuffer;
+
+/**
+* forward declaration of SharedPageCache class 
+*/
+class SharedPageCache;
+
+/**
+* forward declaration of ReplacementPolicy class 
+*/
+class ReplacementPolicy;
+
+/**
+* forward declaration of TinyLfu class 
+*/
+class TinyLfu;
+
+/**
+* forward declaration of DirtyPageEntry struct 
+*/
+struct DirtyPageEntry;
+
+/**
+* forward declaration of ReadPageAwaiter class 
+*/
+class ReadPageAwaiter;
 
 /**
 * @brief Class for maintaining information about buffer pool frames
 */
 class BufDesc {
 
-	friend class BufMgr;
+	template <class Policy, class PageTable, class Latching>
+	friend class BufMgrT;
 
  private:
 	/**
@@ -60,12 +117,37 @@ class BufDesc {
 	 */
   bool refbit;
 
+	/**
+   * Log end at the time the page was first pinned while clean.  Every logged change which may be missing from the
+   * page on disk has an LSN at or after this one; 0 if no log manager is in use
+	 */
+  Lsn recLsn;
+
+	/**
+   * Tenant the page is charged to
+	 */
+  TenantId tenant;
+
+	/**
+   * Access hint the page was last pinned or unpinned with
+	 */
+  AccessHint hint;
+
+	/**
+   * True if the page is in the admission window and was not admitted into the main part of the pool yet
+	 */
+  bool windowed;
+
 	/**
    * Initialize buffer frame for a new user
 	 */
   void Clear()
 	{
     pinCnt = 0;
+    recLsn = 0;
+    tenant = 0;
+    hint = HINT_NORMAL;
+    windowed = false;
 		file = NULL;
 		pageNo = Page::INVALID_NUMBER;
     dirty = false;
@@ -85,6 +167,7 @@ class BufDesc {
 		file = filePtr;
     pageNo = pageNum;
     pinCnt = 1;
+    recLsn = 0;
     dirty = false;
     valid = true;
     refbit = true;
@@ -136,12 +219,28 @@ struct BufStats
 	 */
   int diskwrites;
 
+	/**
+   * Number of page accesses served by a frame in the partition of the calling thread's NUMA node
+	 */
+  int localAccesses;
+
+	/**
+   * Number of page accesses served by a frame in another partition
+	 */
+  int remoteAccesses;
+
+	/**
+   * Number of misses that found no free frame in the local partition and took one from another
+	 */
+  int remoteAllocs;
+
 	/**
    * Clear all values 
 	 */
   void clear()
   {
 		accesses = diskreads = diskwrites = 0;
+		localAccesses = remoteAccesses = remoteAllocs = 0;
   }
       
 	/**
@@ -154,16 +253,118 @@ struct BufStats
 };
 
 
+/**
+* @brief Quotas and usage statistics of one tenant of the buffer pool
+*/
+struct TenantStats
+{
+	/**
+   * Name of the tenant
+	 */
+  std::string name;
+
+	/**
+   * Frames the tenant keeps even when others need them
+	 */
+  std::uint32_t minFrames;
+
+	/**
+   * Frames the tenant may hold at most
+	 */
+  std::uint32_t maxFrames;
+
+	/**
+   * Frames currently holding pages charged to the tenant
+	 */
+  std::uint32_t frames;
+
+	/**
+   * Number of page requests found in the buffer pool
+	 */
+  int hits;
+
+	/**
+   * Number of page requests that had to be read from disk
+	 */
+  int misses;
+};
+
+
 /**
 * @brief The central class which manages the buffer pool including frame allocation and deallocation to pages in the file 
+*
+* The replacement policy, the page table and the latching are template parameters, so a specialization calls them
+* directly and the compiler inlines them into the page operations:
+* - Policy: ClockPolicy, DynamicPolicy or any class with the member functions of those; see buffer_traits.h.
+* - PageTable: maps (file, page number) to frames with the interface of BufHashTbl.
+* - Latching: NoLatching for a pool used by one thread, or AtomicLatching, which serializes every member function
+*   that reads or changes the frames so that threads may call them concurrently: the page operations, the hooks of
+*   readPageAsync(), the set functions, createTenant(), assignFile(), getDirtyPages(), copyDirtyPages(),
+*   writeBackDirty() and clearBufStats().  The statistics returned by getBufStats() and getTenantStats() and the
+*   output of printSelf() are read without the latch and are exact only while no other thread uses the pool.
+*
+* The member functions are defined in buffer.cpp and explicitly instantiated there for BufMgr and for ClockPolicy with
+* both latchings; other combinations need to be added to that list.
 */
-class BufMgr 
+template <class Policy = ClockPolicy, class PageTable = BufHashTbl, class Latching = NoLatching>
+class BufMgrT 
 {
+	friend class EventLoop;
+	friend class ReadPageAwaiter;
+
  private:
 	/**
-   * Current position of clockhand in our buffer pool
+	 * Frames an allocation may replace, in the order allocBuf() tries them
+	 */
+  enum VictimScope {
+		/**
+		 * Free frames and frames of tenants, the allocating one included, holding more than their minimum
+		 */
+		VICTIM_SURPLUS,
+		/**
+		 * As VICTIM_SURPLUS, and any frame of the allocating tenant
+		 */
+		VICTIM_ANY,
+		/**
+		 * Frames of the allocating tenant only
+		 */
+		VICTIM_OWN
+  };
+
+	/**
+   * Current position of the clock hand of every partition
+	 */
+  std::vector<FrameId> clockHands;
+
+	/**
+   * Number of NUMA partitions the frames are split into
+	 */
+  std::uint32_t numPartitions;
+
+	/**
+   * Number of frames per partition (the last one may have fewer)
 	 */
-  FrameId clockHand;
+  std::uint32_t partitionSize;
+
+	/**
+   * True if the partitions correspond to real NUMA nodes and their pages were bound to them
+	 */
+  bool partitionsBound;
+
+	/**
+   * Page-aligned memory holding the page data of each partition
+	 */
+  std::vector<FrameArena*> arenas;
+
+	/**
+   * Quotas and statistics of every tenant; tenant 0 is the default one
+	 */
+  std::vector<TenantStats> tenants;
+
+	/**
+   * Tenant the pages of a file are charged to, if not the default one
+	 */
+  std::map<const File*, TenantId> fileTenants;
 
 	/**
    * Number of frames in the buffer pool
@@ -173,7 +374,7 @@ class BufMgr
 	/**
    * Hash table mapping (File, page) to frame
 	 */
-  BufHashTbl *hashTable;
+  PageTable *hashTable;
 
 	/**
    * Array of BufDesc objects to hold information corresponding to every frame allocation from 'bufPool' (the buffer pool)
@@ -186,17 +387,243 @@ class BufMgr
   BufStats bufStats;
 
 	/**
-   * Advance clock to next frame in the buffer pool
+   * Write-ahead log whose rule is enforced on write-back, NULL if none
+	 */
+  LogManager* logManager;
+
+	/**
+   * Double-write buffer page write-backs go through, NULL if none
+	 */
+  DoubleWriteBuffer* doubleWriteBuffer;
+
+	/**
+	 * Buffer pool shared with other processes that holds the unpinned pages, or NULL
+	 */
+  SharedPageCache* sharedCache;
+
+	/**
+	 * Policy choosing the frames to replace, unless it is not active and the clock algorithm does
 	 */
-  void advanceClock();
+  Policy policy;
+
+	/**
+	 * Latch held during page operations
+	 */
+  Latching latch;
+
+	/**
+	 * Filter deciding whether missed pages may replace the victim, or NULL to admit every page
+	 */
+  TinyLfu* admission;
+
+	/**
+	 * Frames of the admission window, least recently used first
+	 */
+  std::deque<FrameId> window;
+
+	/**
+   * Advance the clock of a partition to its next frame
+   *
+   * @param partition	Partition whose clock hand moves
+	 */
+  void advanceClock(std::uint32_t partition);
+
+	/**
+	 * Write the page held in a frame back to its file.  If a log manager is set, the log is first made durable up
+	 * to the page LSN so that no change reaches the data file before its log record (WAL rule).
+	 *
+	 * @param frame   	Frame whose page is written back
+	 */
+  void writeBack(FrameId frame);
+
+	/**
+	 * Finish a group of write-backs: with a double-write buffer set, the pages handed to it are written out as one
+	 * batch; otherwise nothing needs to be done.
+	 */
+  void finishWriteBack();
+
+	/**
+	 * Hand a page that is no longer pinned over to the shared pool and free its frame: a dirty page is stored in
+	 * the pool as dirty, after the log has been made durable up to its page LSN.
+	 *
+	 * @param frame   	Frame whose pin count has dropped to zero
+	 */
+  void releaseShared(FrameId frame);
+
+	/**
+	 * Remember the current end of the log as recovery LSN of a frame that is being pinned while clean.
+	 *
+	 * @param frame   	Frame being pinned
+	 */
+  void noteRecLsn(FrameId frame);
 
 	/**
 	 * Allocate a free frame.  
 	 *
 	 * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
+	 * @param tenant  	Tenant the frame is allocated for
+	 * @param file   	File of the page the frame is for; NULL if it bypasses the admission window
 	 * @throws BufferExceededException If no such buffer is found which can be allocated
 	 */
-  void allocBuf(FrameId & frame);
+  void allocBuf(FrameId & frame, TenantId tenant = 0, const File* file = NULL);
+
+	/**
+	 * Chooses the frame to replace in one partition with the replacement policy, or the clock algorithm if none is
+	 * set, without emptying it.  Only the frames within <scope> are considered.
+	 *
+	 * @param partition	Partition to take the frame from
+	 * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
+	 * @param tenant  	Tenant the frame is allocated for
+	 * @param scope   	Frames that may be replaced
+	 * @return  False if no frame of the partition may be replaced
+	 */
+  bool allocBufIn(std::uint32_t partition, FrameId & frame, TenantId tenant, VictimScope scope);
+
+	/**
+	 * Returns true if the page in a frame may be replaced for an allocation in <partition>: the frame is not pinned,
+	 * lies in the partition and is free or, if valid, within <scope>.
+	 */
+  bool isEvictable(FrameId frame, std::uint32_t partition, TenantId tenant, VictimScope scope) const;
+
+	/**
+	 * Returns true if the tenant of a valid frame lets it be replaced for <tenant> within <scope>.
+	 */
+  bool withinScope(const BufDesc& desc, TenantId tenant, VictimScope scope) const;
+
+	/**
+	 * Writes back the page in a frame if it is dirty and removes it from the buffer pool.
+	 *
+	 * @param frame   	Frame to empty
+	 */
+  void evictFrame(FrameId frame);
+
+	/**
+	 * Write back a dirty page about to be replaced.  With a double-write buffer set, the unpinned dirty pages the
+	 * clock hand of its partition reaches next are written back in the same batch, up to the batch size, so that
+	 * replacing dirty pages one at a time does not pay the syncs of a batch for each.  They stay in the buffer pool,
+	 * clean.
+	 *
+	 * @param frame   	Frame about to be replaced
+	 */
+  void writeBackVictim(FrameId frame);
+
+	/**
+	 * Finds the least recently used window frame that may be replaced for an allocation in <partition>.
+	 *
+	 * @param frame   	Receives the frame; unchanged if none is found
+	 * @return  False if no window frame may be replaced
+	 */
+  bool takeWindowFrame(std::uint32_t partition, TenantId tenant, VictimScope scope, FrameId & frame);
+
+	/**
+	 * Records a hit on a page already in the buffer pool with the tenant statistics, the replacement policy and the
+	 * admission filter.
+	 *
+	 * @param frame   	Frame hit
+	 */
+  void noteHit(FrameId frame);
+
+	/**
+	 * Applies the access hint a frame was pinned or unpinned with and tells the replacement policy if it changed.
+	 * HINT_KEEP_HOT stays until HINT_EVICT_SOON is given; HINT_NORMAL only cancels HINT_EVICT_SOON.
+	 *
+	 * @param frame   	Frame number
+	 * @param hint   	Access hint
+	 */
+  void applyHint(FrameId frame, AccessHint hint);
+
+	/**
+	 * Returns the tenant the pages of a file are charged to.
+	 */
+  TenantId tenantOf(const File* file) const;
+
+	/**
+	 * Assigns a frame to a page and charges it to the tenant of the file.
+	 *
+	 * @param frame   	Frame number
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file
+	 */
+  void assignFrame(FrameId frame, File* file, const PageId PageNo);
+
+	/**
+	 * Clears a frame and releases the charge of its page.
+	 *
+	 * @param frame   	Frame number
+	 */
+  void clearFrame(FrameId frame);
+
+	/**
+	 * Returns the partition of the NUMA node the calling thread runs on.
+	 */
+  std::uint32_t currentPartition() const;
+
+	/**
+	 * Counts an access to a frame as local or remote to the calling thread.
+	 *
+	 * @param frame   Frame accessed
+	 */
+  void noteAccess(FrameId frame);
+
+	/**
+	 * Maps the page data of every partition as one region, bound to the partition's NUMA node when the partitions
+	 * correspond to real nodes, and constructs the frames of the partition on it.
+	 */
+  void allocatePartitions();
+
+	/**
+	 * Pins a page if it is already in the buffer pool.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file
+	 * @param page  	Set to the frame holding the page if it is resident
+	 * @return  True if the page was resident and has been pinned
+	 */
+  bool pinIfResident(File* file, const PageId PageNo, Page*& page);
+
+	/**
+	 * Allocates a frame for a page that is about to be read asynchronously.  The frame is pinned
+	 * so it cannot be evicted, but it is not entered into the hash table until installFrame().
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file
+	 * @return  The reserved frame
+	 * @throws  BufferExceededException If all frames are pinned
+	 */
+  FrameId reserveFrame(File* file, const PageId PageNo);
+
+	/**
+	 * Makes a reserved frame whose page has been read visible in the buffer pool with <pins> pins.
+	 * If the page entered the pool through another frame in the meantime, that frame is pinned
+	 * instead and the reserved one is released.
+	 *
+	 * @param frame   Frame returned by reserveFrame()
+	 * @param pins    Number of requests waiting for the page
+	 * @return  Pointer to the frame holding the page
+	 */
+  Page* installFrame(FrameId frame, const std::uint32_t pins);
+
+	/**
+	 * Releases a reserved frame whose read failed.
+	 *
+	 * @param frame   Frame returned by reserveFrame()
+	 */
+  void releaseFrame(FrameId frame);
+
+	/**
+	 * Assigns a frame to a page just allocated in the file and pins it; the rest of allocPage() and appendPage().
+	 */
+  void installNewPage(File* file, const PageId newPageNo, PageId &PageNo, Page*& page, const AccessHint hint);
+
+	/**
+	 * readPage() for a caller already holding the latch.
+	 */
+  void readPageLatched(File* file, const PageId PageNo, Page*& page, const AccessHint hint);
+
+	/**
+	 * unPinPage() for a caller already holding the latch.
+	 */
+  void unPinPageLatched(File* file, const PageId PageNo, const bool dirty, const AccessHint hint);
 
  public:
 	/**
@@ -206,13 +633,22 @@ class BufMgr
 
 	/**
    * Constructor of BufMgr class
-	 */
-  BufMgr(std::uint32_t bufs);
+   *
+   * With numaNodes > 1 the frames are split into that many equal partitions, each with its own clock hand, and a
+   * miss takes a frame from the partition of the calling thread's node before trying the others.  If the machine
+   * has that many NUMA nodes the page data of each partition is bound to its node and threads are mapped to
+   * partitions by the node they run on; otherwise the partitions are simulated and setThreadNode() decides.
+   *
+   * @param bufs      	Number of frames
+   * @param numaNodes 	Number of partitions
+   * @param replacementPolicy	Replacement policy, copied
+	 */
+  BufMgrT(std::uint32_t bufs, std::uint32_t numaNodes = 1, const Policy& replacementPolicy = Policy());
 	
 	/**
    * Destructor of BufMgr class
 	 */
-  ~BufMgr();
+  ~BufMgrT();
 
 	/**
 	 * Reads the given page from the file into a frame and returns the pointer to page.
@@ -222,8 +658,38 @@ class BufMgr
 	 * @param file   	File object
 	 * @param PageNo  Page number in the file to be read
 	 * @param page  	Reference to page pointer. Used to fetch the Page object in which requested page from file is read in.
+	 * @param hint   	Expected use of the page; see AccessHint
 	 */
-  void readPage(File* file, const PageId PageNo, Page*& page);
+  void readPage(File* file, const PageId PageNo, Page*& page, const AccessHint hint = HINT_NORMAL);
+
+	/**
+	 * Asynchronous variant of readPage() for coroutines run by an EventLoop:
+	 * "PageGuard guard = co_await bufMgr->readPageAsync(file, PageNo);".  A resident page is
+	 * pinned without suspending.  On a miss the coroutine suspends while the loop's I/O threads
+	 * read the page straight into a reserved frame, so other coroutines keep running and their
+	 * misses overlap; concurrent requests for the same page share a single read.  Only BufMgr has
+	 * it, since the event loop works with BufMgr.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @return  Awaitable producing a PageGuard that unpins the page when it goes out of scope
+	 */
+  ReadPageAwaiter readPageAsync(File* file, const PageId PageNo)
+    requires std::is_same_v<BufMgrT, BufMgr>;
+
+	/**
+	 * Reads several pages of a file, like calling readPage() for each of them.  The pages already
+	 * in the buffer pool are found with one BufHashTbl::lookupBatch() and their frame descriptors
+	 * are prefetched before they are pinned, so the cache misses of the probes overlap.  Missing
+	 * pages are then read one by one.  If reading a page fails, every page pinned by the call is
+	 * unpinned again before the exception is rethrown.
+	 *
+	 * @param file   	File object
+	 * @param PageNos Page numbers in the file to be read
+	 * @param count  	Number of pages
+	 * @param pages  	Receives a pointer to the frame of every page
+	 */
+  void readPages(File* file, const PageId* PageNos, const std::size_t count, Page** pages);
 
 	/**
 	 * Unpin a page from memory since it is no longer required for it to remain in memory.
@@ -231,9 +697,21 @@ class BufMgr
 	 * @param file   	File object
 	 * @param PageNo  Page number
 	 * @param dirty		True if the page to be unpinned needs to be marked dirty	
+	 * @param hint   	Expected use of the page; HINT_NORMAL leaves the hint given when pinning
    * @throws  PageNotPinnedException If the page is not already pinned
 	 */
-  void unPinPage(File* file, const PageId PageNo, const bool dirty);
+  void unPinPage(File* file, const PageId PageNo, const bool dirty, const AccessHint hint = HINT_NORMAL);
+
+	/**
+	 * Lower the recovery LSN of a pinned page to the LSN of the oldest logged change it holds.  Pinning sets it to
+	 * the end of the log, which is right for changes made afterwards but not for changes that recovery re-applies
+	 * from older log records.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number
+	 * @param recLsn	LSN of the oldest change on the page not yet on disk
+	 */
+  void lowerRecLsn(const File* file, const PageId PageNo, const Lsn recLsn);
 
 	/**
 	 * Allocates a new, empty page in the file and returns the Page object.
@@ -242,11 +720,24 @@ class BufMgr
 	 * @param file   	File object
 	 * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
 	 * @param page  	Reference to page pointer. The newly allocated in-memory Page object is returned via this reference.
+	 * @param hint   	Expected use of the page; see AccessHint
+	 */
+  void allocPage(File* file, PageId &PageNo, Page*& page, const AccessHint hint = HINT_NORMAL); 
+
+	/**
+	 * Like allocPage(), but the page is always added at the end of the file (see File::appendPage()), so pages
+	 * appended one after the other are consecutive in the file even when it has free pages.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
+	 * @param page  	Reference to page pointer. The newly allocated in-memory Page object is returned via this reference.
+	 * @param hint   	Expected use of the page; see AccessHint
 	 */
-  void allocPage(File* file, PageId &PageNo, Page*& page); 
+  void appendPage(File* file, PageId &PageNo, Page*& page, const AccessHint hint = HINT_NORMAL);
 
 	/**
-	 * Writes out all dirty pages of the file to disk.
+	 * Writes out all dirty pages of the file to disk and then calls File::sync(), so the pages are as durable as the
+	 * file's durability mode promises.
 	 * All the frames assigned to the file need to be unpinned from buffer pool before this function can be successfully called.
 	 * Otherwise Error returned.
 	 *
@@ -256,6 +747,15 @@ class BufMgr
 	 */
   void flushFile(const File* file);
 
+	/**
+	 * Writes out one page if it is dirty and then calls File::sync().  Unlike flushFile() the page stays in the
+	 * buffer pool and may be pinned.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number
+	 */
+  void flushPage(const File* file, const PageId PageNo);
+
 	/**
 	 * Delete page from file and also from buffer pool if present.
 	 * Since the page is entirely deleted from file, its unnecessary to see if the page is dirty.
@@ -271,6 +771,180 @@ class BufMgr
   void  printSelf();
 
 	/**
+	 * Enforce the write-ahead logging rule with the given log manager: before a dirty page is written back, the log
+	 * is flushed up to that page's LSN.  Passing NULL disables the check.
+	 *
+	 * @param log   	Log manager, or NULL
+	 */
+  void setLogManager(LogManager* log)
+  {
+		std::lock_guard<Latching> guard(latch);
+		logManager = log;
+  }
+
+	/**
+	 * Protect write-backs against torn pages with the given double-write buffer.  Pages written back together by
+	 * flushFile(), writeBackDirty() or the destructor form one batch; a dirty page being replaced is written back in
+	 * a batch with the dirty pages due to be replaced after it.  Passing NULL writes pages in place directly.
+	 *
+	 * @param dwb   	Double-write buffer, or NULL
+	 */
+  void setDoubleWriteBuffer(DoubleWriteBuffer* dwb);
+
+	/**
+	 * Keep unpinned pages in a buffer pool shared with other processes instead of in this one.  A page is read
+	 * through the shared pool and holds a frame here only while it is pinned; when its last pin is dropped, a dirty
+	 * page is stored in the shared pool as dirty and the frame is freed.  flushFile(), flushPage(), getDirtyPages(),
+	 * copyDirtyPages() and writeBackDirty() include the dirty pages of the shared pool, and disposed pages are dropped
+	 * from it.  readPageAsync() reads through it at once, without suspending.  The pool must be set while no page is
+	 * in this one; passing NULL stops using it.
+	 *
+	 * @param cache   	Shared buffer pool, or NULL
+	 */
+  void setSharedCache(SharedPageCache* cache)
+  {
+		std::lock_guard<Latching> guard(latch);
+		sharedCache = cache;
+  }
+
+	/**
+	 * Choose the frames to replace with a replacement policy instead of the clock algorithm.  The policy is reset
+	 * and told about the pages already in the buffer pool; it must stay alive while it is set.  Passing NULL
+	 * returns to the clock algorithm.  Only a BufMgrT with DynamicPolicy has it.
+	 *
+	 * @param replacementPolicy	Replacement policy, or NULL
+	 */
+  void setReplacementPolicy(ReplacementPolicy* replacementPolicy)
+    requires std::is_same_v<Policy, DynamicPolicy>;
+
+	/**
+	 * Filter the pages entering the main part of the buffer pool by their estimated frequency (W-TinyLFU).  A missed
+	 * page that needs another page replaced enters a small LRU window.  Once the window is full, its least recently
+	 * used page is admitted over the victim of the replacement policy only if the filter estimates it to be more
+	 * frequent; otherwise it is the page replaced.  The filter must stay alive while it is set.  Passing NULL admits
+	 * every page again.
+	 *
+	 * @param filter   	Admission filter, or NULL
+	 */
+  void setAdmissionFilter(TinyLfu* filter);
+
+	/**
+	 * Collect the dirty page table: one entry with the recovery LSN for every dirty frame.
+	 *
+	 * @param dirtyPages	Vector receiving the entries
+	 */
+  void getDirtyPages(std::vector<DirtyPageEntry>& dirtyPages);
+
+	/**
+	 * Copy the dirty pages of a file as they are in the buffer pool, i.e. the versions newer than those on disk.
+	 *
+	 * @param file   	File object
+	 * @param pages		Vector receiving the copies
+	 */
+  void copyDirtyPages(const File* file, std::vector<Page>& pages);
+
+	/**
+	 * Write back up to maxPages dirty, unpinned frames whose recovery LSN is below recLsnLimit.  The chosen frames
+	 * are written in (file, page number) order so that the writes are as sequential as possible; the frames stay
+	 * in the buffer pool as clean pages.
+	 *
+	 * @param recLsnLimit	Only frames dirtied before this LSN are written
+	 * @param maxPages		Maximum number of frames to write
+	 * @return 						Number of frames written
+	 */
+  std::uint32_t writeBackDirty(Lsn recLsnLimit, std::uint32_t maxPages);
+
+	/**
+	 * Make the calling thread behave as if it ran on the given NUMA node when choosing and accounting frames.
+	 * Passing -1 restores the node reported by the kernel.
+	 *
+	 * @param node   	NUMA node, or -1
+	 */
+  static void setThreadNode(int node)
+  {
+		bufMgrThreadNode = node;
+  }
+
+	/**
+	 * Get the number of NUMA partitions.
+	 */
+  std::uint32_t getNumPartitions() const
+  {
+		return numPartitions;
+  }
+
+	/**
+	 * Get the partition a frame belongs to.
+	 *
+	 * @param frame   Frame number
+	 */
+  std::uint32_t partitionOf(FrameId frame) const
+  {
+		return frame / partitionSize;
+  }
+
+	/**
+	 * Get the memory holding the page data of a partition's frames.
+	 *
+	 * @param partition   Partition number
+	 */
+  const FrameArena& getPartitionArena(std::uint32_t partition) const
+  {
+		return *arenas[partition];
+  }
+
+	/**
+	 * Whether the partitions are bound to real NUMA nodes rather than simulated.
+	 */
+  bool arePartitionsBound() const
+  {
+		return partitionsBound;
+  }
+
+	/**
+	 * Create a tenant of the buffer pool.  A tenant never holds more than maxFrames frames: once it has that many its
+	 * misses replace its own pages.  Its pages are not replaced for other tenants while it holds minFrames or fewer;
+	 * misses take free frames first and then frames of tenants above their minimum.  The minimum is not set aside,
+	 * so frames a tenant does not use remain available to everybody.
+	 *
+	 * @param name   	Name of the tenant
+	 * @param minFrames Frames protected from other tenants
+	 * @param maxFrames Frames the tenant may hold at most
+	 * @return  Identifier of the new tenant
+	 * @throws  InvalidQuotaException If minFrames > maxFrames, maxFrames is 0, or the minimums of all tenants exceed
+	 *                                the pool size
+	 */
+  TenantId createTenant(const std::string& name, std::uint32_t minFrames, std::uint32_t maxFrames);
+
+	/**
+	 * Charge the pages of a file read from now on to a tenant.  Files not assigned to a tenant are charged to the
+	 * default tenant 0, which has no minimum and may use the whole pool.
+	 *
+	 * @param file   	File object
+	 * @param tenant 	Tenant identifier
+	 * @throws  InvalidQuotaException If the tenant does not exist
+	 */
+  void assignFile(const File* file, TenantId tenant);
+
+	/**
+	 * Get the number of tenants, including the default one.
+	 */
+  std::uint32_t getNumTenants() const
+  {
+		return tenants.size();
+  }
+
+	/**
+	 * Get quotas and statistics of a tenant.
+	 *
+	 * @param tenant 	Tenant identifier
+	 */
+  const TenantStats& getTenantStats(TenantId tenant) const
+  {
+		return tenants[tenant];
+  }
+
+	/**
    * Get buffer pool usage statistics
 	 */
   BufStats & getBufStats()
@@ -283,7 +957,10 @@ class BufMgr
 	 */
   void clearBufStats() 
   {
+		std::lock_guard<Latching> guard(latch);
 		bufStats.clear();
+		for (std::size_t i = 0; i < tenants.size(); i++)
+			tenants[i].hits = tenants[i].misses = 0;
   }
 };
 
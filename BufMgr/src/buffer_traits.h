@@ -0,0 +1,115 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "replacement_policy.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Compile-time replacement policy of BufMgrT: the built-in clock.
+ *
+ * A Policy of BufMgrT has the member functions of ReplacementPolicy, but they
+ * are called on the exact type, so they are inlined, plus active(), which
+ * tells whether pickVictim() chooses victims at all or the built-in clock
+ * does.  Everything here is empty, so the compiler removes the calls.
+ */
+class ClockPolicy {
+ public:
+  bool active() const { return false; }
+  void reset(const std::uint32_t) {}
+  void pageInstalled(const FrameId) {}
+  void pageAccessed(const FrameId) {}
+  void pageHinted(const FrameId, const AccessHint) {}
+  void pageRemoved(const FrameId) {}
+  bool pickVictim(const ReplacementPolicy::Evictable&, FrameId&) {
+    return false;
+  }
+};
+
+/**
+ * @brief Compile-time replacement policy of BufMgrT that forwards to a
+ *        ReplacementPolicy chosen at run time, or uses the clock if none is
+ *        set (see BufMgrT::setReplacementPolicy()).
+ *
+ * This is the policy of BufMgr.  Every hook costs a test of the pointer and,
+ * with a policy set, a virtual call.
+ */
+class DynamicPolicy {
+ public:
+  DynamicPolicy() : policy_(NULL) {}
+
+  /**
+   * Returns the policy, or NULL.
+   */
+  ReplacementPolicy* get() const { return policy_; }
+  void set(ReplacementPolicy* policy) { policy_ = policy; }
+
+  bool active() const { return policy_ != NULL; }
+  void reset(const std::uint32_t frames) {
+    if (policy_ != NULL) policy_->reset(frames);
+  }
+  void pageInstalled(const FrameId frame) {
+    if (policy_ != NULL) policy_->pageInstalled(frame);
+  }
+  void pageAccessed(const FrameId frame) {
+    if (policy_ != NULL) policy_->pageAccessed(frame);
+  }
+  void pageHinted(const FrameId frame, const AccessHint hint) {
+    if (policy_ != NULL) policy_->pageHinted(frame, hint);
+  }
+  void pageRemoved(const FrameId frame) {
+    if (policy_ != NULL) policy_->pageRemoved(frame);
+  }
+  bool pickVictim(const ReplacementPolicy::Evictable& evictable,
+                  FrameId& frame) {
+    return policy_ != NULL && policy_->pickVictim(evictable, frame);
+  }
+
+ private:
+  ReplacementPolicy* policy_;
+};
+
+/**
+ * @brief Latching of BufMgrT for a buffer pool used by a single thread: no
+ *        synchronization at all.
+ */
+class NoLatching {
+ public:
+  void lock() {}
+  void unlock() {}
+};
+
+/**
+ * @brief Latching of BufMgrT for a buffer pool shared by threads: one
+ *        test-and-test-and-set spin latch around every page operation.
+ */
+class AtomicLatching {
+ public:
+  AtomicLatching() : locked_(false) {}
+
+  void lock() {
+    while (locked_.exchange(true, std::memory_order_acquire)) {
+      while (locked_.load(std::memory_order_relaxed)) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  void unlock() { locked_.store(false, std::memory_order_release); }
+
+ private:
+  std::atomic<bool> locked_;
+};
+
+}
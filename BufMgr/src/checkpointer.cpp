@@ -0,0 +1,61 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "checkpointer.h"
+
+#include <vector>
+
+namespace badgerdb {
+
+Checkpointer::Checkpointer(BufMgr* buf_mgr, LogManager* log,
+                           const Lsn max_log_distance,
+                           const std::uint32_t pages_per_step)
+    : buf_mgr_(buf_mgr),
+      log_(log),
+      max_log_distance_(max_log_distance),
+      pages_per_step_(pages_per_step),
+      pages_written_(0) {
+}
+
+bool Checkpointer::step() {
+  const Lsn end = log_->nextLsn();
+  // Pages dirtied in the older half of the allowed window get written now, so
+  // they are clean well before they would push redo past the bound.
+  if (end > max_log_distance_ / 2) {
+    pages_written_ +=
+        buf_mgr_->writeBackDirty(end - max_log_distance_ / 2, pages_per_step_);
+  }
+  const Lsn last = log_->checkpointLsn();
+  if (end - (last == 0 ? LogManager::firstLsn() : last) >= max_log_distance_) {
+    checkpoint();
+    return true;
+  }
+  return false;
+}
+
+Lsn Checkpointer::checkpoint() {
+  std::vector<DirtyPageEntry> dirty_pages;
+  buf_mgr_->getDirtyPages(dirty_pages);
+  return log_->logCheckpoint(dirty_pages);
+}
+
+Lsn Checkpointer::redoLsn() {
+  Lsn redo = log_->checkpointLsn();
+  if (redo == 0) {
+    redo = LogManager::firstLsn();
+  }
+  std::vector<DirtyPageEntry> dirty_pages;
+  buf_mgr_->getDirtyPages(dirty_pages);
+  for (std::size_t i = 0; i < dirty_pages.size(); ++i) {
+    if (dirty_pages[i].rec_lsn < redo) {
+      redo = dirty_pages[i].rec_lsn;
+    }
+  }
+  return redo;
+}
+
+}
@@ -0,0 +1,84 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "buffer.h"
+#include "log_manager.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Fuzzy checkpointing and incremental write-back for a no-force buffer
+ *        pool.
+ *
+ * With a write-ahead log, committed changes only need to be in the log, so
+ * dirty pages can stay in the buffer pool and absorb many updates before they
+ * are written.  What bounds recovery time is how far back in the log redo has
+ * to start: at the oldest recovery LSN of any dirty page.  The checkpointer
+ * keeps that distance below <max_log_distance> bytes by
+ *
+ * - writing back, a few pages at a time and in (file, page) order, the dirty
+ *   pages whose recovery LSN falls too far behind the end of the log, and
+ * - logging a fuzzy checkpoint (active transactions and dirty page table,
+ *   without flushing anything) whenever the log has grown by
+ *   <max_log_distance> bytes since the previous one.
+ *
+ * BufMgr is not threadsafe, so the checkpointer does not own a thread: the
+ * thread driving the buffer manager calls step() between its own requests.
+ * Each step writes at most <pages_per_step> pages, so readPage() and
+ * unPinPage() are never held up for longer than that.
+ */
+class Checkpointer {
+ public:
+  /**
+   * Constructs a checkpointer.
+   *
+   * @param buf_mgr           Buffer manager whose dirty pages are written.
+   * @param log               Log manager set on <buf_mgr>.
+   * @param max_log_distance  Target bound, in log bytes, on the redo work.
+   * @param pages_per_step    Maximum number of pages written by one step().
+   */
+  Checkpointer(BufMgr* buf_mgr, LogManager* log, const Lsn max_log_distance,
+               const std::uint32_t pages_per_step);
+
+  /**
+   * Performs one increment of background work: writes back a batch of old
+   * dirty pages and takes a checkpoint if one is due.
+   *
+   * @return  True if a checkpoint was taken.
+   */
+  bool step();
+
+  /**
+   * Takes a fuzzy checkpoint right away.
+   *
+   * @return  LSN of the checkpoint record.
+   */
+  Lsn checkpoint();
+
+  /**
+   * Returns the LSN at which redo would start if the system crashed now.
+   */
+  Lsn redoLsn();
+
+  /**
+   * Returns the number of pages written back by step() so far.
+   */
+  std::uint64_t pagesWritten() const { return pages_written_; }
+
+ private:
+  BufMgr* buf_mgr_;
+  LogManager* log_;
+  Lsn max_log_distance_;
+  std::uint32_t pages_per_step_;
+  std::uint64_t pages_written_;
+};
+
+}
@@ -0,0 +1,99 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BADGERDB_CRC32C_SSE42 1
+#include <nmmintrin.h>
+#endif
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Reflected CRC32C polynomial.
+ */
+const std::uint32_t POLYNOMIAL = 0x82F63B78;
+
+struct Table {
+  std::uint32_t entries[256];
+
+  Table() {
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      std::uint32_t crc = i;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc >> 1) ^ ((crc & 1) ? POLYNOMIAL : 0);
+      }
+      entries[i] = crc;
+    }
+  }
+};
+
+const Table table;
+
+#ifdef BADGERDB_CRC32C_SSE42
+__attribute__((target("sse4.2")))
+std::uint32_t crc32cHardware(const void* data, std::size_t length,
+                             const std::uint32_t crc) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  std::uint64_t state = ~crc;
+  while (length >= sizeof(std::uint64_t)) {
+    std::uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    state = _mm_crc32_u64(state, word);
+    bytes += sizeof(word);
+    length -= sizeof(word);
+  }
+  std::uint32_t state32 = static_cast<std::uint32_t>(state);
+  while (length > 0) {
+    state32 = _mm_crc32_u8(state32, *bytes);
+    ++bytes;
+    --length;
+  }
+  return ~state32;
+}
+
+const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+#endif
+
+}
+
+std::uint32_t crc32cSoftware(const void* data, std::size_t length,
+                             const std::uint32_t crc) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  std::uint32_t state = ~crc;
+  while (length > 0) {
+    state = table.entries[(state ^ *bytes) & 0xFF] ^ (state >> 8);
+    ++bytes;
+    --length;
+  }
+  return ~state;
+}
+
+std::uint32_t crc32c(const void* data, const std::size_t length,
+                     const std::uint32_t crc) {
+#ifdef BADGERDB_CRC32C_SSE42
+  if (has_sse42) {
+    return crc32cHardware(data, length, crc);
+  }
+#endif
+  return crc32cSoftware(data, length, crc);
+}
+
+bool crc32cHardwareAvailable() {
+#ifdef BADGERDB_CRC32C_SSE42
+  return has_sse42;
+#else
+  return false;
+#endif
+}
+
+}
@@ -0,0 +1,41 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace badgerdb {
+
+/**
+ * Computes the CRC32C (Castagnoli) checksum of a buffer.  Uses the SSE4.2
+ * crc32 instruction when the CPU supports it and a table-driven
+ * implementation otherwise.  Checksums of consecutive pieces can be chained by
+ * passing the result for the previous piece as <crc>.
+ *
+ * @param data    Bytes to checksum.
+ * @param length  Number of bytes.
+ * @param crc     Checksum of the preceding bytes, or 0.
+ * @return  Checksum of all bytes so far.
+ */
+std::uint32_t crc32c(const void* data, const std::size_t length,
+                     const std::uint32_t crc = 0);
+
+/**
+ * Table-driven CRC32C, always available.  Produces the same values as
+ * crc32c().
+ */
+std::uint32_t crc32cSoftware(const void* data, const std::size_t length,
+                             const std::uint32_t crc = 0);
+
+/**
+ * Returns true if crc32c() uses the hardware instruction on this CPU.
+ */
+bool crc32cHardwareAvailable();
+
+}
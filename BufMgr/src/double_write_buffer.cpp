@@ -0,0 +1,271 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "double_write_buffer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <set>
+#include <unistd.h>
+
+#include "exceptions/file_io_exception.h"
+#include "exceptions/invalid_page_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Identifies a double-write file.
+ */
+const std::uint64_t DWB_MAGIC = 0x4257444742444742ULL;
+
+/**
+ * Start of the double-write file.  <count> is 0 when the file holds no batch
+ * that may still be needed.
+ */
+struct DwbHeader {
+  std::uint64_t magic;
+  std::uint32_t count;
+  std::uint32_t reserved;
+};
+
+/**
+ * Prefix of every page entry; the file name and the page image follow.
+ */
+struct EntryHeader {
+  std::uint64_t checksum;
+  PageId page_number;
+  std::uint32_t filename_length;
+};
+
+const std::size_t IMAGE_SIZE = sizeof(PageHeader) + Page::DATA_SIZE;
+
+bool readFully(const int fd, void* buffer, const std::size_t length,
+               const off_t offset) {
+  std::size_t done = 0;
+  while (done < length) {
+    const ssize_t n = ::pread(fd, static_cast<char*>(buffer) + done,
+                              length - done, offset + done);
+    if (n <= 0) {
+      return false;
+    }
+    done += n;
+  }
+  return true;
+}
+
+void writeFully(const int fd, const std::string& filename, const void* buffer,
+                const std::size_t length, const off_t offset) {
+  std::size_t done = 0;
+  while (done < length) {
+    const ssize_t n = ::pwrite(fd, static_cast<const char*>(buffer) + done,
+                               length - done, offset + done);
+    if (n < 0) {
+      throw FileIOException(filename, "pwrite", errno);
+    }
+    done += n;
+  }
+}
+
+}
+
+DoubleWriteBuffer::DoubleWriteBuffer(const std::string& filename,
+                                     const std::uint32_t batch_pages)
+    : filename_(filename),
+      fd_(-1),
+      batch_pages_(batch_pages == 0 ? 1 : batch_pages),
+      batches_(0),
+      pages_(0),
+      syncs_(0) {
+  fd_ = ::open(filename_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    throw FileIOException(filename_, "open", errno);
+  }
+}
+
+DoubleWriteBuffer::~DoubleWriteBuffer() {
+  try {
+    flush();
+  } catch (FileIOException&) {
+  } catch (InvalidPageException&) {
+  }
+  ::close(fd_);
+}
+
+void DoubleWriteBuffer::write(File* file, const Page& page) {
+  // A page written twice within one batch only needs its latest version.
+  for (std::size_t i = 0; i < pending_.size(); ++i) {
+    if (pending_[i].file->filename() == file->filename() &&
+        pending_[i].page.page_number() == page.page_number()) {
+      pending_[i].page = page;
+      return;
+    }
+  }
+  PendingPage pending = {file, page};
+  pending_.push_back(pending);
+  if (pending_.size() >= batch_pages_) {
+    flush();
+  }
+}
+
+void DoubleWriteBuffer::flush() {
+  if (pending_.empty()) {
+    return;
+  }
+  std::vector<PendingPage> batch;
+  batch.swap(pending_);
+  std::sort(batch.begin(), batch.end(),
+            [](const PendingPage& lhs, const PendingPage& rhs) {
+              if (lhs.file->filename() != rhs.file->filename()) {
+                return lhs.file->filename() < rhs.file->filename();
+              }
+              return lhs.page.page_number() < rhs.page.page_number();
+            });
+
+  // Build the exact images that will be written in place, with the next page
+  // pointers currently on disk, so that repair() reproduces them faithfully.
+  const DwbHeader header = {DWB_MAGIC,
+                            static_cast<std::uint32_t>(batch.size()), 0};
+  std::string buffer(reinterpret_cast<const char*>(&header), sizeof(header));
+  std::vector<PageHeader> headers;
+  for (std::size_t i = 0; i < batch.size(); ++i) {
+    const Page& page = batch[i].page;
+    PageHeader page_header =
+        batch[i].file->readPageHeader(page.page_number());
+    if (page_header.current_page_number == Page::INVALID_NUMBER) {
+      throw InvalidPageException(page.page_number(),
+                                 batch[i].file->filename());
+    }
+    const PageId next_page_number = page_header.next_page_number;
+    page_header = page.header_;
+    page_header.next_page_number = next_page_number;
+    headers.push_back(page_header);
+
+    std::string image(reinterpret_cast<const char*>(&page_header),
+                      sizeof(page_header));
+    image.append(page.data_.data(), page.data_.size());
+    const std::string& filename = batch[i].file->filename();
+    const EntryHeader entry = {checksum(filename, page.page_number(), image),
+                               page.page_number(),
+                               static_cast<std::uint32_t>(filename.size())};
+    buffer.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    buffer.append(filename);
+    buffer.append(image);
+  }
+
+  // 1. One sequential write of the whole batch, made durable.
+  writeFully(fd_, filename_, buffer.data(), buffer.size(), 0);
+  if (::fdatasync(fd_) != 0) {
+    throw FileIOException(filename_, "fdatasync", errno);
+  }
+  ++syncs_;
+
+  // 2. The in-place writes, made durable per file.
+  std::set<std::string> synced;
+  for (std::size_t i = 0; i < batch.size(); ++i) {
+    File* file = batch[i].file;
+    file->writePage(batch[i].page.page_number(), headers[i], batch[i].page);
+  }
+  for (std::size_t i = 0; i < batch.size(); ++i) {
+    File* file = batch[i].file;
+    if (synced.insert(file->filename()).second) {
+      file->stream_->flush();
+      if (::fdatasync(file->descriptor()) != 0) {
+        throw FileIOException(file->filename(), "fdatasync", errno);
+      }
+      ++syncs_;
+    }
+  }
+
+  // 3. The batch is no longer needed; later writes to the same pages must not
+  // be undone by a repair after the next crash.
+  clear();
+  ++syncs_;
+  ++batches_;
+  pages_ += batch.size();
+}
+
+std::uint32_t DoubleWriteBuffer::repair(const FileMap& files) {
+  DwbHeader header;
+  if (!readFully(fd_, &header, sizeof(header), 0) ||
+      header.magic != DWB_MAGIC || header.count == 0) {
+    return 0;
+  }
+
+  std::uint32_t restored = 0;
+  std::set<File*> touched;
+  off_t offset = sizeof(header);
+  for (std::uint32_t i = 0; i < header.count; ++i) {
+    EntryHeader entry;
+    if (!readFully(fd_, &entry, sizeof(entry), offset)) {
+      break;
+    }
+    offset += sizeof(entry);
+    std::string filename(entry.filename_length, '\0');
+    std::string image(IMAGE_SIZE, '\0');
+    if (!readFully(fd_, &filename[0], filename.size(), offset) ||
+        !readFully(fd_, &image[0], image.size(), offset + filename.size())) {
+      break;
+    }
+    offset += filename.size() + image.size();
+    if (entry.checksum != checksum(filename, entry.page_number, image)) {
+      // Torn while being written to the double-write file; the page in place
+      // was not touched yet.
+      continue;
+    }
+    FileMap::const_iterator file = files.find(filename);
+    if (file == files.end()) {
+      continue;
+    }
+    Page page;
+    std::memcpy(&page.header_, image.data(), sizeof(page.header_));
+    page.data_.assign(image.data() + sizeof(page.header_),
+                      image.size() - sizeof(page.header_));
+    file->second->writePage(entry.page_number, page.header_, page);
+    touched.insert(file->second);
+    ++restored;
+  }
+  for (std::set<File*>::iterator iter = touched.begin(); iter != touched.end();
+       ++iter) {
+    (*iter)->stream_->flush();
+    if (::fdatasync((*iter)->descriptor()) != 0) {
+      throw FileIOException((*iter)->filename(), "fdatasync", errno);
+    }
+  }
+  clear();
+  return restored;
+}
+
+void DoubleWriteBuffer::clear() {
+  const DwbHeader header = {DWB_MAGIC, 0 /* count */, 0};
+  writeFully(fd_, filename_, &header, sizeof(header), 0);
+  if (::fdatasync(fd_) != 0) {
+    throw FileIOException(filename_, "fdatasync", errno);
+  }
+}
+
+std::uint64_t DoubleWriteBuffer::checksum(const std::string& filename,
+                                          const PageId page_number,
+                                          const std::string& image) {
+  // FNV-1a over the file name, page number and image.
+  std::uint64_t hash = 14695981039346656037ULL;
+  const auto mix = [&hash](const char* data, const std::size_t length) {
+    for (std::size_t i = 0; i < length; ++i) {
+      hash ^= static_cast<unsigned char>(data[i]);
+      hash *= 1099511628211ULL;
+    }
+  };
+  mix(filename.data(), filename.size());
+  mix(reinterpret_cast<const char*>(&page_number), sizeof(page_number));
+  mix(image.data(), image.size());
+  return hash;
+}
+
+}
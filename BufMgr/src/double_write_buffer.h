@@ -0,0 +1,142 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "file.h"
+#include "page.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Batched double-write area protecting pages against torn writes.
+ *
+ * A Page is larger than the unit the storage device writes atomically, so a
+ * crash in the middle of File::writePage() can leave a page that is half old
+ * and half new, which no log can repair.  With a double-write buffer, pages
+ * are not written in place directly.  They are collected into a batch; the
+ * batch is written sequentially to the double-write file and synced once;
+ * only then are the pages written to their real locations and the data files
+ * synced; finally the double-write file is marked empty.  After a crash,
+ * repair() copies every intact page of a non-empty double-write file back in
+ * place, which fixes any page torn during the second step.  A torn entry in
+ * the double-write file itself is detected by its checksum and ignored, since
+ * its in-place copy was not touched yet.
+ *
+ * The cost is one extra sequential write and two small syncs per batch
+ * rather than per page, so pages should be written in batches as large as
+ * possible (see BufMgr::setDoubleWriteBuffer()).
+ *
+ * @warning This class is not threadsafe.
+ */
+class DoubleWriteBuffer {
+ public:
+  /**
+   * Open files repair() may write to, keyed by file name.
+   */
+  typedef std::map<std::string, File*> FileMap;
+
+  /**
+   * Opens (or creates) the double-write file.  Call repair() before writing
+   * any page if the file may be left over from a crash.
+   *
+   * @param filename      Name of the double-write file.
+   * @param batch_pages   Number of pages after which a batch is written out.
+   * @throws  FileIOException   If the file cannot be opened.
+   */
+  DoubleWriteBuffer(const std::string& filename,
+                    const std::uint32_t batch_pages);
+
+  /**
+   * Writes out the pending batch and closes the double-write file.  A batch
+   * that fails to be written is dropped; call flush() first to see the error.
+   */
+  ~DoubleWriteBuffer();
+
+  /**
+   * Adds a page to the current batch, writing the batch out if it is full.
+   * Like File::writePage(), the page must be allocated in <file>; the next
+   * page pointer on disk is preserved.
+   *
+   * @param file  File the page belongs to.
+   * @param page  Page to write.
+   */
+  void write(File* file, const Page& page);
+
+  /**
+   * Writes out the current batch, if any, following the protocol described
+   * above.  On return all pages given to write() are durable in place.
+   *
+   * @throws  FileIOException   If writing or syncing fails.
+   */
+  void flush();
+
+  /**
+   * Restores in place every intact page recorded in the double-write file and
+   * then marks it empty.  Pages of files not in <files> are skipped.
+   *
+   * @param files   Open data files keyed by name.
+   * @return  Number of pages restored.
+   */
+  std::uint32_t repair(const FileMap& files);
+
+  /**
+   * Returns the number of batches written so far.
+   */
+  std::uint64_t batchCount() const { return batches_; }
+
+  /**
+   * Returns the number of pages written through the buffer so far.
+   */
+  std::uint64_t pageCount() const { return pages_; }
+
+  /**
+   * Returns the number of fdatasync() calls made for batches so far.
+   */
+  std::uint64_t syncCount() const { return syncs_; }
+
+  /**
+   * Returns the number of pages after which a batch is written out.
+   */
+  std::uint32_t batchPages() const { return batch_pages_; }
+
+ private:
+  /**
+   * A page waiting in the current batch.
+   */
+  struct PendingPage {
+    File* file;
+    Page page;
+  };
+
+  /**
+   * Marks the double-write file empty and syncs it.
+   */
+  void clear();
+
+  /**
+   * Checksum of a double-write entry.
+   */
+  static std::uint64_t checksum(const std::string& filename,
+                                const PageId page_number,
+                                const std::string& image);
+
+  std::string filename_;
+  int fd_;
+  std::uint32_t batch_pages_;
+  std::vector<PendingPage> pending_;
+  std::uint64_t batches_;
+  std::uint64_t pages_;
+  std::uint64_t syncs_;
+};
+
+}
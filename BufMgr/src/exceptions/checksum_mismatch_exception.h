@@ -0,0 +1,64 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a page read from disk does not match
+ *        the checksum stored in its header.
+ */
+class ChecksumMismatchException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a checksum mismatch exception for the given page.
+   *
+   * @param name          Name of file the page was read from.
+   * @param page_number   Number of the corrupted page.
+   * @param stored        Checksum stored in the page header.
+   * @param computed      Checksum computed over the page as read.
+   */
+  ChecksumMismatchException(const std::string& name, const PageId page_number,
+                            const std::uint32_t stored,
+                            const std::uint32_t computed);
+
+  /**
+   * Destroys the exception.  Does nothing special; just included to make the
+   * compiler happy.
+   */
+  virtual ~ChecksumMismatchException() throw() {}
+
+  /**
+   * Returns the name of the file the page was read from.
+   */
+  virtual const std::string& filename() const { return filename_; }
+
+  /**
+   * Returns the number of the corrupted page.
+   */
+  virtual PageId page_number() const { return page_number_; }
+
+ protected:
+  /**
+   * Name of file the page was read from.
+   */
+  const std::string filename_;
+
+  /**
+   * Number of the corrupted page.
+   */
+  const PageId page_number_;
+};
+
+}
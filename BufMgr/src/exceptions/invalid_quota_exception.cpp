@@ -0,0 +1,23 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "invalid_quota_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+InvalidQuotaException::InvalidQuotaException(const std::string& tenant,
+                                             const std::string& reason)
+    : BadgerDbException("") {
+  std::stringstream ss;
+  ss << "Invalid quota for tenant " << tenant << ": " << reason;
+  message_.assign(ss.str());
+}
+
+}
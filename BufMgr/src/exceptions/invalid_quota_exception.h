@@ -0,0 +1,31 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a buffer pool tenant is created
+ *        with quotas that cannot be honoured, or an unknown tenant is used.
+ */
+class InvalidQuotaException : public BadgerDbException {
+ public:
+  /**
+   * Constructs an invalid quota exception for the given tenant.
+   *
+   * @param tenant  Name or number of the tenant.
+   * @param reason  What is wrong with the request.
+   */
+  InvalidQuotaException(const std::string& tenant, const std::string& reason);
+};
+
+}
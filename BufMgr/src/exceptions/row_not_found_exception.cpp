@@ -0,0 +1,23 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "row_not_found_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+RowNotFoundException::RowNotFoundException(const std::string& name,
+                                           const std::uint64_t row)
+    : BadgerDbException(""), filename_(name), row_(row) {
+  std::stringstream ss;
+  ss << "Row " << row_ << " does not exist in file '" << filename_ << "'";
+  message_.assign(ss.str());
+}
+
+}
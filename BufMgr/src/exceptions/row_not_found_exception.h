@@ -0,0 +1,54 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a row of a log-structured heap is
+ *        requested that does not exist or has been removed.
+ */
+class RowNotFoundException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a row not found exception for the given row.
+   *
+   * @param name  Name of the heap file.
+   * @param row   Requested row.
+   */
+  RowNotFoundException(const std::string& name, const std::uint64_t row);
+
+  /**
+   * Destroys the exception.  Does nothing special; just included to make the
+   * compiler happy.
+   */
+  virtual ~RowNotFoundException() throw() {}
+
+  /**
+   * Returns the requested row.
+   */
+  virtual std::uint64_t row() const { return row_; }
+
+ protected:
+  /**
+   * Name of the heap file.
+   */
+  const std::string filename_;
+
+  /**
+   * Requested row.
+   */
+  const std::uint64_t row_;
+};
+
+}
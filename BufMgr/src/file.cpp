@@ -11,10 +11,22 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
 #include <cstdio>
 #include <cassert>
-
+#include <cerrno>
+#include <cstddef>
+#include <fcntl.h>
+#include <linux/falloc.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "crc32c.h"
+#include "page_codec.h"
+#include "snapshot.h"
+#include "exceptions/checksum_mismatch_exception.h"
 #include "exceptions/file_exists_exception.h"
+#include "exceptions/file_io_exception.h"
 #include "exceptions/file_not_found_exception.h"
 #include "exceptions/file_open_exception.h"
 #include "exceptions/invalid_page_exception.h"
@@ -25,6 +37,7 @@ namespace badgerdb {
 
 File::StreamMap File::open_streams_;
 File::CountMap File::open_counts_;
+File::StateMap File::open_states_;
 
 File File::create(const std::string& filename) {
   return File(filename, true /* create_new */);
@@ -42,6 +55,7 @@ void File::remove(const std::string& filename) {
     throw FileOpenException(filename);
   }
   std::remove(filename.c_str());
+  std::remove(changedPagesName(filename).c_str());
 }
 
 bool File::isOpen(const std::string& filename) {
@@ -83,58 +97,75 @@ File::~File() {
 
 Page File::allocatePage() {
   FileHeader header = readHeader();
-  Page new_page;
+  if (header.num_free_pages == 0) {
+    return appendPage();
+  }
+  Page new_page = readPage(header.first_free_page, true /* allow_free */);
   Page existing_page;
-  if (header.num_free_pages > 0) {
-    new_page = readPage(header.first_free_page, true /* allow_free */);
-    new_page.set_page_number(header.first_free_page);
-    header.first_free_page = new_page.next_page_number();
-    --header.num_free_pages;
-
-    if (header.first_used_page == Page::INVALID_NUMBER ||
-        header.first_used_page > new_page.page_number()) {
-      // Either have no pages used or the head of the used list is a page later
-      // than the one we just allocated, so add the new page to the head.
-      if (header.first_used_page > new_page.page_number()) {
-        new_page.set_next_page_number(header.first_used_page);
-      }
-      header.first_used_page = new_page.page_number();
-    } else {
-      // New page is reused from somewhere after the beginning, so we need to
-      // find where in the used list to insert it.
-      PageId next_page_number = Page::INVALID_NUMBER;
-      for (FileIterator iter = begin(); iter != end(); ++iter) {
-        next_page_number = (*iter).next_page_number();
-        if (next_page_number > new_page.page_number() ||
-            next_page_number == Page::INVALID_NUMBER) {
-          existing_page = *iter;
-          break;
-        }
+  new_page.set_page_number(header.first_free_page);
+  header.first_free_page = new_page.next_page_number();
+  --header.num_free_pages;
+
+  if (header.first_used_page == Page::INVALID_NUMBER ||
+      header.first_used_page > new_page.page_number()) {
+    // Either have no pages used or the head of the used list is a page later
+    // than the one we just allocated, so add the new page to the head.
+    if (header.first_used_page > new_page.page_number()) {
+      new_page.set_next_page_number(header.first_used_page);
+    }
+    header.first_used_page = new_page.page_number();
+  } else {
+    // New page is reused from somewhere after the beginning, so we need to
+    // find where in the used list to insert it.
+    PageId next_page_number = Page::INVALID_NUMBER;
+    // Walk the headers only; just the predecessor needs to be read whole.
+    for (FileIterator iter = begin(); iter != end(); ++iter) {
+      next_page_number =
+          readPageHeader(iter.page_number()).next_page_number;
+      if (next_page_number > new_page.page_number() ||
+          next_page_number == Page::INVALID_NUMBER) {
+        existing_page = *iter;
+        break;
       }
-      existing_page.set_next_page_number(new_page.page_number());
-      new_page.set_next_page_number(next_page_number);
     }
+    existing_page.set_next_page_number(new_page.page_number());
+    new_page.set_next_page_number(next_page_number);
+  }
 
-    assert((header.num_free_pages == 0) ==
-           (header.first_free_page == Page::INVALID_NUMBER));
+  assert((header.num_free_pages == 0) ==
+         (header.first_free_page == Page::INVALID_NUMBER));
+  writePage(new_page.page_number(), new_page);
+  if (existing_page.page_number() != Page::INVALID_NUMBER) {
+    // If we updated an existing page by inserting the new page into the
+    // used list, we need to write it out.
+    writePage(existing_page.page_number(), existing_page);
+  }
+  writeHeader(header);
+
+  return new_page;
+}
+
+Page File::appendPage() {
+  FileHeader header = readHeader();
+  Page new_page;
+  Page existing_page;
+  new_page.set_page_number(header.num_pages);
+  if (header.first_used_page == Page::INVALID_NUMBER) {
+    header.first_used_page = new_page.page_number();
   } else {
-    new_page.set_page_number(header.num_pages);
-    if (header.first_used_page == Page::INVALID_NUMBER) {
-      header.first_used_page = new_page.page_number();
-    } else {
-      // If we have pages allocated, we need to add the new page to the tail
-      // of the linked list.
-      for (FileIterator iter = begin(); iter != end(); ++iter) {
-        if ((*iter).next_page_number() == Page::INVALID_NUMBER) {
-          existing_page = *iter;
-          break;
-        }
+    // If we have pages allocated, we need to add the new page to the tail
+    // of the linked list.
+    for (FileIterator iter = begin(); iter != end(); ++iter) {
+      if (readPageHeader(iter.page_number()).next_page_number ==
+          Page::INVALID_NUMBER) {
+        existing_page = *iter;
+        break;
       }
-      assert(existing_page.isUsed());
-      existing_page.set_next_page_number(new_page.page_number());
     }
-    ++header.num_pages;
+    assert(existing_page.isUsed());
+    existing_page.set_next_page_number(new_page.page_number());
   }
+  ++header.num_pages;
   writePage(new_page.page_number(), new_page);
   if (existing_page.page_number() != Page::INVALID_NUMBER) {
     // If we updated an existing page by inserting the new page into the
@@ -158,14 +189,50 @@ Page File::readPage(const PageId page_number, const bool allow_free) const {
   Page page;
   stream_->seekg(pagePosition(page_number), std::ios::beg);
   stream_->read(reinterpret_cast<char*>(&page.header_), sizeof(page.header_));
-  stream_->read(reinterpret_cast<char*>(&page.data_[0]), Page::DATA_SIZE);
-  if (!allow_free && !page.isUsed()) {
-    throw InvalidPageException(page_number, filename_);
+  const std::uint32_t stored_length = page.header_.stored_length;
+  if (stored_length == 0) {
+    stream_->read(reinterpret_cast<char*>(&page.data_[0]), Page::DATA_SIZE);
+  } else if (stored_length <= Page::DATA_SIZE) {
+    // Only the compressed bytes are read; the rest of the slot is a hole.
+    stream_->read(&page.data_[0], stored_length);
   }
+  finishRead(page, page_number, allow_free);
 
   return page;
 }
 
+void File::finishRead(Page& page, const PageId page_number,
+                      const bool allow_free) const {
+  FileState& state = open_states_[filename_];
+  const std::uint32_t stored_length = page.header_.stored_length;
+  if (stored_length == 0) {
+    state.bytes_read += Page::SIZE;
+  } else {
+    if (stored_length > Page::DATA_SIZE) {
+      throw ChecksumMismatchException(filename_, page_number,
+                                      page.header_.checksum, 0);
+    }
+    const std::string compressed(page.data_.data(), stored_length);
+    if (!lzDecompress(compressed.data(), stored_length, &page.data_[0],
+                      Page::DATA_SIZE)) {
+      throw ChecksumMismatchException(filename_, page_number,
+                                      page.header_.checksum, 0);
+    }
+    state.bytes_read += sizeof(page.header_) + stored_length;
+  }
+  if (state.verify_checksums) {
+    const std::uint32_t computed = pageChecksum(page.header_, page);
+    if (computed != page.header_.checksum) {
+      throw ChecksumMismatchException(filename_, page_number,
+                                      page.header_.checksum, computed);
+    }
+  }
+  page.header_.stored_length = 0;
+  if (!allow_free && !page.isUsed()) {
+    throw InvalidPageException(page_number, filename_);
+  }
+}
+
 void File::writePage(const Page& new_page) {
   PageHeader header = readPageHeader(new_page.page_number());
   if (header.current_page_number == Page::INVALID_NUMBER) {
@@ -204,11 +271,187 @@ void File::deletePage(const PageId page_number) {
   existing_page.set_next_page_number(header.first_free_page);
   header.first_free_page = page_number;
   ++header.num_free_pages;
+  const bool release = open_states_[filename_].release_freed;
+  if (release) {
+    // The released data region reads back as zeros, so the checksum must be
+    // computed over zeros as well.
+    existing_page.data_.assign(Page::DATA_SIZE, '\0');
+  }
   if (previous_page.isUsed()) {
     writePage(previous_page.page_number(), previous_page);
   }
   writePage(page_number, existing_page);
   writeHeader(header);
+  if (release) {
+    stream_->flush();
+    const off_t position = pagePosition(page_number);
+    const off_t data_start =
+        (position + sizeof(PageHeader) + PUNCH_BLOCK_SIZE - 1) /
+        PUNCH_BLOCK_SIZE * PUNCH_BLOCK_SIZE;
+    const off_t slot_end =
+        (position + Page::SIZE) / PUNCH_BLOCK_SIZE * PUNCH_BLOCK_SIZE;
+    punchHole(data_start, slot_end - data_start);
+  }
+}
+
+PageId File::truncateFreeTail() {
+  FileHeader header = readHeader();
+  PageId last_used = 0;
+  for (FileIterator iter = begin(); iter != end(); ++iter) {
+    if (iter.page_number() > last_used) {
+      last_used = iter.page_number();
+    }
+  }
+  const PageId new_num_pages = last_used + 1;
+  if (new_num_pages >= header.num_pages) {
+    return 0;
+  }
+  // Snapshots still read the pages about to be cut off from the file.
+  const std::vector<Snapshot*>& snapshots = open_states_[filename_].snapshots;
+  for (std::size_t i = 0; i < snapshots.size(); ++i) {
+    for (PageId page_number = new_num_pages; page_number < header.num_pages;
+         ++page_number) {
+      snapshots[i]->beforeWrite(page_number);
+    }
+  }
+
+  // Unlink the free pages past the new end; the others keep their order.
+  // Free pages do not carry their own number, so track it alongside.
+  PageId* link = &header.first_free_page;
+  Page link_page;
+  PageId link_page_number = Page::INVALID_NUMBER;
+  PageId page_number = header.first_free_page;
+  PageId kept = 0;
+  for (PageId i = 0; i < header.num_free_pages; ++i) {
+    Page free_page = readPage(page_number, true /* allow_free */);
+    const PageId next = free_page.next_page_number();
+    if (page_number < new_num_pages) {
+      *link = page_number;
+      if (link_page_number != Page::INVALID_NUMBER) {
+        writePage(link_page_number, link_page);
+      }
+      link_page = free_page;
+      link_page_number = page_number;
+      link = &link_page.header_.next_page_number;
+      ++kept;
+    }
+    page_number = next;
+  }
+  *link = Page::INVALID_NUMBER;
+  if (link_page_number != Page::INVALID_NUMBER) {
+    writePage(link_page_number, link_page);
+  }
+  const PageId removed = header.num_pages - new_num_pages;
+  header.num_free_pages = kept;
+  header.num_pages = new_num_pages;
+  writeHeader(header);
+
+  stream_->flush();
+  if (::ftruncate(descriptor(), pagePosition(new_num_pages)) != 0) {
+    throw FileIOException(filename_, "ftruncate", errno);
+  }
+  return removed;
+}
+
+double File::fragmentation() {
+  std::size_t hops = 0;
+  std::size_t jumps = 0;
+  PageId previous = Page::INVALID_NUMBER;
+  for (FileIterator iter = begin(); iter != end(); ++iter) {
+    if (previous != Page::INVALID_NUMBER) {
+      ++hops;
+      if (iter.page_number() != previous + 1) {
+        ++jumps;
+      }
+    }
+    previous = iter.page_number();
+  }
+  return hops == 0 ? 0.0 : static_cast<double>(jumps) / hops;
+}
+
+PageId File::reorganize(const PageMoveHook& hook) {
+  FileHeader header = readHeader();
+  std::vector<PageId> chain;
+  for (FileIterator iter = begin(); iter != end(); ++iter) {
+    chain.push_back(iter.page_number());
+  }
+  const PageId num_used = chain.size();
+
+  // destination[p] is where the page now at p belongs; each used page is read
+  // and written exactly once by following the chains and cycles of this
+  // permutation with a single page in hand.
+  std::vector<PageId> destination(header.num_pages,
+                                  PageId(Page::INVALID_NUMBER));
+  for (PageId i = 0; i < num_used; ++i) {
+    destination[chain[i]] = i + 1;
+  }
+  std::vector<bool> lifted(header.num_pages, false);
+  PageId moved = 0;
+  for (PageId i = 0; i < num_used; ++i) {
+    PageId from = chain[i];
+    if (lifted[from]) {
+      continue;
+    }
+    Page hand = readPage(from, false /* allow_free */);
+    lifted[from] = true;
+    while (true) {
+      const PageId to = destination[from];
+      const bool occupied = destination[to] != Page::INVALID_NUMBER &&
+                            !lifted[to];
+      Page next;
+      if (occupied) {
+        next = readPage(to, false /* allow_free */);
+        lifted[to] = true;
+      }
+      hand.set_page_number(to);
+      hand.set_next_page_number(Page::INVALID_NUMBER);
+      if (to < num_used) {
+        hand.set_next_page_number(to + 1);
+      }
+      writePage(to, hand);
+      if (from != to) {
+        ++moved;
+        if (hook) {
+          hook(from, to);
+        }
+      }
+      if (!occupied) {
+        break;
+      }
+      hand = next;
+      from = to;
+    }
+  }
+
+  // Everything after the last used page is free, in order.
+  for (PageId page_number = num_used + 1; page_number < header.num_pages;
+       ++page_number) {
+    Page free_page;
+    if (page_number + 1 < header.num_pages) {
+      free_page.set_next_page_number(page_number + 1);
+    }
+    writePage(page_number, free_page);
+  }
+  header.num_free_pages = header.num_pages - 1 - num_used;
+  header.first_used_page = Page::INVALID_NUMBER;
+  header.first_free_page = Page::INVALID_NUMBER;
+  if (num_used > 0) {
+    header.first_used_page = 1;
+  }
+  if (header.num_free_pages > 0) {
+    header.first_free_page = num_used + 1;
+  }
+  writeHeader(header);
+  return moved;
+}
+
+std::uint64_t File::diskUsage() const {
+  stream_->flush();
+  struct stat st;
+  if (::fstat(descriptor(), &st) != 0) {
+    throw FileIOException(filename_, "fstat", errno);
+  }
+  return static_cast<std::uint64_t>(st.st_blocks) * 512;
 }
 
 FileIterator File::begin() {
@@ -228,6 +471,13 @@ File::File(const std::string& name, const bool create_new) : filename_(name) {
     FileHeader header = {1 /* num_pages */, 0 /* first_used_page */,
                          0 /* num_free_pages */, 0 /* first_free_page */};
     writeHeader(header);
+    // A bitmap left behind by an earlier file of this name says nothing
+    // about this one.
+    std::remove(changedPagesName(filename_).c_str());
+  } else if (!changeTracking() && exists(changedPagesName(filename_))) {
+    // Tracking stays on across opens; a write made while it is off would be
+    // missing from the next delta.
+    setChangeTracking(true);
   }
 }
 
@@ -255,6 +505,16 @@ void File::openIfNeeded(const bool create_new) {
     stream_.reset(new std::fstream(filename_, mode));
     open_streams_[filename_] = stream_;
     open_counts_[filename_] = 1;
+    FileState& state = open_states_[filename_];
+    state.durability = DURABILITY_FLUSH_ON_SYNC;
+    state.fd = -1;
+    state.verify_checksums = true;
+    state.compress = false;
+    state.release_freed = false;
+    state.bytes_read = 0;
+    state.bytes_written = 0;
+    state.syncs = 0;
+    state.changed_fd = -1;
   }
 }
 
@@ -262,6 +522,14 @@ void File::close() {
   --open_counts_[filename_];
   stream_.reset();
   if (open_counts_[filename_] == 0) {
+    const FileState& state = open_states_[filename_];
+    if (state.fd >= 0) {
+      ::close(state.fd);
+    }
+    if (state.changed_fd >= 0) {
+      ::close(state.changed_fd);
+    }
+    open_states_.erase(filename_);
     open_streams_.erase(filename_);
     open_counts_.erase(filename_);
   }
@@ -273,11 +541,54 @@ void File::writePage(const PageId page_number, const Page& new_page) {
 
 void File::writePage(const PageId page_number, const PageHeader& header,
                      const Page& new_page) {
-  stream_->seekp(pagePosition(page_number), std::ios::beg);
-  stream_->write(reinterpret_cast<const char*>(&header), sizeof(header));
+  FileState& state = open_states_[filename_];
+  for (std::size_t i = 0; i < state.snapshots.size(); ++i) {
+    state.snapshots[i]->beforeWrite(page_number);
+  }
+  if (state.changed_fd >= 0) {
+    markChanged(page_number);
+  }
+  PageHeader stored = header;
+  stored.stored_length = 0;
+  const std::streampos position = pagePosition(page_number);
+  if (state.compress) {
+    // Compression only pays off if it frees at least one whole filesystem
+    // block of the slot.
+    const off_t slot_end = (static_cast<off_t>(position) + Page::SIZE) /
+                           PUNCH_BLOCK_SIZE * PUNCH_BLOCK_SIZE;
+    const off_t max_used = slot_end - PUNCH_BLOCK_SIZE -
+                           static_cast<off_t>(position) - sizeof(stored);
+    if (max_used > 0) {
+      std::string compressed(max_used, '\0');
+      stored.stored_length = lzCompress(new_page.data_.data(),
+                                        Page::DATA_SIZE, &compressed[0],
+                                        max_used);
+      if (stored.stored_length > 0) {
+        stored.checksum = pageChecksum(stored, new_page);
+        stream_->seekp(position, std::ios::beg);
+        stream_->write(reinterpret_cast<const char*>(&stored), sizeof(stored));
+        stream_->write(compressed.data(), stored.stored_length);
+        // The punch must not be overtaken by a buffered older version of the
+        // slot.
+        stream_->flush();
+        const off_t used_end = static_cast<off_t>(position) + sizeof(stored) +
+                               stored.stored_length;
+        const off_t hole_start = (used_end + PUNCH_BLOCK_SIZE - 1) /
+                                 PUNCH_BLOCK_SIZE * PUNCH_BLOCK_SIZE;
+        punchHole(hole_start, slot_end - hole_start);
+        state.bytes_written += sizeof(stored) + stored.stored_length;
+        writeCompleted();
+        return;
+      }
+    }
+  }
+  stored.checksum = pageChecksum(stored, new_page);
+  stream_->seekp(position, std::ios::beg);
+  stream_->write(reinterpret_cast<const char*>(&stored), sizeof(stored));
   stream_->write(reinterpret_cast<const char*>(&new_page.data_[0]),
                  Page::DATA_SIZE);
-  stream_->flush();
+  state.bytes_written += Page::SIZE;
+  writeCompleted();
 }
 
 FileHeader File::readHeader() const {
@@ -291,7 +602,7 @@ FileHeader File::readHeader() const {
 void File::writeHeader(const FileHeader& header) {
   stream_->seekp(0 /* pos */, std::ios::beg);
   stream_->write(reinterpret_cast<const char*>(&header), sizeof(header));
-  stream_->flush();
+  writeCompleted();
 }
 
 PageHeader File::readPageHeader(PageId page_number) const {
@@ -302,4 +613,194 @@ PageHeader File::readPageHeader(PageId page_number) const {
   return header;
 }
 
+void File::setDurability(const DurabilityMode mode) {
+  open_states_[filename_].durability = mode;
+}
+
+DurabilityMode File::durability() const {
+  return open_states_[filename_].durability;
+}
+
+void File::sync() const {
+  const DurabilityMode mode = durability();
+  if (mode == DURABILITY_NONE) {
+    return;
+  }
+  stream_->flush();
+  if (mode == DURABILITY_FDATASYNC_ON_SYNC ||
+      mode == DURABILITY_FSYNC_PER_WRITE) {
+    // Changed bits are durable already; see markChanged().
+    if (::fdatasync(descriptor()) != 0) {
+      throw FileIOException(filename_, "fdatasync", errno);
+    }
+    ++open_states_[filename_].syncs;
+  }
+}
+
+std::uint64_t File::syncCount() const {
+  return open_states_[filename_].syncs;
+}
+
+void File::setChangeTracking(const bool track) {
+  FileState& state = open_states_[filename_];
+  if (!track) {
+    if (state.changed_fd >= 0) {
+      ::close(state.changed_fd);
+      state.changed_fd = -1;
+    }
+    state.changed.clear();
+    // Writes from now on go unrecorded, so the bitmap must not be reused.
+    std::remove(changedPagesName(filename_).c_str());
+    return;
+  }
+  if (state.changed_fd >= 0) {
+    return;
+  }
+  const std::string name = changedPagesName(filename_);
+  const bool fresh = !exists(name);
+  const int fd = ::open(name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    throw FileIOException(name, "open", errno);
+  }
+  state.changed_fd = fd;
+  const off_t size = ::lseek(fd, 0, SEEK_END);
+  state.changed.assign(size > 0 ? size : 0, 0);
+  if (size > 0 && ::pread(fd, &state.changed[0], size, 0) != size) {
+    throw FileIOException(name, "pread", errno);
+  }
+  if (fresh) {
+    // Without a bitmap nothing is known about past writes, so every page is
+    // marked, with a single write and sync.
+    const PageId num_pages = readHeader().num_pages;
+    state.changed.assign((num_pages + 7) / 8, 0);
+    for (PageId page_number = 1; page_number < num_pages; ++page_number) {
+      state.changed[page_number / 8] |= 1 << (page_number % 8);
+    }
+    const ssize_t length = state.changed.size();
+    if (::pwrite(fd, state.changed.data(), length, 0) != length ||
+        ::fdatasync(fd) != 0) {
+      throw FileIOException(name, "write", errno);
+    }
+  }
+}
+
+bool File::changeTracking() const {
+  return open_states_[filename_].changed_fd >= 0;
+}
+
+void File::changedPages(std::vector<PageId>& pages) const {
+  const std::vector<std::uint8_t>& changed = open_states_[filename_].changed;
+  for (std::size_t byte = 0; byte < changed.size(); ++byte) {
+    if (changed[byte] == 0) {
+      continue;
+    }
+    for (int bit = 0; bit < 8; ++bit) {
+      if (changed[byte] & (1 << bit)) {
+        pages.push_back(byte * 8 + bit);
+      }
+    }
+  }
+}
+
+void File::clearChangedPages() {
+  FileState& state = open_states_[filename_];
+  if (state.changed_fd < 0) {
+    return;
+  }
+  if (::ftruncate(state.changed_fd, 0) != 0) {
+    throw FileIOException(changedPagesName(filename_), "ftruncate", errno);
+  }
+  state.changed.clear();
+}
+
+void File::markChanged(const PageId page_number) const {
+  FileState& state = open_states_[filename_];
+  const std::size_t byte = page_number / 8;
+  const std::uint8_t mask = 1 << (page_number % 8);
+  if (byte < state.changed.size() && (state.changed[byte] & mask)) {
+    return;
+  }
+  if (byte >= state.changed.size()) {
+    state.changed.resize(byte + 1, 0);
+  }
+  state.changed[byte] |= mask;
+  if (::pwrite(state.changed_fd, &state.changed[byte], 1, byte) != 1) {
+    throw FileIOException(changedPagesName(filename_), "pwrite", errno);
+  }
+  if (::fdatasync(state.changed_fd) != 0) {
+    throw FileIOException(changedPagesName(filename_), "fdatasync", errno);
+  }
+}
+
+void File::setChecksumVerification(const bool verify) {
+  open_states_[filename_].verify_checksums = verify;
+}
+
+bool File::checksumVerification() const {
+  return open_states_[filename_].verify_checksums;
+}
+
+void File::setCompression(const bool compress) {
+  open_states_[filename_].compress = compress;
+}
+
+bool File::compression() const {
+  return open_states_[filename_].compress;
+}
+
+std::uint64_t File::bytesRead() const {
+  return open_states_[filename_].bytes_read;
+}
+
+std::uint64_t File::bytesWritten() const {
+  return open_states_[filename_].bytes_written;
+}
+
+void File::setReleaseFreedPages(const bool release) {
+  open_states_[filename_].release_freed = release;
+}
+
+bool File::releaseFreedPages() const {
+  return open_states_[filename_].release_freed;
+}
+
+void File::punchHole(const off_t offset, const off_t length) const {
+  if (length <= 0) {
+    return;
+  }
+  if (::fallocate(descriptor(), FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                  offset, length) != 0 &&
+      errno != EOPNOTSUPP) {
+    // A filesystem without hole punching just keeps the space.
+    throw FileIOException(filename_, "fallocate", errno);
+  }
+}
+
+std::uint32_t File::pageChecksum(const PageHeader& header, const Page& page) {
+  const std::uint32_t crc =
+      crc32c(&header, offsetof(PageHeader, checksum));
+  return crc32c(page.data_.data(), Page::DATA_SIZE, crc);
+}
+
+void File::writeCompleted() const {
+  if (open_states_[filename_].durability == DURABILITY_FSYNC_PER_WRITE) {
+    stream_->flush();
+    if (::fsync(descriptor()) != 0) {
+      throw FileIOException(filename_, "fsync", errno);
+    }
+    ++open_states_[filename_].syncs;
+  }
+}
+
+int File::descriptor() const {
+  FileState& state = open_states_[filename_];
+  if (state.fd < 0) {
+    state.fd = ::open(filename_.c_str(), O_RDWR);
+    if (state.fd < 0) {
+      throw FileIOException(filename_, "open", errno);
+    }
+  }
+  return state.fd;
+}
+
 }
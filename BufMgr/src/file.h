@@ -8,15 +8,48 @@
 #pragma once
 
 #include <fstream>
+#include <functional>
 #include <string>
 #include <map>
 #include <memory>
+#include <sys/types.h>
+#include <vector>
 
 #include "page.h"
 
 namespace badgerdb {
 
 class FileIterator;
+class Snapshot;
+
+/**
+ * @brief How far File goes to make writes durable.
+ */
+enum DurabilityMode {
+  /**
+   * Writes stay in the stream buffer until it fills up or the file is
+   * closed, and sync() does nothing.  Nothing survives a crash reliably.
+   */
+  DURABILITY_NONE,
+
+  /**
+   * sync() hands buffered writes to the kernel.  Data written before sync()
+   * survives a crash of the process but not of the operating system.
+   */
+  DURABILITY_FLUSH_ON_SYNC,
+
+  /**
+   * sync() hands buffered writes to the kernel and waits for fdatasync().
+   * Data written before sync() returns survives an OS crash or power loss.
+   */
+  DURABILITY_FDATASYNC_ON_SYNC,
+
+  /**
+   * Every page and header write is flushed and fsync()ed before it returns,
+   * so each write is durable on its own.  This is by far the slowest mode.
+   */
+  DURABILITY_FSYNC_PER_WRITE
+};
 
 /**
  * @brief Header metadata for files on disk which contain pages.
@@ -145,6 +178,14 @@ class File {
    */
   Page allocatePage();
 
+  /**
+   * Allocates a new page at the end of the file, leaving free pages for
+   * allocatePage() to reuse.  Successive calls return consecutive pages.
+   *
+   * @return The new page.
+   */
+  Page appendPage();
+
   /**
    * Reads an existing page from the file.
    *
@@ -165,12 +206,99 @@ class File {
   void writePage(const Page& new_page);
 
   /**
-   * Deletes a page from the file.
+   * Deletes a page from the file.  If freed pages are released (see
+   * setReleaseFreedPages()), the disk space of the page data is returned to
+   * the filesystem; only the page header, which links the free list, stays.
    *
    * @param page_number   Number of page to delete.
    */
   void deletePage(const PageId page_number);
 
+  /**
+   * Removes the free pages at the end of the file from the free list and cuts
+   * them off the file, so the file ends after its last used page.  Free pages
+   * between used pages are kept.  Safe to call while the file is in use, as
+   * long as nobody else accesses it at the same time.  Active snapshots keep
+   * a copy of every page cut off.
+   *
+   * @return  Number of pages removed.
+   * @throws  FileIOException   If the file cannot be truncated.
+   */
+  PageId truncateFreeTail();
+
+  /**
+   * Turns changed-page tracking on or off for the underlying file.  While it
+   * is on, every page written is marked in a bitmap kept in the side file
+   * "<filename>.changed", so an incremental backup can copy just the pages
+   * changed since the previous one.  The bitmap persists across opens, and a
+   * file with a bitmap is tracked as soon as it is opened.  Turning tracking
+   * off deletes the bitmap; when tracking is turned on and no bitmap exists,
+   * all pages count as changed.  The bit of a page is made durable before the
+   * first write of the page after each backup, whatever the durability mode.
+   *
+   * @param track   Whether page writes are tracked.
+   * @throws  FileIOException   If the bitmap cannot be opened.
+   */
+  void setChangeTracking(const bool track);
+
+  /**
+   * Returns whether page writes of the underlying file are tracked.
+   */
+  bool changeTracking() const;
+
+  /**
+   * Lists the pages changed since the bitmap was last cleared, in ascending
+   * order.
+   *
+   * @param pages   Vector receiving the page numbers.
+   */
+  void changedPages(std::vector<PageId>& pages) const;
+
+  /**
+   * Clears the changed-page bitmap, normally right after a backup.
+   *
+   * @throws  FileIOException   If the bitmap cannot be written.
+   */
+  void clearChangedPages();
+
+  /**
+   * Returns the fraction of hops along the used-page chain that do not go to
+   * the physically next page.  0 means a scan of the file reads it
+   * sequentially; values near 1 mean a scan is random I/O.
+   */
+  double fragmentation();
+
+  /**
+   * Called by reorganize() for every page moved, with its old and new number.
+   */
+  typedef std::function<void(const PageId from, const PageId to)>
+      PageMoveHook;
+
+  /**
+   * Rewrites the file so that the used-page chain is in physical order: the
+   * i-th page of the chain is moved to page number i and all free pages
+   * follow the last used page.  Record slots are kept, so a RecordId only
+   * changes its page number, which <hook> reports.  Follow with
+   * truncateFreeTail() to give the free pages back to the filesystem.
+   *
+   * This is an offline operation: no page of the file may be held in a
+   * buffer pool (flush the file first), and the file is not consistent if
+   * the process crashes halfway.
+   *
+   * @param hook  Told about every page moved; may be empty.
+   * @return  Number of pages moved.
+   */
+  PageId reorganize(const PageMoveHook& hook = PageMoveHook());
+
+  /**
+   * Returns the disk space actually allocated to the file in bytes.  Unlike
+   * the file size, this excludes holes left by released pages and compressed
+   * page slots.
+   *
+   * @throws  FileIOException   If the operating system reports an error.
+   */
+  std::uint64_t diskUsage() const;
+
   /**
    * Returns the name of the file this object represents.
    *
@@ -178,6 +306,100 @@ class File {
    */
   const std::string& filename() const { return filename_; }
 
+  /**
+   * Sets the durability mode of the underlying file.  The mode is shared by
+   * all File objects open on the same file and is reset when the file is
+   * closed.  New files start in DURABILITY_FLUSH_ON_SYNC.
+   *
+   * @param mode  New durability mode.
+   */
+  void setDurability(const DurabilityMode mode);
+
+  /**
+   * Returns the durability mode of the underlying file.
+   */
+  DurabilityMode durability() const;
+
+  /**
+   * Makes all previous writes to the file as durable as the durability mode
+   * promises (see DurabilityMode).
+   *
+   * @throws  FileIOException   If the operating system reports an error.
+   */
+  void sync() const;
+
+  /**
+   * Returns the number of fdatasync() and fsync() calls made for the
+   * underlying file since it was opened, by sync() and by writes in
+   * DURABILITY_FSYNC_PER_WRITE.
+   */
+  std::uint64_t syncCount() const;
+
+  /**
+   * Turns checksum verification on page reads on or off for the underlying
+   * file.  Checksums are always written; the setting is shared by all File
+   * objects open on the same file and new files start with verification on.
+   *
+   * @param verify  Whether readPage() verifies page checksums.
+   */
+  void setChecksumVerification(const bool verify);
+
+  /**
+   * Returns whether page reads of the underlying file verify checksums.
+   */
+  bool checksumVerification() const;
+
+  /**
+   * Turns page compression on or off for the underlying file.  With
+   * compression on, a page whose data compresses well enough is stored as its
+   * header followed by the compressed data, and the unused remainder of its
+   * 8 KB slot is released with a hole punched into the file, so it takes no
+   * disk space.  Pages are read correctly whatever the setting; it only
+   * affects how pages are written.  The setting is shared by all File objects
+   * open on the same file and new files start without compression.
+   *
+   * Every page keeps its fixed slot, and space is only released in whole
+   * 4 KB filesystem blocks that do not overlap the stored bytes.  A compressed
+   * page therefore frees at most one of the two blocks of its slot, so
+   * compression at best halves the disk space of a file, however well its
+   * pages compress.  Pages that would not leave a whole block free are stored
+   * uncompressed.
+   *
+   * @param compress  Whether page writes compress the page data.
+   */
+  void setCompression(const bool compress);
+
+  /**
+   * Returns whether page writes of the underlying file are compressed.
+   */
+  bool compression() const;
+
+  /**
+   * Returns the number of page bytes read from the underlying file since it
+   * was opened.
+   */
+  std::uint64_t bytesRead() const;
+
+  /**
+   * Returns the number of page bytes written to the underlying file since it
+   * was opened.
+   */
+  std::uint64_t bytesWritten() const;
+
+  /**
+   * Turns release of the disk space of deleted pages on or off for the
+   * underlying file.  The setting is shared by all File objects open on the
+   * same file and new files start without releasing.
+   *
+   * @param release   Whether deletePage() punches out the page data.
+   */
+  void setReleaseFreedPages(const bool release);
+
+  /**
+   * Returns whether deletePage() releases the disk space of the page data.
+   */
+  bool releaseFreedPages() const;
+
   /**
    * Returns an iterator at the first page in the file.
    *
@@ -194,6 +416,11 @@ class File {
   FileIterator end();
 
  private:
+  /**
+   * Granularity at which hole punching releases disk space.
+   */
+  static const off_t PUNCH_BLOCK_SIZE = 4096;
+
   /**
    * Returns the position of the page with the given number in the file (as an
    * offset from the beginning of the file).
@@ -253,9 +480,27 @@ class File {
    * @return  The page.
    * @throws  InvalidPageException  If the page is free (unused) and
    *                                allow_free is false.
+   * @throws  ChecksumMismatchException  If verification is on and the page
+   *                                     does not match its checksum.
    */
   Page readPage(const PageId page_number, const bool allow_free) const;
 
+  /**
+   * Completes the read of a page whose header and stored data were copied
+   * verbatim from disk into <page>: decompresses the data, verifies the
+   * checksum and accounts for the bytes read.
+   *
+   * @param page        Page as read from disk.
+   * @param page_number Number of the page.
+   * @param allow_free  Whether a free page is acceptable.
+   * @throws  InvalidPageException  If the page is free and <allow_free> is
+   *                                false.
+   * @throws  ChecksumMismatchException  If the page cannot be decompressed or
+   *                                     does not match its checksum.
+   */
+  void finishRead(Page& page, const PageId page_number,
+                  const bool allow_free) const;
+
   /**
    * Writes a page into the file at the given page number.  This does not
    * update ensure that the number in the header equals the position on disk.
@@ -301,9 +546,119 @@ class File {
    */
   PageHeader readPageHeader(const PageId page_number) const;
 
+  /**
+   * Releases the disk space of a byte range of the file without changing its
+   * size; the range reads back as zeros.  Does nothing on filesystems that do
+   * not support hole punching.
+   *
+   * @param offset  Start of the range.
+   * @param length  Length of the range.
+   * @throws  FileIOException   If the operating system reports an error.
+   */
+  void punchHole(const off_t offset, const off_t length) const;
+
+  /**
+   * Marks a page in the changed-page bitmap.  If the bit was not set yet, the
+   * bitmap byte is written to its side file and synced, so that the bit is
+   * durable before the page write that follows can reach the disk.  This
+   * costs one sync per page and backup.
+   *
+   * @param page_number   Number of page being written.
+   */
+  void markChanged(const PageId page_number) const;
+
+  /**
+   * Returns the name of the changed-page bitmap of a file.
+   */
+  static std::string changedPagesName(const std::string& filename) {
+    return filename + ".changed";
+  }
+
+  /**
+   * Computes the checksum of a page as it is stored on disk.
+   *
+   * @param header  Header of the page.
+   * @param page    Page whose data is checksummed.
+   * @return  CRC32C over the header fields before the checksum and the data.
+   */
+  static std::uint32_t pageChecksum(const PageHeader& header,
+                                    const Page& page);
+
+  /**
+   * Called after every page or header write; enforces
+   * DURABILITY_FSYNC_PER_WRITE.
+   */
+  void writeCompleted() const;
+
+  /**
+   * Returns a POSIX descriptor for the underlying file, opening it on first
+   * use.  The descriptor is shared like the stream.
+   *
+   * @throws  FileIOException   If the file cannot be opened.
+   */
+  int descriptor() const;
+
+  /**
+   * Per-file settings and resources shared by all File objects open on the
+   * same file.
+   */
+  struct FileState {
+    /**
+     * Durability mode.
+     */
+    DurabilityMode durability;
+
+    /**
+     * POSIX descriptor used for syncing, or -1 if not opened yet.
+     */
+    int fd;
+
+    /**
+     * Whether page reads verify checksums.
+     */
+    bool verify_checksums;
+
+    /**
+     * Whether page writes compress the page data.
+     */
+    bool compress;
+
+    /**
+     * Whether deletePage() punches out the page data.
+     */
+    bool release_freed;
+
+    /**
+     * Snapshots to notify before a page is overwritten.
+     */
+    std::vector<Snapshot*> snapshots;
+
+    /**
+     * Descriptor of the changed-page bitmap, or -1 if changes are not tracked.
+     */
+    int changed_fd;
+
+    /**
+     * Changed-page bitmap, one bit per page number.
+     */
+    std::vector<std::uint8_t> changed;
+
+    /**
+     * Page bytes read from and written to the file.
+     */
+    std::uint64_t bytes_read;
+    std::uint64_t bytes_written;
+
+    /**
+     * fdatasync() and fsync() calls made for the file.
+     */
+    std::uint64_t syncs;
+  };
+
   typedef std::map<std::string,
                    std::shared_ptr<std::fstream> > StreamMap;
   typedef std::map<std::string, int> CountMap;
+  typedef std::map<std::string, FileState> StateMap;
 
   /**
    * Streams for opened files.
@@ -315,6 +670,11 @@ class File {
    */
   static CountMap open_counts_;
 
+  /**
+   * Settings for opened files.
+   */
+  static StateMap open_states_;
+
   /**
    * Name of the file this object represents.
    */
@@ -325,8 +685,13 @@ class File {
    */
   std::shared_ptr<std::fstream> stream_;
 
+  friend class DoubleWriteBuffer;
+  friend class EventLoop;
   friend class FileIterator;
   friend class FileTest;
+  friend class IncrementalBackup;
+  friend class SharedPageCache;
+  friend class Snapshot;
 };
 
 }
@@ -0,0 +1,78 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "frame_arena.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * mbind() policy (see <numaif.h>); the system call is made directly so that
+ * libnuma is not needed.
+ */
+const int NUMA_MPOL_PREFERRED = 1;
+
+}
+
+FrameArena::FrameArena(const std::size_t slots, const std::size_t slot_size,
+                       const int node)
+    : base_(NULL), length_(0), slot_size_(slot_size), bound_(false) {
+  const std::size_t page_size = sysconf(_SC_PAGESIZE);
+  length_ = (slots * slot_size + page_size - 1) / page_size * page_size;
+  if (length_ == 0) {
+    return;
+  }
+  void* memory = mmap(NULL, length_, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  base_ = static_cast<char*>(memory);
+  if (node >= 0) {
+    unsigned long node_mask = 1UL << node;
+    bound_ = syscall(SYS_mbind, base_, length_, NUMA_MPOL_PREFERRED,
+                     &node_mask, sizeof(node_mask) * 8, 0) == 0;
+  }
+  free_slots_.reserve(slots);
+  for (std::size_t i = slots; i > 0; --i) {
+    free_slots_.push_back(base_ + (i - 1) * slot_size_);
+  }
+}
+
+FrameArena::~FrameArena() {
+  if (base_ != NULL) {
+    munmap(base_, length_);
+  }
+}
+
+void* FrameArena::allocate(const std::size_t bytes) {
+  if (bytes <= slot_size_) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!free_slots_.empty()) {
+      char* slot = free_slots_.back();
+      free_slots_.pop_back();
+      return slot;
+    }
+  }
+  return ::operator new(bytes);
+}
+
+void FrameArena::deallocate(void* memory) {
+  if (!contains(memory)) {
+    ::operator delete(memory);
+    return;
+  }
+  std::lock_guard<std::mutex> guard(mutex_);
+  free_slots_.push_back(static_cast<char*>(memory));
+}
+
+}
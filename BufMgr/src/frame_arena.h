@@ -0,0 +1,169 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace badgerdb {
+
+/**
+ * @brief Page-aligned memory holding the page data of a range of frames.
+ *
+ * The arena is one anonymous mapping split into slots of Page::SIZE bytes.  If
+ * a NUMA node is given the mapping is bound to it before the slots are first
+ * touched; otherwise the kernel places each memory page on the node of the
+ * thread that first writes it.  Requests that do not fit a free slot are
+ * served from the heap.
+ */
+class FrameArena {
+ public:
+  /**
+   * Maps memory for <slots> slots of <slot_size> bytes.
+   *
+   * @param slots      Number of slots.
+   * @param slot_size  Size of each slot in bytes.
+   * @param node       NUMA node to bind the memory to, or -1.
+   * @throws std::bad_alloc  If the memory cannot be mapped.
+   */
+  FrameArena(const std::size_t slots, const std::size_t slot_size,
+             const int node);
+
+  /**
+   * Unmaps the memory.  All slots must have been released.
+   */
+  ~FrameArena();
+
+  /**
+   * Returns <bytes> bytes from a free slot, or from the heap if no slot fits.
+   */
+  void* allocate(const std::size_t bytes);
+
+  /**
+   * Releases memory returned by allocate().
+   */
+  void deallocate(void* memory);
+
+  /**
+   * Returns true if the memory was bound to a NUMA node.
+   */
+  bool bound() const { return bound_; }
+
+  /**
+   * Returns the number of slots not handed out.
+   */
+  std::size_t freeSlots() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return free_slots_.size();
+  }
+
+  /**
+   * Returns true if <memory> lies in one of the slots.
+   */
+  bool contains(const void* memory) const {
+    return static_cast<const char*>(memory) >= base_ &&
+           static_cast<const char*>(memory) < base_ + length_;
+  }
+
+ private:
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  /**
+   * Start of the mapping.
+   */
+  char* base_;
+
+  /**
+   * Length of the mapping in bytes.
+   */
+  std::size_t length_;
+
+  /**
+   * Size of each slot in bytes.
+   */
+  std::size_t slot_size_;
+
+  /**
+   * True if the mapping was bound to a NUMA node.
+   */
+  bool bound_;
+
+  /**
+   * Slots not handed out.
+   */
+  std::vector<char*> free_slots_;
+
+  /**
+   * Protects free_slots_.
+   */
+  mutable std::mutex mutex_;
+};
+
+/**
+ * @brief Allocator drawing from a FrameArena, or from the heap without one.
+ *
+ * Containers keep their allocator when assigned to and give copies a heap
+ * allocator, so assigning a page to a frame copies into the frame's slot and
+ * copying a frame's page never uses one.
+ */
+template <class T>
+class FrameAllocator {
+ public:
+  typedef T value_type;
+  typedef std::false_type propagate_on_container_copy_assignment;
+  typedef std::false_type propagate_on_container_move_assignment;
+  typedef std::false_type propagate_on_container_swap;
+  typedef std::false_type is_always_equal;
+
+  FrameAllocator() : arena_(NULL) {}
+
+  explicit FrameAllocator(FrameArena* arena) : arena_(arena) {}
+
+  template <class U>
+  FrameAllocator(const FrameAllocator<U>& other) : arena_(other.arena()) {}
+
+  T* allocate(const std::size_t count) {
+    if (arena_ != NULL) {
+      return static_cast<T*>(arena_->allocate(count * sizeof(T)));
+    }
+    return static_cast<T*>(::operator new(count * sizeof(T)));
+  }
+
+  void deallocate(T* memory, const std::size_t) {
+    if (arena_ != NULL) {
+      arena_->deallocate(memory);
+    } else {
+      ::operator delete(memory);
+    }
+  }
+
+  FrameAllocator select_on_container_copy_construction() const {
+    return FrameAllocator();
+  }
+
+  FrameArena* arena() const { return arena_; }
+
+ private:
+  FrameArena* arena_;
+};
+
+template <class T, class U>
+bool operator==(const FrameAllocator<T>& lhs, const FrameAllocator<U>& rhs) {
+  return lhs.arena() == rhs.arena();
+}
+
+template <class T, class U>
+bool operator!=(const FrameAllocator<T>& lhs, const FrameAllocator<U>& rhs) {
+  return lhs.arena() != rhs.arena();
+}
+
+}
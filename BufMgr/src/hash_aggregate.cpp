@@ -0,0 +1,366 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "hash_aggregate.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <sstream>
+#include <thread>
+
+#include "exceptions/file_not_found_exception.h"
+#include "file_iterator.h"
+#include "page_iterator.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Number of records hashed together by AggregateHashTable::updateBatch().
+ */
+const std::size_t UPDATE_BATCH_SIZE = 64;
+
+std::uint64_t mix(std::uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+}
+
+AggregateHashTable::AggregateHashTable(const std::size_t expected_groups) {
+  std::size_t capacity = 16;
+  while (capacity < expected_groups * 2) {
+    capacity *= 2;
+  }
+  Slot empty = {0 /* hash */, 0 /* entry */};
+  slots_.assign(capacity, empty);
+  entries_.reserve(expected_groups);
+}
+
+std::uint64_t AggregateHashTable::hashKey(const std::string& key,
+                                          const std::uint64_t seed) {
+  std::uint64_t hash = 0xcbf29ce484222325ULL ^ mix(seed + 1);
+  for (std::size_t i = 0; i < key.length(); ++i) {
+    hash ^= static_cast<unsigned char>(key[i]);
+    hash *= 0x100000001b3ULL;
+  }
+  hash = mix(hash);
+  return hash == 0 ? 1 : hash;
+}
+
+AggregateState* AggregateHashTable::find(const std::string& key,
+                                         const std::uint64_t hash) {
+  const std::size_t mask = slots_.size() - 1;
+  for (std::size_t i = hash & mask; ; i = (i + 1) & mask) {
+    const Slot& slot = slots_[i];
+    if (slot.hash == 0) {
+      return NULL;
+    }
+    if (slot.hash == hash && entries_[slot.entry].group == key) {
+      return &entries_[slot.entry].state;
+    }
+  }
+}
+
+AggregateState& AggregateHashTable::findOrInsert(const std::string& key,
+                                                 const std::uint64_t hash) {
+  if (entries_.size() + 1 > max_load()) {
+    grow();
+  }
+  const std::size_t mask = slots_.size() - 1;
+  std::size_t i = hash & mask;
+  for (; slots_[i].hash != 0; i = (i + 1) & mask) {
+    if (slots_[i].hash == hash && entries_[slots_[i].entry].group == key) {
+      return entries_[slots_[i].entry].state;
+    }
+  }
+  slots_[i].hash = hash;
+  slots_[i].entry = static_cast<std::uint32_t>(entries_.size());
+  AggregateResult result;
+  result.group = key;
+  result.state.count = 0;
+  result.state.sum = result.state.min = result.state.max = 0;
+  entries_.push_back(result);
+  return entries_.back().state;
+}
+
+void AggregateHashTable::updateBatch(const std::string* keys,
+                                     const double* values,
+                                     const std::size_t count) {
+  std::uint64_t hashes[UPDATE_BATCH_SIZE];
+  for (std::size_t start = 0; start < count; start += UPDATE_BATCH_SIZE) {
+    const std::size_t n = std::min(UPDATE_BATCH_SIZE, count - start);
+    for (std::size_t i = 0; i < n; ++i) {
+      hashes[i] = hashKey(keys[start + i]);
+    }
+    const std::size_t mask = slots_.size() - 1;
+    for (std::size_t i = 0; i < n; ++i) {
+      __builtin_prefetch(&slots_[hashes[i] & mask]);
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      findOrInsert(keys[start + i], hashes[i]).update(values[start + i]);
+    }
+  }
+}
+
+void AggregateHashTable::clear() {
+  Slot empty = {0 /* hash */, 0 /* entry */};
+  std::fill(slots_.begin(), slots_.end(), empty);
+  entries_.clear();
+}
+
+void AggregateHashTable::drain(std::vector<AggregateResult>& results) {
+  results.insert(results.end(), entries_.begin(), entries_.end());
+  clear();
+}
+
+void AggregateHashTable::grow() {
+  std::vector<Slot> old_slots;
+  old_slots.swap(slots_);
+  Slot empty = {0 /* hash */, 0 /* entry */};
+  slots_.assign(old_slots.size() * 2, empty);
+  const std::size_t mask = slots_.size() - 1;
+  for (std::size_t i = 0; i < old_slots.size(); ++i) {
+    if (old_slots[i].hash == 0) {
+      continue;
+    }
+    std::size_t j = old_slots[i].hash & mask;
+    while (slots_[j].hash != 0) {
+      j = (j + 1) & mask;
+    }
+    slots_[j] = old_slots[i];
+  }
+}
+
+struct HashAggregate::SpillPartitions {
+  SpillPartitions(const std::string& prefix, std::size_t& files_created)
+      : prefix(prefix),
+        files_created(files_created),
+        files(SPILL_FANOUT),
+        pages(SPILL_FANOUT) {
+  }
+
+  ~SpillPartitions() {
+    for (std::size_t i = 0; i < files.size(); ++i) {
+      if (files[i]) {
+        const std::string name = files[i]->filename();
+        files[i].reset();
+        File::remove(name);
+      }
+    }
+  }
+
+  /**
+   * Appends a spill record to the given partition, creating the partition
+   * file on first use.
+   */
+  void write(const std::size_t partition, const std::string& record) {
+    if (!files[partition]) {
+      std::stringstream ss;
+      ss << prefix << "." << partition;
+      try {
+        File::remove(ss.str());
+      } catch (FileNotFoundException&) {
+      }
+      files[partition].reset(new File(File::create(ss.str())));
+      ++files_created;
+      pages[partition] = files[partition]->allocatePage();
+    }
+    if (!pages[partition].hasSpaceForRecord(record)) {
+      files[partition]->writePage(pages[partition]);
+      pages[partition] = files[partition]->allocatePage();
+    }
+    pages[partition].insertRecord(record);
+  }
+
+  /**
+   * Writes out the page being filled for every partition.
+   */
+  void finish() {
+    for (std::size_t i = 0; i < files.size(); ++i) {
+      if (files[i]) {
+        files[i]->writePage(pages[i]);
+      }
+    }
+  }
+
+  std::string prefix;
+  std::size_t& files_created;
+  std::vector<std::unique_ptr<File> > files;
+  std::vector<Page> pages;
+};
+
+HashAggregate::HashAggregate(BufMgr* buf_mgr, File* file,
+                             const KeyExtractor& key,
+                             const ValueExtractor& value,
+                             const std::size_t max_groups,
+                             const unsigned num_threads)
+    : buf_mgr_(buf_mgr),
+      file_(file),
+      key_(key),
+      value_(value),
+      max_groups_(std::max<std::size_t>(max_groups, 1)),
+      num_threads_(std::max(num_threads, 1u)),
+      spill_files_created_(0) {
+}
+
+void HashAggregate::execute(std::vector<AggregateResult>& results) {
+  spill_files_created_ = 0;
+  AggregateHashTable table(std::min<std::size_t>(max_groups_, 1024));
+  SpillPartitions spill(file_->filename() + ".agg", spill_files_created_);
+
+  std::vector<std::string> records;
+  std::size_t pages_in_batch = 0;
+  for (FileIterator iter = file_->begin(); iter != file_->end(); ++iter) {
+    Page* page;
+    const PageId page_number = iter.page_number();
+    buf_mgr_->readPage(file_, page_number, page);
+    for (PageIterator record_iter = page->begin();
+         record_iter != page->end();
+         ++record_iter) {
+      records.push_back(*record_iter);
+    }
+    buf_mgr_->unPinPage(file_, page_number, false /* dirty */);
+
+    if (++pages_in_batch == PAGES_PER_BATCH) {
+      aggregateBatch(records, table, spill, 0 /* level */);
+      records.clear();
+      pages_in_batch = 0;
+    }
+  }
+  aggregateBatch(records, table, spill, 0 /* level */);
+
+  table.drain(results);
+  aggregatePartitions(spill, 0 /* level */, results);
+}
+
+void HashAggregate::aggregateBatch(const std::vector<std::string>& records,
+                                   AggregateHashTable& table,
+                                   SpillPartitions& spill,
+                                   const std::uint64_t level) {
+  if (records.empty()) {
+    return;
+  }
+  const std::size_t num_threads =
+      std::min<std::size_t>(num_threads_, records.size());
+  const std::size_t chunk = (records.size() + num_threads - 1) / num_threads;
+  std::vector<AggregateHashTable> local_tables(
+      num_threads, AggregateHashTable(std::min<std::size_t>(chunk, 1024)));
+  std::vector<std::exception_ptr> errors(num_threads);
+
+  // Each worker extracts keys and values for its slice of the batch and folds
+  // them into its own table, so no synchronization is needed until merging.
+  auto pre_aggregate = [&](const std::size_t t) {
+    try {
+      const std::size_t begin = t * chunk;
+      const std::size_t end = std::min(records.size(), begin + chunk);
+      std::string keys[UPDATE_BATCH_SIZE];
+      double values[UPDATE_BATCH_SIZE];
+      for (std::size_t start = begin; start < end;
+           start += UPDATE_BATCH_SIZE) {
+        const std::size_t n = std::min(UPDATE_BATCH_SIZE, end - start);
+        for (std::size_t i = 0; i < n; ++i) {
+          keys[i] = key_(records[start + i]);
+          values[i] = value_(records[start + i]);
+        }
+        local_tables[t].updateBatch(keys, values, n);
+      }
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (std::size_t t = 1; t < num_threads; ++t) {
+    workers.push_back(std::thread(pre_aggregate, t));
+  }
+  pre_aggregate(0);
+  for (std::size_t t = 0; t < workers.size(); ++t) {
+    workers[t].join();
+  }
+  for (std::size_t t = 0; t < num_threads; ++t) {
+    if (errors[t]) {
+      std::rethrow_exception(errors[t]);
+    }
+  }
+
+  for (std::size_t t = 0; t < num_threads; ++t) {
+    const std::vector<AggregateResult>& entries = local_tables[t].entries();
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+      mergeGroup(entries[i].group, entries[i].state, table, spill, level);
+    }
+  }
+}
+
+void HashAggregate::mergeGroup(const std::string& key,
+                               const AggregateState& state,
+                               AggregateHashTable& table,
+                               SpillPartitions& spill,
+                               const std::uint64_t level) {
+  const std::uint64_t hash = AggregateHashTable::hashKey(key, level);
+  AggregateState* existing = table.find(key, hash);
+  if (existing != NULL) {
+    existing->merge(state);
+  } else if (table.size() < max_groups_) {
+    table.findOrInsert(key, hash).merge(state);
+  } else {
+    // The high bits pick the partition; the low bits are used for the slot,
+    // and the next level uses a different seed so a partition is split up
+    // again rather than landing in a single child.
+    spill.write((hash >> 40) % SPILL_FANOUT, encodeGroup(key, state));
+  }
+}
+
+void HashAggregate::aggregatePartitions(SpillPartitions& spill,
+                                        const std::uint64_t level,
+                                        std::vector<AggregateResult>& results) {
+  spill.finish();
+  for (std::size_t p = 0; p < spill.files.size(); ++p) {
+    if (!spill.files[p]) {
+      continue;
+    }
+    File* partition = spill.files[p].get();
+    AggregateHashTable table(std::min<std::size_t>(max_groups_, 1024));
+    SpillPartitions child(partition->filename(), spill_files_created_);
+
+    std::string key;
+    AggregateState state;
+    for (FileIterator iter = partition->begin(); iter != partition->end();
+         ++iter) {
+      Page page = *iter;
+      for (PageIterator record_iter = page.begin();
+           record_iter != page.end();
+           ++record_iter) {
+        decodeGroup(*record_iter, key, state);
+        mergeGroup(key, state, table, child, level + 1);
+      }
+    }
+    table.drain(results);
+    aggregatePartitions(child, level + 1, results);
+  }
+}
+
+std::string HashAggregate::encodeGroup(const std::string& key,
+                                       const AggregateState& state) {
+  std::string record(reinterpret_cast<const char*>(&state), sizeof(state));
+  record.append(key);
+  return record;
+}
+
+void HashAggregate::decodeGroup(const std::string& record, std::string& key,
+                                AggregateState& state) {
+  std::memcpy(&state, record.data(), sizeof(state));
+  key.assign(record, sizeof(state), std::string::npos);
+}
+
+}
@@ -0,0 +1,344 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Running aggregate values for one group.
+ *
+ * COUNT, SUM, MIN and MAX are all maintained at once so that partial states
+ * produced by different threads or partitions can be merged freely.
+ */
+struct AggregateState {
+  /**
+   * Number of records folded into this group.
+   */
+  std::int64_t count;
+
+  /**
+   * Sum of the values of the records in this group.
+   */
+  double sum;
+
+  /**
+   * Smallest value seen in this group.
+   */
+  double min;
+
+  /**
+   * Largest value seen in this group.
+   */
+  double max;
+
+  /**
+   * Folds a single value into the state.
+   *
+   * @param value   Value extracted from a record.
+   */
+  void update(const double value) {
+    if (count == 0 || value < min) min = value;
+    if (count == 0 || value > max) max = value;
+    sum += value;
+    ++count;
+  }
+
+  /**
+   * Folds another partial state into this one.
+   *
+   * @param other   Partial state for the same group.
+   */
+  void merge(const AggregateState& other) {
+    if (other.count == 0) return;
+    if (count == 0 || other.min < min) min = other.min;
+    if (count == 0 || other.max > max) max = other.max;
+    sum += other.sum;
+    count += other.count;
+  }
+};
+
+/**
+ * @brief One output row of a hash aggregation.
+ */
+struct AggregateResult {
+  /**
+   * Grouping key.
+   */
+  std::string group;
+
+  /**
+   * Aggregates computed over all records of the group.
+   */
+  AggregateState state;
+};
+
+/**
+ * @brief Open-addressing hash table from group key to AggregateState.
+ *
+ * Slots only hold a 64-bit hash and the index of a densely packed entry, so a
+ * probe sequence touches one small contiguous array and the keys are only
+ * compared when the full hashes already match.  The slot array is a power of
+ * two in size and uses linear probing.
+ *
+ * @warning This class is not threadsafe.
+ */
+class AggregateHashTable {
+ public:
+  /**
+   * Constructs an empty table sized for roughly <expected_groups> groups.
+   *
+   * @param expected_groups   Number of groups to size the slot array for.
+   */
+  explicit AggregateHashTable(const std::size_t expected_groups);
+
+  /**
+   * Returns the number of groups held in the table.
+   */
+  std::size_t size() const { return entries_.size(); }
+
+  /**
+   * Returns the group state for the given key, or NULL if the group is not in
+   * the table.
+   *
+   * @param key   Grouping key.
+   * @param hash  Hash of the key as computed by hashKey().
+   */
+  AggregateState* find(const std::string& key, const std::uint64_t hash);
+
+  /**
+   * Returns the state for the given key, inserting an empty state if the
+   * group is new.
+   *
+   * @param key   Grouping key.
+   * @param hash  Hash of the key as computed by hashKey().
+   */
+  AggregateState& findOrInsert(const std::string& key,
+                               const std::uint64_t hash);
+
+  /**
+   * Folds a batch of (key, value) pairs into the table.  Hashes for the whole
+   * batch are computed in one pass before any slot is probed so that the
+   * hashing loop and the probing loop each stay tight.
+   *
+   * @param keys    Grouping keys of the batch.
+   * @param values  Values of the batch, parallel to <keys>.
+   * @param count   Number of pairs in the batch.
+   */
+  void updateBatch(const std::string* keys, const double* values,
+                   const std::size_t count);
+
+  /**
+   * Removes every group from the table.
+   */
+  void clear();
+
+  /**
+   * Moves all groups of the table into <results>.
+   *
+   * @param results   Vector receiving the output rows.
+   */
+  void drain(std::vector<AggregateResult>& results);
+
+  /**
+   * Key and state of every group, in insertion order.
+   */
+  const std::vector<AggregateResult>& entries() const { return entries_; }
+
+  /**
+   * Hashes a grouping key.  Different <seed> values give independent hash
+   * functions, which is used to re-partition spilled groups.
+   *
+   * @param key   Grouping key.
+   * @param seed  Hash function selector.
+   * @return  64-bit hash, never zero.
+   */
+  static std::uint64_t hashKey(const std::string& key,
+                               const std::uint64_t seed = 0);
+
+ private:
+  /**
+   * Hash table slot.  A hash of zero marks an empty slot.
+   */
+  struct Slot {
+    std::uint64_t hash;
+    std::uint32_t entry;
+  };
+
+  /**
+   * Doubles the slot array and re-inserts all entries.
+   */
+  void grow();
+
+  /**
+   * Number of groups after which the slot array is grown.
+   */
+  std::size_t max_load() const { return slots_.size() / 2; }
+
+  /**
+   * Slot array.
+   */
+  std::vector<Slot> slots_;
+
+  /**
+   * Densely packed groups referenced by the slots.
+   */
+  std::vector<AggregateResult> entries_;
+};
+
+/**
+ * @brief GROUP BY hash aggregation over the records of a heap file.
+ *
+ * Pages are read through the buffer manager in batches.  The records of each
+ * batch are split across worker threads which pre-aggregate them into
+ * thread-local tables; the local tables are then merged into a global table
+ * holding at most <max_groups> groups.  Groups which do not fit are written to
+ * one of several temporary partition files, and every partition is aggregated
+ * again (recursively spilling with a fresh hash function if it is still too
+ * large) once the input has been consumed.
+ *
+ * All file and buffer manager accesses happen on the calling thread; only the
+ * in-memory pre-aggregation runs in parallel.
+ */
+class HashAggregate {
+ public:
+  /**
+   * Extracts the grouping key of a record.
+   */
+  typedef std::function<std::string(const std::string&)> KeyExtractor;
+
+  /**
+   * Extracts the aggregated value of a record.
+   */
+  typedef std::function<double(const std::string&)> ValueExtractor;
+
+  /**
+   * Number of partition files groups are spilled to at each level.
+   */
+  static const std::size_t SPILL_FANOUT = 8;
+
+  /**
+   * Number of pages read from the input before the batch is aggregated.
+   */
+  static const std::size_t PAGES_PER_BATCH = 32;
+
+  /**
+   * Constructs an aggregation over all records of <file>.
+   *
+   * @param buf_mgr       Buffer manager used to read the input pages.
+   * @param file          Heap file to aggregate.
+   * @param key           Extracts the grouping key of a record.
+   * @param value         Extracts the aggregated value of a record.
+   * @param max_groups    Memory budget expressed as number of groups.
+   * @param num_threads   Number of threads used for pre-aggregation.
+   */
+  HashAggregate(BufMgr* buf_mgr, File* file, const KeyExtractor& key,
+                const ValueExtractor& value, const std::size_t max_groups,
+                const unsigned num_threads = 1);
+
+  /**
+   * Runs the aggregation and appends one row per group to <results>.  Output
+   * order is unspecified.
+   *
+   * @param results   Vector receiving the output rows.
+   */
+  void execute(std::vector<AggregateResult>& results);
+
+  /**
+   * Returns the number of partition files created by the last execute().
+   */
+  std::size_t spillFileCount() const { return spill_files_created_; }
+
+ private:
+  /**
+   * Partition files of one spill level along with the page currently being
+   * filled for each partition.
+   */
+  struct SpillPartitions;
+
+  /**
+   * Pre-aggregates <records> on the worker threads and merges the partial
+   * states into <table>, spilling groups that do not fit into <spill>.
+   */
+  void aggregateBatch(const std::vector<std::string>& records,
+                      AggregateHashTable& table, SpillPartitions& spill,
+                      const std::uint64_t level);
+
+  /**
+   * Merges one partial group state into <table>, spilling it if the table is
+   * full and the group is not in it yet.
+   */
+  void mergeGroup(const std::string& key, const AggregateState& state,
+                  AggregateHashTable& table, SpillPartitions& spill,
+                  const std::uint64_t level);
+
+  /**
+   * Re-aggregates every partition produced at <level> and appends the output
+   * rows to <results>.
+   */
+  void aggregatePartitions(SpillPartitions& spill, const std::uint64_t level,
+                           std::vector<AggregateResult>& results);
+
+  /**
+   * Serializes a group into a spill record.
+   */
+  static std::string encodeGroup(const std::string& key,
+                                 const AggregateState& state);
+
+  /**
+   * Deserializes a spill record produced by encodeGroup().
+   */
+  static void decodeGroup(const std::string& record, std::string& key,
+                          AggregateState& state);
+
+  /**
+   * Buffer manager used to read the input.
+   */
+  BufMgr* buf_mgr_;
+
+  /**
+   * Input heap file.
+   */
+  File* file_;
+
+  /**
+   * Grouping key extractor.
+   */
+  KeyExtractor key_;
+
+  /**
+   * Value extractor.
+   */
+  ValueExtractor value_;
+
+  /**
+   * Maximum number of groups held in memory.
+   */
+  std::size_t max_groups_;
+
+  /**
+   * Number of pre-aggregation threads.
+   */
+  unsigned num_threads_;
+
+  /**
+   * Number of partition files created so far.
+   */
+  std::size_t spill_files_created_;
+};
+
+}
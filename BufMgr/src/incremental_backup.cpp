@@ -0,0 +1,131 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "incremental_backup.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+#include <vector>
+
+#include "exceptions/file_io_exception.h"
+#include "log_manager.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Identifies a delta file.
+ */
+const std::uint64_t DELTA_MAGIC = 0x41544c4544424442ULL;
+
+const std::size_t IMAGE_SIZE = sizeof(PageHeader) + Page::DATA_SIZE;
+
+/**
+ * Makes a newly written file durable, including its directory entry.
+ */
+void syncNewFile(const std::string& name) {
+  const int fd = ::open(name.c_str(), O_RDONLY);
+  if (fd < 0 || ::fsync(fd) != 0) {
+    const int error = errno;
+    if (fd >= 0) {
+      ::close(fd);
+    }
+    throw FileIOException(name, "fsync", error);
+  }
+  ::close(fd);
+  const std::string::size_type slash = name.rfind('/');
+  const std::string directory =
+      slash == std::string::npos ? "." : name.substr(0, slash + 1);
+  const int dir_fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+  if (dir_fd < 0 || ::fsync(dir_fd) != 0) {
+    const int error = errno;
+    if (dir_fd >= 0) {
+      ::close(dir_fd);
+    }
+    throw FileIOException(directory, "fsync", error);
+  }
+  ::close(dir_fd);
+}
+
+}
+
+std::uint32_t IncrementalBackup::take(File* file,
+                                      const std::string& delta_name) {
+  const FileHeader header = file->readHeader();
+  std::vector<PageId> changed;
+  file->changedPages(changed);
+  std::vector<PageId> pages;
+  for (std::size_t i = 0; i < changed.size(); ++i) {
+    // Pages cut off the end of the file no longer exist.
+    if (changed[i] != Page::INVALID_NUMBER && changed[i] < header.num_pages) {
+      pages.push_back(changed[i]);
+    }
+  }
+
+  std::ofstream delta(delta_name.c_str(),
+                      std::ios::out | std::ios::binary | std::ios::trunc);
+  const std::uint32_t count = pages.size();
+  delta.write(reinterpret_cast<const char*>(&DELTA_MAGIC), sizeof(DELTA_MAGIC));
+  delta.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  delta.write(reinterpret_cast<const char*>(&count), sizeof(count));
+  for (std::size_t i = 0; i < pages.size(); ++i) {
+    const std::string image =
+        LogManager::encodePage(file->readPage(pages[i], true /* allow_free */));
+    delta.write(reinterpret_cast<const char*>(&pages[i]), sizeof(pages[i]));
+    delta.write(image.data(), image.size());
+  }
+  delta.close();
+  if (!delta) {
+    throw FileIOException(delta_name, "write", errno);
+  }
+  // Once the bitmap is cleared, the delta is the only record of these pages
+  // having changed.
+  syncNewFile(delta_name);
+  file->clearChangedPages();
+  return count;
+}
+
+std::uint32_t IncrementalBackup::apply(const std::string& delta_name,
+                                       File* target) {
+  std::ifstream delta(delta_name.c_str(), std::ios::in | std::ios::binary);
+  std::uint64_t magic = 0;
+  FileHeader header;
+  std::uint32_t count = 0;
+  delta.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+  delta.read(reinterpret_cast<char*>(&header), sizeof(header));
+  delta.read(reinterpret_cast<char*>(&count), sizeof(count));
+  if (!delta || magic != DELTA_MAGIC) {
+    throw FileIOException(delta_name, "read", EINVAL);
+  }
+
+  std::string image(IMAGE_SIZE, '\0');
+  for (std::uint32_t i = 0; i < count; ++i) {
+    PageId page_number;
+    delta.read(reinterpret_cast<char*>(&page_number), sizeof(page_number));
+    delta.read(&image[0], image.size());
+    if (!delta) {
+      throw FileIOException(delta_name, "read", EINVAL);
+    }
+    Page page;
+    LogManager::decodePage(image, page);
+    target->writePage(page_number, page);
+  }
+  target->writeHeader(header);
+
+  // The original may have shrunk since the previous delta.
+  target->stream_->flush();
+  if (::ftruncate(target->descriptor(),
+                  File::pagePosition(header.num_pages)) != 0) {
+    throw FileIOException(target->filename(), "ftruncate", errno);
+  }
+  return count;
+}
+
+}
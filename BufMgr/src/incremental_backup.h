@@ -0,0 +1,53 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Backups that copy only the pages changed since the previous one.
+ *
+ * Relies on the changed-page bitmap of File (see File::setChangeTracking()).
+ * take() writes the file header and every changed page, in ascending page
+ * order, to a delta file and clears the bitmap, so the I/O of a backup is
+ * proportional to what was written since the last one.  The first delta
+ * after tracking is turned on holds every page and serves as the full
+ * backup.  A file is restored by applying its deltas in order to an empty
+ * file.
+ */
+class IncrementalBackup {
+ public:
+  /**
+   * Writes the pages changed since the last backup to a new delta file,
+   * makes it durable and only then clears the changed-page bitmap.  Pages dirty in a buffer pool are not on
+   * disk yet, so the file should be flushed first.
+   *
+   * @param file        File to back up; must have change tracking on.
+   * @param delta_name  Name of the delta file to write.
+   * @return  Number of pages copied.
+   * @throws  FileIOException   If the delta file cannot be written.
+   */
+  static std::uint32_t take(File* file, const std::string& delta_name);
+
+  /**
+   * Applies a delta file to a restored copy of the file.
+   *
+   * @param delta_name  Name of the delta file.
+   * @param target      Copy to update; an empty file for the first delta.
+   * @return  Number of pages applied.
+   * @throws  FileIOException   If the delta file is missing or damaged.
+   */
+  static std::uint32_t apply(const std::string& delta_name, File* target);
+};
+
+}
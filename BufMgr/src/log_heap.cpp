@@ -0,0 +1,274 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "log_heap.h"
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "exceptions/row_not_found_exception.h"
+#include "file_iterator.h"
+#include "page_iterator.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Prefix of every stored version.
+ */
+struct VersionPrefix {
+  std::uint64_t row;
+  std::uint64_t seq;
+  std::uint32_t flags;
+};
+
+/**
+ * Set in VersionPrefix::flags for the version recording a removal.
+ */
+const std::uint32_t TOMBSTONE = 1;
+
+const std::size_t PREFIX_SIZE = 20;
+
+std::string encode(const VersionPrefix& prefix, const std::string& data) {
+  char bytes[PREFIX_SIZE];
+  std::memcpy(bytes, &prefix.row, 8);
+  std::memcpy(bytes + 8, &prefix.seq, 8);
+  std::memcpy(bytes + 16, &prefix.flags, 4);
+  return std::string(bytes, PREFIX_SIZE) + data;
+}
+
+VersionPrefix decode(const std::string& record) {
+  VersionPrefix prefix;
+  std::memcpy(&prefix.row, record.data(), 8);
+  std::memcpy(&prefix.seq, record.data() + 8, 8);
+  std::memcpy(&prefix.flags, record.data() + 16, 4);
+  return prefix;
+}
+
+/**
+ * A version found while scanning.
+ */
+struct Version {
+  std::uint64_t seq;
+  RecordId location;
+  std::uint32_t length;
+  bool tombstone;
+};
+
+}
+
+LogStructuredHeap::LogStructuredHeap(BufMgr* buf_mgr, File* file)
+    : buf_mgr_(buf_mgr),
+      file_(file),
+      tail_(Page::INVALID_NUMBER),
+      next_row_(1),
+      next_seq_(1),
+      pages_cleaned_(0) {
+  std::map<RowId, Version> latest;
+  for (FileIterator iter = file_->begin(); iter != file_->end(); ++iter) {
+    const PageId page_number = iter.page_number();
+    live_bytes_[page_number] = 0;
+    Page* page;
+    buf_mgr_->readPage(file_, page_number, page);
+    for (PageIterator record_iter = page->begin();
+         record_iter != page->end();
+         ++record_iter) {
+      const std::string record = *record_iter;
+      const VersionPrefix prefix = decode(record);
+      ++versions_[prefix.row];
+      next_row_ = std::max(next_row_, prefix.row + 1);
+      next_seq_ = std::max(next_seq_, prefix.seq + 1);
+      std::map<RowId, Version>::iterator found = latest.find(prefix.row);
+      if (found == latest.end() || found->second.seq < prefix.seq) {
+        const Version version = {prefix.seq, record_iter.record_id(),
+                                 static_cast<std::uint32_t>(record.size()),
+                                 (prefix.flags & TOMBSTONE) != 0};
+        latest[prefix.row] = version;
+      }
+    }
+    buf_mgr_->unPinPage(file_, page_number, false /* dirty */);
+  }
+  for (std::map<RowId, Version>::iterator iter = latest.begin();
+       iter != latest.end();
+       ++iter) {
+    if (!iter->second.tombstone) {
+      const RowEntry entry = {iter->second.location, iter->second.length};
+      rows_[iter->first] = entry;
+      live_bytes_[entry.location.page_number] += entry.length;
+    }
+  }
+}
+
+LogStructuredHeap::RowId LogStructuredHeap::insert(const std::string& data) {
+  const RowId row = next_row_++;
+  RowEntry entry;
+  entry.location = append(row, false /* tombstone */, data, entry.length);
+  rows_[row] = entry;
+  live_bytes_[entry.location.page_number] += entry.length;
+  return row;
+}
+
+void LogStructuredHeap::update(const RowId row, const std::string& data) {
+  std::map<RowId, RowEntry>::iterator found = rows_.find(row);
+  if (found == rows_.end()) {
+    throw RowNotFoundException(file_->filename(), row);
+  }
+  retire(found->second);
+  found->second.location =
+      append(row, false /* tombstone */, data, found->second.length);
+  live_bytes_[found->second.location.page_number] += found->second.length;
+}
+
+void LogStructuredHeap::remove(const RowId row) {
+  std::map<RowId, RowEntry>::iterator found = rows_.find(row);
+  if (found == rows_.end()) {
+    throw RowNotFoundException(file_->filename(), row);
+  }
+  retire(found->second);
+  rows_.erase(found);
+  std::uint32_t length;
+  append(row, true /* tombstone */, "", length);
+}
+
+std::string LogStructuredHeap::read(const RowId row) {
+  const RecordId location = this->location(row);
+  Page* page;
+  buf_mgr_->readPage(file_, location.page_number, page);
+  const std::string record = page->getRecord(location);
+  buf_mgr_->unPinPage(file_, location.page_number, false /* dirty */);
+  return record.substr(PREFIX_SIZE);
+}
+
+RecordId LogStructuredHeap::location(const RowId row) const {
+  std::map<RowId, RowEntry>::const_iterator found = rows_.find(row);
+  if (found == rows_.end()) {
+    throw RowNotFoundException(file_->filename(), row);
+  }
+  return found->second.location;
+}
+
+std::uint32_t LogStructuredHeap::clean(const double max_utilization,
+                                       const std::uint32_t max_pages) {
+  const std::size_t limit =
+      static_cast<std::size_t>(max_utilization * Page::DATA_SIZE);
+  std::vector<std::pair<std::size_t, PageId> > candidates;
+  for (std::map<PageId, std::size_t>::iterator iter = live_bytes_.begin();
+       iter != live_bytes_.end();
+       ++iter) {
+    if (iter->first != tail_ && iter->second < limit) {
+      candidates.push_back(std::make_pair(iter->second, iter->first));
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+  if (candidates.size() > max_pages) {
+    candidates.resize(max_pages);
+  }
+
+  // Pages the live versions were copied to.
+  std::set<PageId> targets;
+  for (std::size_t i = 0; i < candidates.size(); ++i) {
+    const PageId page_number = candidates[i].second;
+    std::vector<std::pair<RecordId, std::string> > records;
+    Page* page;
+    buf_mgr_->readPage(file_, page_number, page);
+    for (PageIterator iter = page->begin(); iter != page->end(); ++iter) {
+      records.push_back(std::make_pair(iter.record_id(), *iter));
+    }
+    buf_mgr_->unPinPage(file_, page_number, false /* dirty */);
+
+    // Versions first, so that tombstones whose older versions sit on this
+    // very page are recognized as no longer needed.
+    for (int pass = 0; pass < 2; ++pass) {
+      for (std::size_t r = 0; r < records.size(); ++r) {
+        const VersionPrefix prefix = decode(records[r].second);
+        const bool tombstone = (prefix.flags & TOMBSTONE) != 0;
+        if (tombstone != (pass == 1)) {
+          continue;
+        }
+        if (tombstone) {
+          if (versions_[prefix.row] > 1) {
+            std::uint32_t length;
+            targets.insert(
+                append(prefix.row, true /* tombstone */, "", length)
+                    .page_number);
+          }
+        } else {
+          std::map<RowId, RowEntry>::iterator found = rows_.find(prefix.row);
+          if (found != rows_.end() &&
+              found->second.location == records[r].first) {
+            found->second.location =
+                append(prefix.row, false /* tombstone */,
+                       records[r].second.substr(PREFIX_SIZE),
+                       found->second.length);
+            live_bytes_[found->second.location.page_number] +=
+                found->second.length;
+            targets.insert(found->second.location.page_number);
+          }
+        }
+        forgetVersion(prefix.row);
+      }
+    }
+  }
+
+  // The copies must be durable before the pages holding the originals go.
+  for (std::set<PageId>::const_iterator iter = targets.begin();
+       iter != targets.end(); ++iter) {
+    buf_mgr_->flushPage(file_, *iter);
+  }
+  for (std::size_t i = 0; i < candidates.size(); ++i) {
+    const PageId page_number = candidates[i].second;
+    buf_mgr_->disposePage(file_, page_number);
+    live_bytes_.erase(page_number);
+    ++pages_cleaned_;
+  }
+  return candidates.size();
+}
+
+RecordId LogStructuredHeap::append(const RowId row, const bool tombstone,
+                                   const std::string& data,
+                                   std::uint32_t& length) {
+  const VersionPrefix prefix = {row, next_seq_++,
+                                tombstone ? TOMBSTONE : 0};
+  const std::string record = encode(prefix, data);
+  length = record.size();
+
+  Page* page = NULL;
+  if (tail_ != Page::INVALID_NUMBER) {
+    buf_mgr_->readPage(file_, tail_, page);
+    if (!page->hasSpaceForRecord(record)) {
+      // The tail is full and will never be written again.
+      buf_mgr_->unPinPage(file_, tail_, false /* dirty */);
+      page = NULL;
+    }
+  }
+  if (page == NULL) {
+    // Always at the end of the file, so the tail pages are written in order.
+    buf_mgr_->appendPage(file_, tail_, page);
+    live_bytes_[tail_] = 0;
+  }
+  const RecordId location = page->insertRecord(record);
+  buf_mgr_->unPinPage(file_, tail_, true /* dirty */);
+  ++versions_[row];
+  return location;
+}
+
+void LogStructuredHeap::retire(const RowEntry& entry) {
+  live_bytes_[entry.location.page_number] -= entry.length;
+}
+
+void LogStructuredHeap::forgetVersion(const RowId row) {
+  std::map<RowId, std::uint32_t>::iterator found = versions_.find(row);
+  if (found != versions_.end() && --found->second == 0) {
+    versions_.erase(found);
+  }
+}
+
+}
@@ -0,0 +1,174 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "buffer.h"
+#include "file.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Heap file that is only ever appended to.
+ *
+ * A slotted heap updates records in place, so write-backs land all over the
+ * file.  A log-structured heap never modifies a page once it has been filled:
+ * inserts, updates and removals all append a new record version to the tail
+ * page, and an in-memory map takes a row to the location of its latest
+ * version.  Because only the tail page is dirty and new tail pages are always
+ * added at the end of the file, never in a freed page, write-backs are
+ * sequential.
+ *
+ * Older versions become garbage.  clean() picks the pages with the least live
+ * data, copies their live versions to the tail and frees them, which is the
+ * only time the file is written out of order.
+ *
+ * Each stored record carries a prefix with its row and a sequence number, so
+ * the map is rebuilt by a scan when the heap is opened; removals append a
+ * tombstone that is kept until no older version of its row is left.
+ *
+ * A File is used either through this class or as a slotted heap through Page,
+ * never both.
+ */
+class LogStructuredHeap {
+ public:
+  /**
+   * Identifies a row independently of where its current version is stored.
+   */
+  typedef std::uint64_t RowId;
+
+  /**
+   * Opens a log-structured heap on a file and rebuilds its row map by
+   * scanning it.
+   *
+   * @param buf_mgr   Buffer manager used to access the pages.
+   * @param file      Heap file.
+   */
+  LogStructuredHeap(BufMgr* buf_mgr, File* file);
+
+  /**
+   * Appends a new row.
+   *
+   * @param data  Contents of the row.
+   * @return  Identifier of the row.
+   */
+  RowId insert(const std::string& data);
+
+  /**
+   * Appends a new version of a row.
+   *
+   * @param row   Row to update.
+   * @param data  New contents.
+   * @throws  RowNotFoundException  If the row does not exist.
+   */
+  void update(const RowId row, const std::string& data);
+
+  /**
+   * Removes a row.
+   *
+   * @param row   Row to remove.
+   * @throws  RowNotFoundException  If the row does not exist.
+   */
+  void remove(const RowId row);
+
+  /**
+   * Returns the current contents of a row.
+   *
+   * @param row   Row to read.
+   * @throws  RowNotFoundException  If the row does not exist.
+   */
+  std::string read(const RowId row);
+
+  /**
+   * Returns the location of the current version of a row.
+   *
+   * @param row   Row to look up.
+   * @throws  RowNotFoundException  If the row does not exist.
+   */
+  RecordId location(const RowId row) const;
+
+  /**
+   * Returns the number of rows.
+   */
+  std::size_t size() const { return rows_.size(); }
+
+  /**
+   * Reclaims space: frees up to <max_pages> pages whose live data fills less
+   * than <max_utilization> of the page, after copying their live versions to
+   * the tail.  The pages with the least live data go first.  The copies are
+   * written back and the file synced before any page is freed, so a crash
+   * never loses a row.
+   *
+   * @param max_utilization   Only pages filled below this fraction are
+   *                          cleaned.
+   * @param max_pages         Maximum number of pages cleaned by this call.
+   * @return  Number of pages freed.
+   */
+  std::uint32_t clean(const double max_utilization,
+                      const std::uint32_t max_pages);
+
+  /**
+   * Returns the number of pages freed by clean() so far.
+   */
+  std::uint64_t pagesCleaned() const { return pages_cleaned_; }
+
+ private:
+  /**
+   * Where the current version of a row lives.
+   */
+  struct RowEntry {
+    RecordId location;
+    std::uint32_t length;
+  };
+
+  /**
+   * Appends a version and returns its location.  Accounts for it in
+   * <versions_> but not in <live_bytes_>.
+   */
+  RecordId append(const RowId row, const bool tombstone,
+                  const std::string& data, std::uint32_t& length);
+
+  /**
+   * Marks the current version of a row as garbage.
+   */
+  void retire(const RowEntry& entry);
+
+  /**
+   * Drops one stored version of a row from <versions_>.
+   */
+  void forgetVersion(const RowId row);
+
+  BufMgr* buf_mgr_;
+  File* file_;
+
+  /**
+   * Latest version of every row.
+   */
+  std::map<RowId, RowEntry> rows_;
+
+  /**
+   * Number of versions, tombstones included, stored for each row.
+   */
+  std::map<RowId, std::uint32_t> versions_;
+
+  /**
+   * Bytes of current versions on each page.
+   */
+  std::map<PageId, std::size_t> live_bytes_;
+
+  PageId tail_;
+  RowId next_row_;
+  std::uint64_t next_seq_;
+  std::uint64_t pages_cleaned_;
+};
+
+}
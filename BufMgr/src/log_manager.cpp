@@ -0,0 +1,410 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "log_manager.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "crc32c.h"
+#include "exceptions/file_io_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+const char LOG_MAGIC[] = "BADGERDB-WAL-02";
+
+/**
+ * Writes all of <length> bytes at <offset>, retrying short writes.
+ */
+bool writeFully(const int fd, const char* data, std::size_t length,
+                off_t offset) {
+  while (length > 0) {
+    const ssize_t written = ::pwrite(fd, data, length, offset);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data += written;
+    length -= written;
+    offset += written;
+  }
+  return true;
+}
+
+/**
+ * Reads all of <length> bytes at <offset>.  Returns false at end of file.
+ */
+bool readFully(const int fd, char* data, std::size_t length, off_t offset) {
+  while (length > 0) {
+    const ssize_t read = ::pread(fd, data, length, offset);
+    if (read < 0 && errno == EINTR) continue;
+    if (read <= 0) return false;
+    data += read;
+    length -= read;
+    offset += read;
+  }
+  return true;
+}
+
+}
+
+LogManager::LogManager(const std::string& filename)
+    : filename_(filename),
+      fd_(-1),
+      tail_lsn_(LOG_HEADER_SIZE),
+      next_lsn_(LOG_HEADER_SIZE),
+      flushed_lsn_(LOG_HEADER_SIZE),
+      flushing_(false),
+      sync_count_(0),
+      checkpoint_lsn_(0),
+      next_txn_(1) {
+  fd_ = ::open(filename_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    throw FileIOException(filename_, "open", errno);
+  }
+  const off_t size = ::lseek(fd_, 0, SEEK_END);
+  if (size < static_cast<off_t>(LOG_HEADER_SIZE)) {
+    char header[LOG_HEADER_SIZE] = {0};
+    std::memcpy(header, LOG_MAGIC, sizeof(LOG_MAGIC));
+    if (!writeFully(fd_, header, sizeof(header), 0) || ::fdatasync(fd_) != 0) {
+      throw FileIOException(filename_, "write", errno);
+    }
+    return;
+  }
+
+  char magic[sizeof(LOG_MAGIC)];
+  if (!readFully(fd_, magic, sizeof(magic), 0) ||
+      !readFully(fd_, reinterpret_cast<char*>(&checkpoint_lsn_),
+                 sizeof(checkpoint_lsn_), CHECKPOINT_LSN_OFFSET)) {
+    throw FileIOException(filename_, "read", errno);
+  }
+  if (std::memcmp(magic, LOG_MAGIC, sizeof(magic)) != 0) {
+    // Records of another format would fail their checksums and be cut off.
+    throw FileIOException(filename_, "open (unknown log format)", EINVAL);
+  }
+
+  // Find the end of the log, ignoring a record torn by a crash and everything
+  // after it, and make sure transaction IDs are never reused.
+  Lsn lsn = LOG_HEADER_SIZE;
+  Lsn next = lsn;
+  LogRecord record;
+  next_lsn_ = flushed_lsn_ = static_cast<Lsn>(size);
+  while (readRecord(lsn, record, next)) {
+    if (record.txn >= next_txn_) {
+      next_txn_ = record.txn + 1;
+    }
+    lsn = next;
+  }
+  if (checkpoint_lsn_ >= lsn) {
+    // The checkpoint was cut off with the end of the log.
+    checkpoint_lsn_ = 0;
+  }
+  if (lsn != static_cast<Lsn>(size) && ::ftruncate(fd_, lsn) != 0) {
+    throw FileIOException(filename_, "ftruncate", errno);
+  }
+  tail_lsn_ = next_lsn_ = flushed_lsn_ = lsn;
+}
+
+LogManager::~LogManager() {
+  try {
+    flushAll();
+  } catch (FileIOException&) {
+  }
+  ::close(fd_);
+}
+
+TxnId LogManager::begin() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const TxnId txn = next_txn_++;
+  last_lsn_[txn] = 0;
+  return txn;
+}
+
+Lsn LogManager::logUpdate(const TxnId txn, const File* file,
+                          const Page& before, Page& after) {
+  const std::string before_image = encodePage(before);
+  std::lock_guard<std::mutex> lock(mutex_);
+  // The after image must carry its own LSN, so stamp the page first.
+  after.set_page_lsn(next_lsn_);
+  const Lsn lsn = append(LOG_UPDATE, txn, file->filename(),
+                         after.page_number(), before_image,
+                         encodePage(after));
+  return lsn;
+}
+
+Lsn LogManager::logCompensation(const TxnId txn, const File* file,
+                                Page& page, const Lsn undo_next_lsn) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  page.set_page_lsn(next_lsn_);
+  return append(LOG_CLR, txn, file->filename(), page.page_number(), "",
+                encodePage(page), undo_next_lsn);
+}
+
+void LogManager::resume(const TxnId txn, const Lsn last_lsn) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  last_lsn_[txn] = last_lsn;
+}
+
+Lsn LogManager::commit(const TxnId txn) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const Lsn lsn = append(LOG_COMMIT, txn, "", Page::INVALID_NUMBER, "", "");
+  last_lsn_.erase(txn);
+  flushLocked(lock, lsn);
+  return lsn;
+}
+
+Lsn LogManager::abort(const TxnId txn) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const Lsn lsn = append(LOG_ABORT, txn, "", Page::INVALID_NUMBER, "", "");
+  last_lsn_.erase(txn);
+  return lsn;
+}
+
+Lsn LogManager::logCheckpoint(const std::vector<DirtyPageEntry>& dirty_pages) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  std::string txn_table;
+  for (std::map<TxnId, Lsn>::const_iterator iter = last_lsn_.begin();
+       iter != last_lsn_.end(); ++iter) {
+    const ActiveTxnEntry entry = {iter->first, iter->second};
+    txn_table.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+  }
+  std::string page_table;
+  for (std::size_t i = 0; i < dirty_pages.size(); ++i) {
+    const std::uint32_t length =
+        static_cast<std::uint32_t>(dirty_pages[i].filename.length());
+    page_table.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    page_table.append(dirty_pages[i].filename);
+    page_table.append(
+        reinterpret_cast<const char*>(&dirty_pages[i].page_number),
+        sizeof(dirty_pages[i].page_number));
+    page_table.append(reinterpret_cast<const char*>(&dirty_pages[i].rec_lsn),
+                      sizeof(dirty_pages[i].rec_lsn));
+  }
+  // Checkpoint records do not belong to any transaction; TxnId 0 is never
+  // handed out by begin().
+  const Lsn lsn = append(LOG_CHECKPOINT, 0 /* txn */, "", Page::INVALID_NUMBER,
+                         txn_table, page_table);
+  last_lsn_.erase(0);
+  flushLocked(lock, lsn);
+
+  // Only point recovery at the checkpoint once the record itself is durable.
+  if (!writeFully(fd_, reinterpret_cast<const char*>(&lsn), sizeof(lsn),
+                  CHECKPOINT_LSN_OFFSET) || ::fdatasync(fd_) != 0) {
+    throw FileIOException(filename_, "fdatasync", errno);
+  }
+  ++sync_count_;
+  checkpoint_lsn_ = lsn;
+  return lsn;
+}
+
+Lsn LogManager::checkpointLsn() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return checkpoint_lsn_;
+}
+
+void LogManager::decodeCheckpoint(const LogRecord& record,
+                                  std::vector<ActiveTxnEntry>& active_txns,
+                                  std::vector<DirtyPageEntry>& dirty_pages) {
+  for (std::size_t offset = 0; offset + sizeof(ActiveTxnEntry) <=
+       record.before.length(); offset += sizeof(ActiveTxnEntry)) {
+    ActiveTxnEntry entry;
+    std::memcpy(&entry, record.before.data() + offset, sizeof(entry));
+    active_txns.push_back(entry);
+  }
+  const std::string& table = record.after;
+  std::size_t offset = 0;
+  while (offset < table.length()) {
+    DirtyPageEntry entry;
+    std::uint32_t length;
+    std::memcpy(&length, table.data() + offset, sizeof(length));
+    offset += sizeof(length);
+    entry.filename.assign(table, offset, length);
+    offset += length;
+    std::memcpy(&entry.page_number, table.data() + offset,
+                sizeof(entry.page_number));
+    offset += sizeof(entry.page_number);
+    std::memcpy(&entry.rec_lsn, table.data() + offset, sizeof(entry.rec_lsn));
+    offset += sizeof(entry.rec_lsn);
+    dirty_pages.push_back(entry);
+  }
+}
+
+void LogManager::flush(const Lsn lsn) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  flushLocked(lock, lsn);
+}
+
+void LogManager::flushAll() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (next_lsn_ > flushed_lsn_) {
+    flushLocked(lock, next_lsn_ - 1);
+  }
+}
+
+Lsn LogManager::nextLsn() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return next_lsn_;
+}
+
+Lsn LogManager::flushedLsn() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return flushed_lsn_;
+}
+
+std::uint64_t LogManager::syncCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return sync_count_;
+}
+
+Lsn LogManager::append(const LogRecordType type, const TxnId txn,
+                       const std::string& filename, const PageId page_number,
+                       const std::string& before, const std::string& after,
+                       const Lsn undo_next_lsn) {
+  RecordHeader header;
+  // Padding is covered by the checksum, so it must have a defined value.
+  std::memset(&header, 0, sizeof(header));
+  header.length = static_cast<std::uint32_t>(
+      sizeof(header) + filename.length() + sizeof(std::uint32_t) +
+      before.length() + after.length());
+  header.type = type;
+  header.lsn = next_lsn_;
+  header.prev_lsn = last_lsn_[txn];
+  header.undo_next_lsn = undo_next_lsn;
+  header.txn = txn;
+  header.page_number = page_number;
+  header.filename_length = static_cast<std::uint32_t>(filename.length());
+  const std::uint32_t before_length =
+      static_cast<std::uint32_t>(before.length());
+
+  const std::size_t start = tail_.length();
+  tail_.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  tail_.append(filename);
+  tail_.append(reinterpret_cast<const char*>(&before_length),
+               sizeof(before_length));
+  tail_.append(before);
+  tail_.append(after);
+  const std::uint32_t crc = crc32c(tail_.data() + start, header.length);
+  std::memcpy(&tail_[start + offsetof(RecordHeader, crc)], &crc, sizeof(crc));
+
+  last_lsn_[txn] = header.lsn;
+  next_lsn_ += header.length;
+  return header.lsn;
+}
+
+void LogManager::flushLocked(std::unique_lock<std::mutex>& lock,
+                             Lsn lsn) {
+  // A page stamped by another or a recreated log can carry an LSN this log
+  // never reached; no flush could ever cover it.
+  lsn = std::min(lsn, next_lsn_ - 1);
+  while (flushed_lsn_ <= lsn) {
+    if (flushing_) {
+      // Somebody else is syncing; whatever we appended will be picked up by
+      // the next group if it is not part of this one.
+      flushed_.wait(lock);
+      continue;
+    }
+    flushing_ = true;
+    std::string group;
+    group.swap(tail_);
+    const Lsn group_lsn = tail_lsn_;
+    const Lsn group_end = next_lsn_;
+    tail_lsn_ = group_end;
+
+    lock.unlock();
+    int error = 0;
+    if (!writeFully(fd_, group.data(), group.length(), group_lsn)) {
+      error = errno;
+    } else if (::fdatasync(fd_) != 0) {
+      error = errno;
+    }
+    lock.lock();
+
+    flushing_ = false;
+    if (error != 0) {
+      // Put the group back so a later flush can retry it.
+      tail_.insert(0, group);
+      tail_lsn_ = group_lsn;
+      flushed_.notify_all();
+      throw FileIOException(filename_, "fdatasync", error);
+    }
+    flushed_lsn_ = group_end;
+    ++sync_count_;
+    flushed_.notify_all();
+  }
+}
+
+bool LogManager::readRecord(const Lsn lsn, LogRecord& record,
+                            Lsn& next_lsn) {
+  RecordHeader header;
+  struct stat info;
+  if (::fstat(fd_, &info) != 0) {
+    throw FileIOException(filename_, "fstat", errno);
+  }
+  // A torn or overwritten length must not make us read past the end of the
+  // file, or allocate that much.
+  const Lsn size = static_cast<Lsn>(info.st_size);
+  if (!readFully(fd_, reinterpret_cast<char*>(&header), sizeof(header), lsn) ||
+      header.lsn != lsn || header.length < sizeof(header) + sizeof(std::uint32_t) ||
+      header.length > size - lsn) {
+    return false;
+  }
+  std::string body(header.length - sizeof(header), '\0');
+  if (!readFully(fd_, &body[0], body.length(), lsn + sizeof(header))) {
+    return false;
+  }
+  const std::uint32_t crc = header.crc;
+  header.crc = 0;
+  if (crc32c(body.data(), body.length(),
+             crc32c(&header, sizeof(header))) != crc) {
+    return false;
+  }
+  std::uint32_t before_length;
+  const std::size_t before_offset =
+      header.filename_length + sizeof(before_length);
+  if (before_offset > body.length()) {
+    return false;
+  }
+  std::memcpy(&before_length, body.data() + header.filename_length,
+              sizeof(before_length));
+  if (before_length > body.length() - before_offset) {
+    return false;
+  }
+
+  record.type = static_cast<LogRecordType>(header.type);
+  record.lsn = header.lsn;
+  record.prev_lsn = header.prev_lsn;
+  record.undo_next_lsn = header.undo_next_lsn;
+  record.txn = header.txn;
+  record.page_number = header.page_number;
+  record.filename.assign(body, 0, header.filename_length);
+  record.before.assign(body, before_offset, before_length);
+  record.after.assign(body, before_offset + before_length, std::string::npos);
+  next_lsn = lsn + header.length;
+  return true;
+}
+
+std::string LogManager::encodePage(const Page& page) {
+  std::string image(reinterpret_cast<const char*>(&page.header_),
+                    sizeof(page.header_));
+  image.append(page.data_.data(), page.data_.size());
+  return image;
+}
+
+void LogManager::decodePage(const std::string& image, Page& page) {
+  std::memcpy(&page.header_, image.data(), sizeof(page.header_));
+  page.data_.assign(image.data() + sizeof(page.header_),
+                    image.size() - sizeof(page.header_));
+}
+
+}
@@ -0,0 +1,442 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Kinds of records stored in the write-ahead log.
+ */
+enum LogRecordType {
+  /**
+   * Physical change to one page: carries the before and after image.
+   */
+  LOG_UPDATE = 1,
+
+  /**
+   * Transaction committed.
+   */
+  LOG_COMMIT = 2,
+
+  /**
+   * Transaction rolled back; all of its updates have been undone.
+   */
+  LOG_ABORT = 3,
+
+  /**
+   * Fuzzy checkpoint: carries the active transaction table and the dirty page
+   * table at the time it was taken.
+   */
+  LOG_CHECKPOINT = 4,
+
+  /**
+   * Compensation record written while rolling back an update: carries the
+   * restored page as its after image and the LSN of the next record of the
+   * transaction to undo.  It is redone but never undone itself.
+   */
+  LOG_CLR = 5
+};
+
+/**
+ * @brief Entry of the active transaction table stored in a checkpoint.
+ */
+struct ActiveTxnEntry {
+  /**
+   * Running transaction.
+   */
+  TxnId txn;
+
+  /**
+   * LSN of its latest log record, or 0 if it has not logged anything yet.
+   */
+  Lsn last_lsn;
+};
+
+/**
+ * @brief Entry of the dirty page table stored in a checkpoint.
+ */
+struct DirtyPageEntry {
+  /**
+   * Name of the file of the dirty page.
+   */
+  std::string filename;
+
+  /**
+   * Number of the dirty page.
+   */
+  PageId page_number;
+
+  /**
+   * No log record before this LSN describes a change missing from the page on
+   * disk, so redo of the page may start here.
+   */
+  Lsn rec_lsn;
+};
+
+/**
+ * @brief A log record as read back from the log.
+ */
+struct LogRecord {
+  /**
+   * Kind of record.
+   */
+  LogRecordType type;
+
+  /**
+   * LSN of this record.
+   */
+  Lsn lsn;
+
+  /**
+   * LSN of the previous record of the same transaction, or 0.
+   */
+  Lsn prev_lsn;
+
+  /**
+   * Transaction that wrote the record.
+   */
+  TxnId txn;
+
+  /**
+   * Name of the file of the changed page (LOG_UPDATE and LOG_CLR only).
+   */
+  std::string filename;
+
+  /**
+   * Number of the changed page (LOG_UPDATE and LOG_CLR only).
+   */
+  PageId page_number;
+
+  /**
+   * LSN of the next record of the transaction to undo, or 0 if there is none
+   * (LOG_CLR only).
+   */
+  Lsn undo_next_lsn;
+
+  /**
+   * Image of the page before the change, as produced by encodePage().
+   */
+  std::string before;
+
+  /**
+   * Image of the page after the change, as produced by encodePage().
+   */
+  std::string after;
+};
+
+/**
+ * @brief Write-ahead log with group commit.
+ *
+ * Records are appended to an in-memory tail and written sequentially to the
+ * log file.  The LSN of a record is its byte offset in the log, so LSNs grow
+ * monotonically and flushing "up to" an LSN is a single sequential write plus
+ * one fdatasync().  When several threads need the log flushed at the same
+ * time, the first one becomes the leader and flushes everything appended so
+ * far while the others wait for it; one sync therefore covers a whole group of
+ * commits.
+ *
+ * Updates are logged with full before and after page images.  The caller logs
+ * a change with logUpdate() while the page is pinned, which stamps the page
+ * with the record's LSN; BufMgr then refuses to write a page back before the
+ * log is durable up to that LSN (see BufMgr::setLogManager()).
+ *
+ * All public methods are threadsafe.
+ */
+class LogManager {
+ public:
+  /**
+   * Opens the log file, creating it if it does not exist.  New records are
+   * appended after the existing contents.
+   *
+   * @param filename  Name of the log file.
+   * @throws  FileIOException  If the log file cannot be opened.
+   */
+  explicit LogManager(const std::string& filename);
+
+  /**
+   * Flushes the log and closes the log file.
+   */
+  ~LogManager();
+
+  /**
+   * Starts a new transaction.
+   *
+   * @return  Identifier of the transaction.
+   */
+  TxnId begin();
+
+  /**
+   * Logs a change to a pinned page and stamps <after> with the LSN of the new
+   * record.
+   *
+   * @param txn     Transaction making the change.
+   * @param file    File the page belongs to.
+   * @param before  Copy of the page taken before the change.
+   * @param after   The changed page (normally the buffer pool frame).
+   * @return  LSN of the record.
+   */
+  Lsn logUpdate(const TxnId txn, const File* file, const Page& before,
+                Page& after);
+
+  /**
+   * Logs the rollback of an update to a pinned page as a compensation record
+   * and stamps <page> with its LSN.
+   *
+   * @param txn             Transaction being rolled back.
+   * @param file            File the page belongs to.
+   * @param page            The page with the before image restored.
+   * @param undo_next_lsn   LSN of the next record of <txn> to undo, i.e. the
+   *                        prev_lsn of the undone update.
+   * @return  LSN of the record.
+   */
+  Lsn logCompensation(const TxnId txn, const File* file, Page& page,
+                      const Lsn undo_next_lsn);
+
+  /**
+   * Continues a transaction found in the log by recovery, so that its next
+   * record is chained to <last_lsn>.
+   *
+   * @param txn       Transaction that was running at the crash.
+   * @param last_lsn  LSN of its latest record.
+   */
+  void resume(const TxnId txn, const Lsn last_lsn);
+
+  /**
+   * Logs the commit of a transaction and waits until the log is durable up to
+   * and including the commit record.
+   *
+   * @param txn   Transaction to commit.
+   * @return  LSN of the commit record.
+   */
+  Lsn commit(const TxnId txn);
+
+  /**
+   * Logs that a transaction has been rolled back.  The caller is responsible
+   * for having restored the before images of its updates.
+   *
+   * @param txn   Transaction that was rolled back.
+   * @return  LSN of the abort record.
+   */
+  Lsn abort(const TxnId txn);
+
+  /**
+   * Logs a fuzzy checkpoint holding the currently running transactions and
+   * the given dirty page table, waits until it is durable and records its LSN
+   * in the log header as the starting point for recovery.
+   *
+   * @param dirty_pages   Dirty page table of the buffer manager.
+   * @return  LSN of the checkpoint record.
+   */
+  Lsn logCheckpoint(const std::vector<DirtyPageEntry>& dirty_pages);
+
+  /**
+   * Returns the LSN of the latest complete checkpoint, or 0 if there is none.
+   */
+  Lsn checkpointLsn();
+
+  /**
+   * Extracts the tables stored in a LOG_CHECKPOINT record.
+   *
+   * @param record        Checkpoint record.
+   * @param active_txns   Receives the active transaction table.
+   * @param dirty_pages   Receives the dirty page table.
+   */
+  static void decodeCheckpoint(const LogRecord& record,
+                               std::vector<ActiveTxnEntry>& active_txns,
+                               std::vector<DirtyPageEntry>& dirty_pages);
+
+  /**
+   * Makes the log durable up to and including the record at <lsn>.  Returns
+   * immediately if that is already the case.  An LSN beyond the end of the
+   * log, e.g. the LSN of a page changed under another log, makes the whole
+   * log durable.
+   *
+   * @param lsn   LSN which must be durable on return.
+   * @throws  FileIOException  If writing or syncing the log fails.
+   */
+  void flush(const Lsn lsn);
+
+  /**
+   * Makes every record appended so far durable.
+   */
+  void flushAll();
+
+  /**
+   * Returns the LSN the next record will get.
+   */
+  Lsn nextLsn();
+
+  /**
+   * Returns the LSN up to which (exclusive) the log is durable.
+   */
+  Lsn flushedLsn();
+
+  /**
+   * Returns the number of fdatasync() calls performed so far.
+   */
+  std::uint64_t syncCount();
+
+  /**
+   * Returns the LSN of the first record of the log.
+   */
+  static Lsn firstLsn() { return LOG_HEADER_SIZE; }
+
+  /**
+   * Reads the durable record at <lsn>.
+   *
+   * @param lsn       LSN of the record to read.
+   * @param record    Receives the record.
+   * @param next_lsn  Receives the LSN of the following record.
+   * @return  False if there is no complete record with a matching checksum at
+   *          <lsn> (end of log).
+   */
+  bool readRecord(const Lsn lsn, LogRecord& record, Lsn& next_lsn);
+
+  /**
+   * Returns the name of the log file.
+   */
+  const std::string& filename() const { return filename_; }
+
+  /**
+   * Serializes a page (header and data) into a byte string.
+   *
+   * @param page  Page to serialize.
+   * @return  Page image.
+   */
+  static std::string encodePage(const Page& page);
+
+  /**
+   * Restores a page from an image produced by encodePage().
+   *
+   * @param image   Page image.
+   * @param page    Page to overwrite.
+   */
+  static void decodePage(const std::string& image, Page& page);
+
+ private:
+  /**
+   * Size of the header written at the start of a new log file.
+   */
+  static const Lsn LOG_HEADER_SIZE = 32;
+
+  /**
+   * Offset in the log header of the LSN of the latest checkpoint.
+   */
+  static const off_t CHECKPOINT_LSN_OFFSET = 16;
+
+  /**
+   * Fixed-size prefix of every record in the log file.
+   */
+  struct RecordHeader {
+    std::uint32_t length;
+    std::uint32_t type;
+    Lsn lsn;
+    Lsn prev_lsn;
+    Lsn undo_next_lsn;
+    TxnId txn;
+    PageId page_number;
+    std::uint32_t filename_length;
+    /**
+     * CRC-32C of the record with this field zero.
+     */
+    std::uint32_t crc;
+  };
+
+  /**
+   * Appends a record to the log tail and links it into the chain of records
+   * of its transaction.  Must be called with <mutex_> held.
+   */
+  Lsn append(const LogRecordType type, const TxnId txn,
+             const std::string& filename, const PageId page_number,
+             const std::string& before, const std::string& after,
+             const Lsn undo_next_lsn = 0);
+
+  /**
+   * Flushes up to <lsn> with <mutex_> held through <lock>.
+   */
+  void flushLocked(std::unique_lock<std::mutex>& lock, const Lsn lsn);
+
+  /**
+   * Name of the log file.
+   */
+  std::string filename_;
+
+  /**
+   * Descriptor of the log file.
+   */
+  int fd_;
+
+  /**
+   * Protects all members below.
+   */
+  std::mutex mutex_;
+
+  /**
+   * Signalled whenever a group flush finishes.
+   */
+  std::condition_variable flushed_;
+
+  /**
+   * Records appended but not yet written to the log file.
+   */
+  std::string tail_;
+
+  /**
+   * LSN of the first byte of <tail_>.
+   */
+  Lsn tail_lsn_;
+
+  /**
+   * LSN the next record will get.
+   */
+  Lsn next_lsn_;
+
+  /**
+   * Everything before this LSN is durable.
+   */
+  Lsn flushed_lsn_;
+
+  /**
+   * True while a leader is writing and syncing a group.
+   */
+  bool flushing_;
+
+  /**
+   * Number of fdatasync() calls performed.
+   */
+  std::uint64_t sync_count_;
+
+  /**
+   * LSN of the latest complete checkpoint, or 0.
+   */
+  Lsn checkpoint_lsn_;
+
+  /**
+   * Identifier of the next transaction.
+   */
+  TxnId next_txn_;
+
+  /**
+   * LSN of the latest record of every running transaction.
+   */
+  std::map<TxnId, Lsn> last_lsn_;
+};
+
+}
@@ -1,17 +1,46 @@
 #include <iostream>
 #include <stdlib.h>
 //#include <stdio.h>
+#include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "page.h"
 #include "buffer.h"
+#include "bufHashTbl.h"
+#include "hash_aggregate.h"
+#include "top_k.h"
+#include "log_manager.h"
+#include "checkpointer.h"
+#include "recovery.h"
+#include "double_write_buffer.h"
+#include "vacuum.h"
+#include "log_heap.h"
+#include "snapshot.h"
+#include "incremental_backup.h"
+#include "async_io.h"
+#include "shared_page_cache.h"
+#include "midpoint_lru.h"
+#include "tiny_lfu.h"
+#include "sampled_eviction.h"
 #include "file_iterator.h"
 #include "page_iterator.h"
 #include "exceptions/file_not_found_exception.h"
 #include "exceptions/invalid_page_exception.h"
+#include "exceptions/checksum_mismatch_exception.h"
+#include "exceptions/row_not_found_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
 #include "exceptions/buffer_exceeded_exception.h"
+#include "exceptions/invalid_quota_exception.h"
 
 #define PRINT_ERROR(str) \
 { \
@@ -36,6 +65,31 @@ void test3();
 void test4();
 void test5();
 void test6();
+void test7();
+void test8();
+void test9();
+void test10();
+void test11();
+void test12();
+void test13();
+void test14();
+void test15();
+void test16();
+void test17();
+void test18();
+void test19();
+void test20();
+void test21();
+void test22();
+void test23();
+void test24();
+void test25();
+void test26();
+void test27();
+void test28();
+void test29();
+void test30();
+void test31();
 void testBufMgr();
 
 int main() 
@@ -48,7 +102,7 @@ int main()
 	{
     File::remove(filename);
   }
-	catch(FileNotFoundException)
+	catch(FileNotFoundException &)
 	{
   }
 
@@ -121,7 +175,7 @@ void testBufMgr()
     File::remove(filename4);
     File::remove(filename5);
   }
-	catch(FileNotFoundException e)
+	catch(FileNotFoundException &e)
 	{
   }
 
@@ -146,6 +200,31 @@ void testBufMgr()
 	test4();
 	test5();
 	test6();
+	test7();
+	test8();
+	test9();
+	test10();
+	test11();
+	test12();
+	test13();
+	test14();
+	test15();
+	test16();
+	test17();
+	test18();
+	test19();
+	test20();
+	test21();
+	test22();
+	test23();
+	test24();
+	test25();
+	test26();
+	test27();
+	test28();
+	test29();
+	test30();
+	test31();
 
 	//Close files before deleting them
 	file1.~File();
@@ -254,7 +333,7 @@ void test3()
 		bufMgr->readPage(file4ptr, 1, page);
 		PRINT_ERROR("ERROR :: File4 should not exist. Exception should have been thrown before execution reaches this point.");
 	}
-	catch(InvalidPageException e)
+	catch(InvalidPageException &e)
 	{
 	}
 
@@ -272,7 +351,7 @@ void test4()
 		bufMgr->unPinPage(file4ptr, i, false);
 		PRINT_ERROR("ERROR :: Page is already unpinned. Exception should have been thrown before execution reaches this point.");
 	}
-	catch(PageNotPinnedException e)
+	catch(PageNotPinnedException &e)
 	{
 	}
 
@@ -295,7 +374,7 @@ void test5()
 		bufMgr->allocPage(file5ptr, tmp, page);
 		PRINT_ERROR("ERROR :: No more frames left for allocation. Exception should have been thrown before execution reaches this point.");
 	}
-	catch(BufferExceededException e)
+	catch(BufferExceededException &e)
 	{
 	}
 
@@ -319,7 +398,7 @@ void test6()
 		bufMgr->flushFile(file1ptr);
 		PRINT_ERROR("ERROR :: Pages pinned for file being flushed. Exception should have been thrown before execution reaches this point.");
 	}
-	catch(PagePinnedException e)
+	catch(PagePinnedException &e)
 	{
 	}
 
@@ -329,3 +408,2280 @@ void test6()
 		bufMgr->unPinPage(file1ptr, i, true);
 	bufMgr->flushFile(file1ptr);
 }
+
+void test7()
+{
+	//Grouping the records of file1 by page number modulo 10 with room for only 3 groups in memory, so most groups spill
+	HashAggregate aggregate(bufMgr, file1ptr,
+		[](const std::string& record) {
+			PageId pageNo;
+			sscanf(record.c_str(), "test.1 Page %u", &pageNo);
+			return std::to_string(pageNo % 10);
+		},
+		[](const std::string& record) {
+			PageId pageNo;
+			float value;
+			sscanf(record.c_str(), "test.1 Page %u %f", &pageNo, &value);
+			return (double)value;
+		},
+		3, 2);
+
+	std::vector<AggregateResult> results;
+	aggregate.execute(results);
+
+	if(results.size() != 10 || aggregate.spillFileCount() == 0)
+	{
+		PRINT_ERROR("ERROR :: WRONG NUMBER OF GROUPS OR NOTHING WAS SPILLED");
+	}
+
+	for (std::size_t k = 0; k < results.size(); k++)
+	{
+		PageId group = std::stoi(results[k].group);
+		double expected = 0;
+		for (i = 1; i <= num; i++)
+			if (i % 10 == group)
+				expected += i;
+		if(results[k].state.count != 10 || results[k].state.sum != expected)
+		{
+			PRINT_ERROR("ERROR :: AGGREGATE DID NOT MATCH");
+		}
+	}
+
+	std::cout << "Test 7 passed" << "\n";
+}
+
+void test8()
+{
+	ZoneMap::ValueExtractor pageValue = [](const std::string& record) {
+		PageId pageNo;
+		float value;
+		sscanf(record.c_str(), "test.1 Page %u %f", &pageNo, &value);
+		return (double)value;
+	};
+
+	//Top 5 records of file1 by value; the zone map should let most pages be pruned
+	ZoneMap zoneMap(pageValue);
+	zoneMap.build(bufMgr, file1ptr);
+	TopKScan topK(bufMgr, file1ptr, pageValue, 5, &zoneMap);
+	std::vector<ScoredRecord> top;
+	topK.execute(top);
+
+	if(top.size() != 5 || top[0].score != num || top[4].score != num - 4 || topK.pagesRead() != 5)
+	{
+		PRINT_ERROR("ERROR :: TOP-K RESULT DID NOT MATCH");
+	}
+
+	//LIMIT 10 must stop after the pages holding the first 10 records
+	LimitScan limit(bufMgr, file1ptr, 10);
+	std::vector<std::string> rows;
+	limit.execute(rows);
+
+	if(rows.size() != 10 || limit.pagesRead() != 10)
+	{
+		PRINT_ERROR("ERROR :: LIMIT READ TOO MANY PAGES");
+	}
+
+	std::cout << "Test 8 passed" << "\n";
+}
+
+void test9()
+{
+	const std::string& logname = "test.log";
+	std::remove(logname.c_str());
+	LogManager* log = new LogManager(logname);
+	bufMgr->setLogManager(log);
+
+	//Log an update to each of the first 10 pages of file1
+	Lsn lastLsn = 0;
+	for (i = 1; i <= 10; i++)
+	{
+		TxnId txn = log->begin();
+		bufMgr->readPage(file1ptr, i, page);
+		Page before = *page;
+		page->insertRecord("logged");
+		lastLsn = log->logUpdate(txn, file1ptr, before, *page);
+		if(page->page_lsn() != lastLsn)
+		{
+			PRINT_ERROR("ERROR :: PAGE LSN NOT STAMPED");
+		}
+		bufMgr->unPinPage(file1ptr, i, true);
+		log->commit(txn);
+	}
+
+	//Concurrent commits are batched into shared syncs
+	std::uint64_t syncsBefore = log->syncCount();
+	std::vector<std::thread> committers;
+	for (int t = 0; t < 8; t++)
+		committers.push_back(std::thread([log]() {
+			for (int k = 0; k < 20; k++)
+				log->commit(log->begin());
+		}));
+	for (std::size_t t = 0; t < committers.size(); t++)
+		committers[t].join();
+	if(log->flushedLsn() != log->nextLsn())
+	{
+		PRINT_ERROR("ERROR :: COMMITS NOT DURABLE");
+	}
+	if(log->syncCount() - syncsBefore >= 8 * 20)
+	{
+		PRINT_ERROR("ERROR :: COMMITS NOT GROUPED");
+	}
+
+	//An LSN past the end of the log, as on a page stamped by another log, flushes the whole log
+	log->abort(log->begin());
+	log->flush(log->nextLsn() + 100);
+	if(log->flushedLsn() != log->nextLsn())
+	{
+		PRINT_ERROR("ERROR :: FLUSH PAST THE END OF THE LOG DID NOT FLUSH IT");
+	}
+
+	//Writing the pages back must not overtake the log
+	bufMgr->flushFile(file1ptr);
+	if(log->flushedLsn() <= lastLsn)
+	{
+		PRINT_ERROR("ERROR :: PAGE WRITTEN BEFORE ITS LOG RECORD");
+	}
+
+	LogRecord record;
+	Lsn next;
+	if(!log->readRecord(lastLsn, record, next) || record.type != LOG_UPDATE || record.page_number != 10)
+	{
+		PRINT_ERROR("ERROR :: LOG RECORD DID NOT MATCH");
+	}
+
+	//A record whose checksum does not match ends the log
+	bufMgr->setLogManager(NULL);
+	delete log;
+	{
+		std::fstream stream(logname.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+		stream.seekg(lastLsn + 200);
+		char byte = stream.get();
+		stream.seekp(lastLsn + 200);
+		stream.put(byte ^ 0x10);
+	}
+	log = new LogManager(logname);
+	if (log->nextLsn() != lastLsn || log->readRecord(lastLsn, record, next))
+	{
+		PRINT_ERROR("ERROR :: CORRUPT LOG RECORD ACCEPTED");
+	}
+
+	//So does a length reaching past the end of the file
+	Lsn commitLsn = log->commit(log->begin());
+	delete log;
+	{
+		std::fstream stream(logname.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+		const std::uint32_t length = 0xFFFFFFF0;
+		stream.seekp(commitLsn);
+		stream.write(reinterpret_cast<const char*>(&length), sizeof(length));
+	}
+	log = new LogManager(logname);
+	if (log->nextLsn() != commitLsn)
+	{
+		PRINT_ERROR("ERROR :: LOG RECORD PAST END OF FILE ACCEPTED");
+	}
+	delete log;
+	std::remove(logname.c_str());
+
+	std::cout << "Test 9 passed" << "\n";
+}
+
+void test10()
+{
+	const std::string& logname = "test.log";
+	std::remove(logname.c_str());
+	LogManager* log = new LogManager(logname);
+	bufMgr->setLogManager(log);
+
+	//Keep updating a few hot pages; redo distance must stay bounded without writing every update
+	const Lsn maxDistance = 40 * Page::SIZE;
+	Checkpointer checkpointer(bufMgr, log, maxDistance, 2);
+	bufMgr->clearBufStats();
+	int checkpoints = 0;
+	for (int k = 0; k < 200; k++)
+	{
+		PageId pageNo = 1 + k % 5;
+		TxnId txn = log->begin();
+		bufMgr->readPage(file1ptr, pageNo, page);
+		Page before = *page;
+		RecordId rid = page->insertRecord("hot");
+		page->deleteRecord(rid);
+		log->logUpdate(txn, file1ptr, before, *page);
+		bufMgr->unPinPage(file1ptr, pageNo, true);
+		log->commit(txn);
+
+		if (checkpointer.step())
+			checkpoints++;
+		if (log->nextLsn() - checkpointer.redoLsn() > maxDistance)
+		{
+			PRINT_ERROR("ERROR :: REDO DISTANCE NOT BOUNDED");
+		}
+	}
+
+	if (checkpoints == 0 || bufMgr->getBufStats().diskwrites >= 200 / 2)
+	{
+		PRINT_ERROR("ERROR :: CHECKPOINTING WROTE TOO MUCH OR NEVER RAN");
+	}
+
+	//The latest checkpoint carries the dirty page table
+	LogRecord record;
+	Lsn next;
+	std::vector<ActiveTxnEntry> txns;
+	std::vector<DirtyPageEntry> dirtyPages;
+	if (!log->readRecord(log->checkpointLsn(), record, next) || record.type != LOG_CHECKPOINT)
+	{
+		PRINT_ERROR("ERROR :: CHECKPOINT RECORD NOT FOUND");
+	}
+	LogManager::decodeCheckpoint(record, txns, dirtyPages);
+	if (!txns.empty())
+	{
+		PRINT_ERROR("ERROR :: NO TRANSACTION SHOULD BE ACTIVE");
+	}
+
+	bufMgr->flushFile(file1ptr);
+	bufMgr->setLogManager(NULL);
+	delete log;
+	std::remove(logname.c_str());
+
+	std::cout << "Test 10 passed" << "\n";
+}
+
+bool pageHasRecord(Page* p, const std::string& record)
+{
+	for (PageIterator iter = p->begin(); iter != p->end(); ++iter)
+		if (*iter == record)
+			return true;
+	return false;
+}
+
+void test11()
+{
+	const std::string& logname = "test.log";
+	std::remove(logname.c_str());
+	bufMgr->flushFile(file2ptr);
+
+	//Run two transactions on a separate buffer manager which is then "crashed" (leaked without flushing)
+	{
+		LogManager log(logname);
+		BufMgr* crashing = new BufMgr(10);
+		crashing->setLogManager(&log);
+
+		//The loser's page reaches the disk (steal), its transaction never commits
+		TxnId loser = log.begin();
+		crashing->readPage(file2ptr, 2, page);
+		Page before = *page;
+		page->insertRecord("loser");
+		log.logUpdate(loser, file2ptr, before, *page);
+		crashing->unPinPage(file2ptr, 2, true);
+		crashing->flushFile(file2ptr);
+
+		//The winner commits but its page is never written back (no-force)
+		TxnId winner = log.begin();
+		crashing->readPage(file2ptr, 1, page);
+		before = *page;
+		page->insertRecord("winner");
+		log.logUpdate(winner, file2ptr, before, *page);
+		crashing->unPinPage(file2ptr, 1, true);
+		log.commit(winner);
+	}
+
+	LogManager* log = new LogManager(logname);
+	bufMgr->setLogManager(log);
+	RecoveryManager::FileMap files;
+	files[file2ptr->filename()] = file2ptr;
+	RecoveryManager recovery(bufMgr, log, files, 2, 8);
+	recovery.recover();
+
+	if (recovery.loserCount() != 1 || recovery.redoneCount() == 0 || recovery.undoneCount() != 1)
+	{
+		PRINT_ERROR("ERROR :: RECOVERY DID NOT FIND THE EXPECTED WORK");
+	}
+	//Both pages were missing, so redo must have read them at the same time
+	if (recovery.maxReadsInFlight() != 2)
+	{
+		PRINT_ERROR("ERROR :: REDO DID NOT READ THE PAGES OF A ROUND CONCURRENTLY");
+	}
+
+	bufMgr->readPage(file2ptr, 1, page);
+	bufMgr->readPage(file2ptr, 2, page2);
+	if (!pageHasRecord(page, "winner") || pageHasRecord(page2, "loser"))
+	{
+		PRINT_ERROR("ERROR :: RECOVERED PAGES DID NOT MATCH");
+	}
+	bufMgr->unPinPage(file2ptr, 1, false);
+	bufMgr->unPinPage(file2ptr, 2, false);
+
+	bufMgr->flushFile(file2ptr);
+	bufMgr->setLogManager(NULL);
+	delete log;
+	std::remove(logname.c_str());
+
+	//A loser with three updates, all on disk; the first recovery crashes after undoing one of them
+	const std::string& undoname = "test.undo";
+	std::remove(undoname.c_str());
+	{
+		File file = File::create(undoname);
+		for (int k = 0; k < 2; k++)
+		{
+			Page newPage = file.allocatePage();
+			file.writePage(newPage);
+		}
+		Lsn undoStart;
+		{
+			LogManager log(logname);
+			BufMgr* crashing = new BufMgr(10);
+			crashing->setLogManager(&log);
+			TxnId loser = log.begin();
+			const PageId pageNos[3] = {1, 2, 1};
+			const char* records[3] = {"loser1", "loser2", "loser3"};
+			for (int k = 0; k < 3; k++)
+			{
+				crashing->readPage(&file, pageNos[k], page);
+				Page before = *page;
+				page->insertRecord(records[k]);
+				log.logUpdate(loser, &file, before, *page);
+				crashing->unPinPage(&file, pageNos[k], true);
+			}
+			crashing->flushFile(&file);
+			undoStart = log.nextLsn();
+		}
+		{
+			LogManager log(logname);
+			BufMgr* crashing = new BufMgr(10);
+			crashing->setLogManager(&log);
+			RecoveryManager::FileMap undoFiles;
+			undoFiles[file.filename()] = &file;
+			RecoveryManager interrupted(crashing, &log, undoFiles);
+			interrupted.recover();
+		}
+		//Keep only the compensation record of the newest update
+		{
+			LogManager log(logname);
+			LogRecord record;
+			Lsn next;
+			if (!log.readRecord(undoStart, record, next) || record.type != LOG_CLR)
+			{
+				PRINT_ERROR("ERROR :: UNDO DID NOT WRITE A COMPENSATION RECORD");
+			}
+			if (truncate(logname.c_str(), next) != 0)
+			{
+				PRINT_ERROR("ERROR :: COULD NOT CUT THE LOG");
+			}
+		}
+
+		LogManager* undoLog = new LogManager(logname);
+		BufMgr undoMgr(10);
+		undoMgr.setLogManager(undoLog);
+		RecoveryManager::FileMap undoFiles;
+		undoFiles[file.filename()] = &file;
+		RecoveryManager resumed(&undoMgr, undoLog, undoFiles);
+		resumed.recover();
+		if (resumed.loserCount() != 1 || resumed.undoneCount() != 2)
+		{
+			PRINT_ERROR("ERROR :: RESUMED UNDO DID NOT SKIP THE COMPENSATED UPDATE");
+		}
+		for (PageId pageNo = 1; pageNo <= 2; pageNo++)
+		{
+			undoMgr.readPage(&file, pageNo, page);
+			if (pageHasRecord(page, "loser1") || pageHasRecord(page, "loser2") || pageHasRecord(page, "loser3"))
+			{
+				PRINT_ERROR("ERROR :: LOSER UPDATE LEFT AFTER INTERRUPTED UNDO");
+			}
+			undoMgr.unPinPage(&file, pageNo, false);
+		}
+		undoMgr.flushFile(&file);
+		undoMgr.setLogManager(NULL);
+		delete undoLog;
+	}
+	std::remove(undoname.c_str());
+	std::remove(logname.c_str());
+
+	//A committed update that was never written back survives a crash right after its recovery
+	const std::string& redoname = "test.redo";
+	std::remove(redoname.c_str());
+	{
+		File file = File::create(redoname);
+		Page newPage = file.allocatePage();
+		file.writePage(newPage);
+		{
+			LogManager log(logname);
+			BufMgr* crashing = new BufMgr(10);
+			crashing->setLogManager(&log);
+			TxnId winner = log.begin();
+			crashing->readPage(&file, 1, page);
+			Page before = *page;
+			page->insertRecord("redo winner");
+			log.logUpdate(winner, &file, before, *page);
+			crashing->unPinPage(&file, 1, true);
+			log.commit(winner);
+		}
+		RecoveryManager::FileMap redoFiles;
+		redoFiles[file.filename()] = &file;
+		for (int k = 0; k < 2; k++)
+		{
+			//Each recovery crashes before the redone page is written back
+			LogManager log(logname);
+			BufMgr* crashing = new BufMgr(10);
+			crashing->setLogManager(&log);
+			RecoveryManager repeated(crashing, &log, redoFiles);
+			repeated.recover();
+			if (repeated.redoneCount() != 1)
+			{
+				PRINT_ERROR("ERROR :: REPEATED RECOVERY DID NOT REDO THE WINNER");
+			}
+		}
+	}
+	std::remove(redoname.c_str());
+	std::remove(logname.c_str());
+
+	std::cout << "Test 11 passed" << "\n";
+}
+
+void test12()
+{
+	const std::string& dwbname = "test.dwb";
+	std::remove(dwbname.c_str());
+	bufMgr->flushFile(file3ptr);
+	DoubleWriteBuffer* dwb = new DoubleWriteBuffer(dwbname, 4);
+
+	//Nothing left over from a crash
+	DoubleWriteBuffer::FileMap files;
+	files[file3ptr->filename()] = file3ptr;
+	if (dwb->repair(files) != 0)
+	{
+		PRINT_ERROR("ERROR :: EMPTY DOUBLE-WRITE FILE SHOULD NOT REPAIR ANYTHING");
+	}
+
+	//Ten dirty pages flushed together go out in batches of at most four
+	bufMgr->setDoubleWriteBuffer(dwb);
+	for (PageId pageNo = 1; pageNo <= 10; pageNo++)
+	{
+		bufMgr->readPage(file3ptr, pageNo, page);
+		page->insertRecord("double-written");
+		bufMgr->unPinPage(file3ptr, pageNo, true);
+	}
+	bufMgr->flushFile(file3ptr);
+	if (dwb->batchCount() != 3 || dwb->pageCount() != 10)
+	{
+		PRINT_ERROR("ERROR :: DOUBLE-WRITE BATCHES DID NOT MATCH");
+	}
+
+	//The pages reached their place in the file
+	for (PageId pageNo = 1; pageNo <= 10; pageNo++)
+	{
+		Page onDisk = file3ptr->readPage(pageNo);
+		if (!pageHasRecord(&onDisk, "double-written"))
+		{
+			PRINT_ERROR("ERROR :: DOUBLE-WRITTEN PAGE NOT FOUND IN PLACE");
+		}
+	}
+
+	//A flush refused because of a pinned page leaves every page in the pool
+	{
+		BufMgr pinMgr(4);
+		pinMgr.setDoubleWriteBuffer(dwb);
+		pinMgr.readPage(file3ptr, 1, page);
+		page->insertRecord("flush refused");
+		pinMgr.unPinPage(file3ptr, 1, true);
+		pinMgr.readPage(file3ptr, 2, page2);
+		try
+		{
+			pinMgr.flushFile(file3ptr);
+			PRINT_ERROR("ERROR :: FILE WITH A PINNED PAGE FLUSHED");
+		}
+		catch(PagePinnedException &e)
+		{
+		}
+		pinMgr.unPinPage(file3ptr, 2, false);
+		pinMgr.readPage(file3ptr, 1, page);
+		if (!pageHasRecord(page, "flush refused"))
+		{
+			PRINT_ERROR("ERROR :: REFUSED FLUSH DROPPED A DIRTY PAGE");
+		}
+		pinMgr.unPinPage(file3ptr, 1, false);
+		pinMgr.flushFile(file3ptr);
+		Page onDisk = file3ptr->readPage(1);
+		if (!pageHasRecord(&onDisk, "flush refused"))
+		{
+			PRINT_ERROR("ERROR :: DIRTY PAGE NOT FLUSHED AFTER REFUSED FLUSH");
+		}
+	}
+
+	//Dirty pages replaced one at a time still go out in full batches, with three syncs each
+	bufMgr->setDoubleWriteBuffer(NULL);
+	{
+		BufMgr evictMgr(8);
+		evictMgr.setDoubleWriteBuffer(dwb);
+		for (PageId pageNo = 1; pageNo <= 8; pageNo++)
+		{
+			evictMgr.readPage(file3ptr, pageNo, page);
+			page->insertRecord("evicted in batches");
+			evictMgr.unPinPage(file3ptr, pageNo, true);
+		}
+		std::uint64_t batches = dwb->batchCount();
+		std::uint64_t pages = dwb->pageCount();
+		std::uint64_t syncs = dwb->syncCount();
+		for (PageId pageNo = 11; pageNo <= 18; pageNo++)
+		{
+			evictMgr.readPage(file3ptr, pageNo, page);
+			evictMgr.unPinPage(file3ptr, pageNo, false);
+		}
+		if (dwb->pageCount() - pages != 8 || dwb->batchCount() - batches != 2 || dwb->syncCount() - syncs != 2 * 3)
+		{
+			PRINT_ERROR("ERROR :: EVICTED DIRTY PAGES NOT WRITTEN BACK IN BATCHES");
+		}
+		for (PageId pageNo = 1; pageNo <= 8; pageNo++)
+		{
+			Page onDisk = file3ptr->readPage(pageNo);
+			if (!pageHasRecord(&onDisk, "evicted in batches"))
+			{
+				PRINT_ERROR("ERROR :: EVICTED PAGE NOT FOUND IN PLACE");
+			}
+		}
+		evictMgr.setDoubleWriteBuffer(NULL);
+	}
+
+	delete dwb;
+	std::remove(dwbname.c_str());
+
+	//A batch that can no longer be written is dropped when the buffer is destroyed instead of ending the program
+	const std::string& lostname = "test.lost";
+	std::remove(lostname.c_str());
+	{
+		File lostFile = File::create(lostname);
+		Page lostPage = lostFile.allocatePage();
+		lostFile.writePage(lostPage);
+		DoubleWriteBuffer* lost = new DoubleWriteBuffer(dwbname, 4);
+		lost->write(&lostFile, lostPage);
+		lostFile.deletePage(lostPage.page_number());
+		delete lost;
+	}
+	std::remove(dwbname.c_str());
+	std::remove(lostname.c_str());
+
+	std::cout << "Test 12 passed" << "\n";
+}
+
+void test13()
+{
+	//Flip a byte of a page behind the file's back
+	Page original = file4ptr->readPage(1);
+	{
+		std::fstream raw("test.4", std::ios::in | std::ios::out | std::ios::binary);
+		raw.seekp(sizeof(FileHeader) + sizeof(PageHeader) + 100, std::ios::beg);
+		raw.put('!');
+	}
+
+	try
+	{
+		file4ptr->readPage(1);
+		PRINT_ERROR("ERROR :: Page is corrupted. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(ChecksumMismatchException &e)
+	{
+	}
+
+	//With verification off the corrupted page is returned as is
+	file4ptr->setChecksumVerification(false);
+	file4ptr->readPage(1);
+	file4ptr->setChecksumVerification(true);
+
+	//Writing the page again stores a matching checksum
+	file4ptr->writePage(original);
+	file4ptr->readPage(1);
+
+	std::cout << "Test 13 passed" << "\n";
+}
+
+void test14()
+{
+	const std::string& filename = "test.cmp";
+	std::remove(filename.c_str());
+	{
+		File file = File::create(filename);
+		file.setCompression(true);
+
+		//Half-filled pages of similar records compress; a page of noise does not
+		for (int k = 0; k < 20; k++)
+		{
+			bufMgr->allocPage(&file, pageno1, page);
+			for (int r = 0; r < 40; r++)
+			{
+				sprintf((char*)tmpbuf, "compressed record %d of page %d", r, pageno1);
+				page->insertRecord(tmpbuf);
+			}
+			bufMgr->unPinPage(&file, pageno1, true);
+		}
+		bufMgr->allocPage(&file, pageno2, page);
+		std::string noise;
+		for (int b = 0; b < 4000; b++)
+			noise += (char)(random() % 256);
+		rid2 = page->insertRecord(noise);
+		bufMgr->unPinPage(&file, pageno2, true);
+		std::uint64_t before = file.bytesWritten();
+		bufMgr->flushFile(&file);
+
+		if (file.bytesWritten() - before >= 21 * Page::SIZE / 2)
+		{
+			PRINT_ERROR("ERROR :: COMPRESSED PAGES WROTE TOO MANY BYTES");
+		}
+		struct stat st;
+		stat(filename.c_str(), &st);
+		if ((std::uint64_t)st.st_blocks * 512 >= 21 * Page::SIZE)
+		{
+			PRINT_ERROR("ERROR :: COMPRESSED FILE DID NOT SHRINK ON DISK");
+		}
+
+		//Pages decompress on the miss path and still pass their checksums
+		for (PageId pageNo = 1; pageNo <= 20; pageNo++)
+		{
+			bufMgr->readPage(&file, pageNo, page);
+			sprintf((char*)tmpbuf, "compressed record %d of page %d", 39, pageNo);
+			if (!pageHasRecord(page, tmpbuf))
+			{
+				PRINT_ERROR("ERROR :: DECOMPRESSED PAGE DID NOT MATCH");
+			}
+			bufMgr->unPinPage(&file, pageNo, false);
+		}
+		bufMgr->readPage(&file, pageno2, page);
+		if (page->getRecord(rid2) != noise)
+		{
+			PRINT_ERROR("ERROR :: INCOMPRESSIBLE PAGE DID NOT MATCH");
+		}
+		bufMgr->unPinPage(&file, pageno2, false);
+		bufMgr->flushFile(&file);
+	}
+	File::remove(filename);
+
+	std::cout << "Test 14 passed" << "\n";
+}
+
+void test15()
+{
+	const std::string& filename = "test.rel";
+	std::remove(filename.c_str());
+	{
+		File file = File::create(filename);
+		file.setReleaseFreedPages(true);
+		for (int k = 0; k < 40; k++)
+		{
+			bufMgr->allocPage(&file, pageno1, page);
+			page->insertRecord(std::string(6000, 'r'));
+			bufMgr->unPinPage(&file, pageno1, true);
+		}
+		bufMgr->flushFile(&file);
+		std::uint64_t full = file.diskUsage();
+
+		//Mass delete of the tail and one page in the middle
+		for (PageId pageNo = 11; pageNo <= 40; pageNo++)
+			bufMgr->disposePage(&file, pageNo);
+		bufMgr->disposePage(&file, 5);
+		if (file.diskUsage() >= full * 2 / 3)
+		{
+			PRINT_ERROR("ERROR :: DELETED PAGES STILL TAKE DISK SPACE");
+		}
+
+		//Only the trailing free pages are cut off; page 5 stays on the free list
+		if (file.truncateFreeTail() != 30)
+		{
+			PRINT_ERROR("ERROR :: WRONG NUMBER OF TRAILING FREE PAGES REMOVED");
+		}
+		bufMgr->allocPage(&file, pageno1, page);
+		bufMgr->allocPage(&file, pageno2, page2);
+		if (pageno1 != 5 || pageno2 != 11 || page->getFreeSpace() != Page::DATA_SIZE)
+		{
+			PRINT_ERROR("ERROR :: PAGES AFTER TRUNCATION NOT REUSED AS EXPECTED");
+		}
+		bufMgr->unPinPage(&file, pageno1, false);
+		bufMgr->unPinPage(&file, pageno2, false);
+
+		bufMgr->readPage(&file, 10, page);
+		if (page->begin() == page->end() || *page->begin() != std::string(6000, 'r'))
+		{
+			PRINT_ERROR("ERROR :: LIVE PAGE DAMAGED BY SPACE RECLAMATION");
+		}
+		bufMgr->unPinPage(&file, 10, false);
+		bufMgr->flushFile(&file);
+	}
+	File::remove(filename);
+
+	std::cout << "Test 15 passed" << "\n";
+}
+
+int countRecords(File* file, int& pages)
+{
+	int records = 0;
+	pages = 0;
+	for (FileIterator iter = file->begin(); iter != file->end(); ++iter)
+	{
+		pages++;
+		bufMgr->readPage(file, iter.page_number(), page);
+		for (PageIterator record_iter = page->begin(); record_iter != page->end(); ++record_iter)
+			records++;
+		bufMgr->unPinPage(file, iter.page_number(), false);
+	}
+	return records;
+}
+
+//30 pages of 10 records, then 8 of every 10 records are deleted
+void fillSparsePages(File* file)
+{
+	for (int k = 0; k < 30; k++)
+	{
+		bufMgr->allocPage(file, pageno1, page);
+		for (int r = 0; r < 10; r++)
+		{
+			sprintf((char*)tmpbuf, "%d", k * 10 + r);
+			RecordId recordId = page->insertRecord(std::string(tmpbuf) + std::string(600, ' '));
+			if (r >= 2)
+				page->deleteRecord(recordId);
+		}
+		bufMgr->unPinPage(file, pageno1, true);
+	}
+}
+
+void test16()
+{
+	const std::string& filename = "test.vac";
+	std::remove(filename.c_str());
+	{
+		File file = File::create(filename);
+		fillSparsePages(&file);
+
+		//Every move is reported so references can be fixed up
+		std::uint64_t relocations = 0;
+		Vacuum vacuum(bufMgr, &file, 0.5, 4,
+				[&relocations](const RecordId&, const RecordId&) { relocations++; });
+		int steps = 0;
+		while (vacuum.step())
+			steps++;
+
+		int pages;
+		int records = countRecords(&file, pages);
+		if (records != 60 || relocations != vacuum.recordsMoved() || steps < 2)
+		{
+			PRINT_ERROR("ERROR :: VACUUM LOST RECORDS OR DID NOT THROTTLE");
+		}
+		if (pages > 8 || vacuum.pagesFreed() != (std::uint64_t)(30 - pages))
+		{
+			PRINT_ERROR("ERROR :: VACUUM DID NOT MERGE PAGES");
+		}
+		bufMgr->flushFile(&file);
+	}
+	File::remove(filename);
+
+	//Pages disposed of between steps are skipped, both the next source and a later target
+	{
+		File file = File::create(filename);
+		fillSparsePages(&file);
+		Vacuum vacuum(bufMgr, &file, 0.5, 1);
+		vacuum.step();
+		bufMgr->disposePage(&file, 29);
+		bufMgr->disposePage(&file, 2);
+		vacuum.run();
+
+		int pages;
+		int records = countRecords(&file, pages);
+		if (records != 60 - 2 * 2 || vacuum.pagesFreed() != (std::uint64_t)(30 - 2 - pages) || pages > 8)
+		{
+			PRINT_ERROR("ERROR :: VACUUM DID NOT SKIP DISPOSED PAGES");
+		}
+		bufMgr->flushFile(&file);
+	}
+	File::remove(filename);
+
+	std::cout << "Test 16 passed" << "\n";
+}
+
+void test17()
+{
+	const std::string& filename = "test.reo";
+	std::remove(filename.c_str());
+	{
+		File file = File::create(filename);
+		for (int k = 1; k <= 20; k++)
+		{
+			bufMgr->allocPage(&file, pageno1, page);
+			sprintf((char*)tmpbuf, "page %d", k);
+			page->insertRecord(tmpbuf);
+			bufMgr->unPinPage(&file, pageno1, true);
+		}
+		bufMgr->disposePage(&file, 3);
+		bufMgr->disposePage(&file, 7);
+		bufMgr->disposePage(&file, 12);
+		bufMgr->flushFile(&file);
+
+		//Gaps left by deleted pages break the physical order of the chain
+		if (file.fragmentation() != 3.0 / 16)
+		{
+			PRINT_ERROR("ERROR :: FRAGMENTATION DID NOT MATCH");
+		}
+
+		std::map<PageId, PageId> moves;
+		PageId moved = file.reorganize([&moves](const PageId from, const PageId to) { moves[from] = to; });
+		if (file.fragmentation() != 0 || moved != moves.size() || moves[20] != 17 || moves.count(2) != 0)
+		{
+			PRINT_ERROR("ERROR :: REORGANIZED CHAIN NOT IN PHYSICAL ORDER");
+		}
+
+		//Every record is still on the page it was moved to
+		for (int k = 1; k <= 20; k++)
+		{
+			if (k == 3 || k == 7 || k == 12)
+				continue;
+			PageId pageNo = moves.count(k) ? moves[k] : k;
+			bufMgr->readPage(&file, pageNo, page);
+			sprintf((char*)tmpbuf, "page %d", k);
+			if (!pageHasRecord(page, tmpbuf))
+			{
+				PRINT_ERROR("ERROR :: REORGANIZED PAGE DID NOT MATCH");
+			}
+			bufMgr->unPinPage(&file, pageNo, false);
+		}
+		bufMgr->flushFile(&file);
+
+		if (file.truncateFreeTail() != 3)
+		{
+			PRINT_ERROR("ERROR :: FREE PAGES NOT MOVED TO THE END");
+		}
+	}
+	File::remove(filename);
+
+	std::cout << "Test 17 passed" << "\n";
+}
+
+std::string rowContents(LogStructuredHeap::RowId row, int version)
+{
+	sprintf((char*)tmpbuf, "row %d version %d ", (int)row, version);
+	return std::string(tmpbuf) + std::string(150, 'v');
+}
+
+void test18()
+{
+	const std::string& filename = "test.lsh";
+	std::remove(filename.c_str());
+	{
+		File file = File::create(filename);
+		std::vector<LogStructuredHeap::RowId> rows;
+		{
+			LogStructuredHeap heap(bufMgr, &file);
+			for (int k = 0; k < 200; k++)
+				rows.push_back(heap.insert(rowContents(k + 1, 0)));
+			for (int version = 1; version <= 3; version++)
+				for (int k = 0; k < 200; k++)
+					heap.update(rows[k], rowContents(rows[k], version));
+			for (int k = 0; k < 200; k += 4)
+				heap.remove(rows[k]);
+
+			//Updates only ever append: the file holds every version
+			int pages;
+			countRecords(&file, pages);
+			int cleaned = heap.clean(0.5, 1000);
+			int pagesAfter;
+			int records = countRecords(&file, pagesAfter);
+			if (cleaned == 0 || pagesAfter >= pages / 2 || records >= 400)
+			{
+				PRINT_ERROR("ERROR :: CLEANING DID NOT RECLAIM SPACE");
+			}
+			for (int k = 1; k < 200; k += 4)
+			{
+				if (heap.read(rows[k]) != rowContents(rows[k], 3))
+				{
+					PRINT_ERROR("ERROR :: LOG-STRUCTURED ROW DID NOT MATCH");
+				}
+			}
+
+			//Cleaning pages that are mostly live moves rows; they reach the disk before their old pages are freed
+			std::vector<RecordId> locations;
+			for (int k = 0; k < 200; k++)
+				locations.push_back(k % 4 == 0 ? RecordId() : heap.location(rows[k]));
+			heap.clean(0.9, 1000);
+			int moved = 0;
+			for (int k = 1; k < 200; k++)
+			{
+				if (k % 4 == 0 || heap.location(rows[k]) == locations[k])
+					continue;
+				moved++;
+				Page onDisk = file.readPage(heap.location(rows[k]).page_number);
+				bool found = false;
+				for (PageIterator iter = onDisk.begin(); iter != onDisk.end(); ++iter)
+					if ((*iter).find(rowContents(rows[k], 3)) != std::string::npos)
+						found = true;
+				if (!found)
+				{
+					PRINT_ERROR("ERROR :: MOVED ROW NOT DURABLE AFTER CLEANING");
+				}
+			}
+			if (moved == 0)
+			{
+				PRINT_ERROR("ERROR :: CLEANING MOVED NO ROWS");
+			}
+
+			//New tail pages go to the end of the file, not into the freed pages
+			std::vector<LogStructuredHeap::RowId> extra;
+			extra.push_back(heap.insert(rowContents(0, 0)));
+			const PageId tail = heap.location(extra.back()).page_number;
+			struct stat before, after;
+			stat(filename.c_str(), &before);
+			do
+			{
+				extra.push_back(heap.insert(rowContents(0, 0)));
+			} while (heap.location(extra.back()).page_number == tail && extra.size() < 200);
+			stat(filename.c_str(), &after);
+			if (heap.location(extra.back()).page_number == tail || after.st_size <= before.st_size)
+			{
+				PRINT_ERROR("ERROR :: LOG-STRUCTURED TAIL REUSED A FREED PAGE");
+			}
+			for (std::size_t k = 0; k < extra.size(); k++)
+				heap.remove(extra[k]);
+			bufMgr->flushFile(&file);
+		}
+
+		//Reopening rebuilds the row map from the file
+		LogStructuredHeap heap(bufMgr, &file);
+		if (heap.size() != 150 || heap.read(rows[199]) != rowContents(rows[199], 3))
+		{
+			PRINT_ERROR("ERROR :: ROW MAP NOT REBUILT");
+		}
+		try
+		{
+			heap.read(rows[0]);
+			PRINT_ERROR("ERROR :: Row was removed. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(RowNotFoundException &e)
+		{
+		}
+		bufMgr->flushFile(&file);
+	}
+	File::remove(filename);
+
+	std::cout << "Test 18 passed" << "\n";
+}
+
+void test19()
+{
+	const std::string& filename = "test.snp";
+	const std::string& backupname = "test.bak";
+	const std::string& tailname = "test.bak.tail";
+	std::remove(filename.c_str());
+	std::remove(backupname.c_str());
+	std::remove(tailname.c_str());
+	{
+		File file = File::create(filename);
+		for (int k = 1; k <= 10; k++)
+		{
+			bufMgr->allocPage(&file, pageno1, page);
+			page->insertRecord("before snapshot");
+			bufMgr->unPinPage(&file, pageno1, true);
+		}
+		bufMgr->flushFile(&file);
+
+		//Page 2 is dirty in the buffer pool when the snapshot starts
+		bufMgr->readPage(&file, 2, page);
+		page->insertRecord("dirty at snapshot");
+		bufMgr->unPinPage(&file, 2, true);
+
+		Snapshot* snapshot = new Snapshot(bufMgr, &file, "test.snp.pre");
+
+		//Writers keep going: every page changes, one is deleted, one is added
+		for (PageId pageNo = 1; pageNo <= 10; pageNo++)
+		{
+			bufMgr->readPage(&file, pageNo, page);
+			page->insertRecord("after snapshot");
+			bufMgr->unPinPage(&file, pageNo, true);
+		}
+		bufMgr->flushFile(&file);
+		bufMgr->disposePage(&file, 5);
+		bufMgr->allocPage(&file, pageno1, page);
+		bufMgr->unPinPage(&file, pageno1, true);
+		bufMgr->flushFile(&file);
+
+		Page snapPage = snapshot->readPage(2);
+		if (!pageHasRecord(&snapPage, "dirty at snapshot") || pageHasRecord(&snapPage, "after snapshot"))
+		{
+			PRINT_ERROR("ERROR :: SNAPSHOT DID NOT KEEP THE POINT-IN-TIME PAGE");
+		}
+
+		//The backup is a regular file holding the point-in-time image
+		snapshot->copyTo(backupname);
+		if (snapshot->pagesPreserved() != 10)
+		{
+			PRINT_ERROR("ERROR :: SNAPSHOT PRESERVED UNEXPECTED PAGES");
+		}
+		delete snapshot;
+
+		File backup = File::open(backupname);
+		int pages = 0;
+		for (FileIterator iter = backup.begin(); iter != backup.end(); ++iter)
+		{
+			Page backupPage = *iter;
+			if (!pageHasRecord(&backupPage, "before snapshot") || pageHasRecord(&backupPage, "after snapshot"))
+			{
+				PRINT_ERROR("ERROR :: BACKUP PAGE DID NOT MATCH");
+			}
+			pages++;
+		}
+		if (pages != 10)
+		{
+			PRINT_ERROR("ERROR :: BACKUP DID NOT HOLD ALL PAGES");
+		}
+
+		//Free pages cut off the end of the file are still read by an active snapshot
+		PageId lastPage = 0;
+		for (FileIterator iter = file.begin(); iter != file.end(); ++iter)
+			lastPage = std::max(lastPage, iter.page_number());
+		bufMgr->disposePage(&file, lastPage);
+		snapshot = new Snapshot(bufMgr, &file, "test.snp.pre");
+		if (file.truncateFreeTail() != 1 || snapshot->pagesPreserved() != 1)
+		{
+			PRINT_ERROR("ERROR :: TRUNCATED PAGE NOT PRESERVED FOR THE SNAPSHOT");
+		}
+		snapshot->copyTo(tailname);
+		delete snapshot;
+	}
+	File::remove(filename);
+	File::remove(backupname);
+	File::remove(tailname);
+
+	std::cout << "Test 19 passed" << "\n";
+}
+
+bool sameRecords(File* lhs, File* rhs, const PageId pageNo)
+{
+	Page lhsPage = lhs->readPage(pageNo);
+	Page rhsPage = rhs->readPage(pageNo);
+	PageIterator lhsIter = lhsPage.begin();
+	PageIterator rhsIter = rhsPage.begin();
+	for (; lhsIter != lhsPage.end() && rhsIter != rhsPage.end(); ++lhsIter, ++rhsIter)
+		if (*lhsIter != *rhsIter)
+			return false;
+	return lhsIter == lhsPage.end() && rhsIter == rhsPage.end();
+}
+
+void test20()
+{
+	const std::string& filename = "test.inc";
+	const std::string& restorename = "test.res";
+	std::remove(filename.c_str());
+	std::remove(restorename.c_str());
+	{
+		File file = File::create(filename);
+		file.setChangeTracking(true);
+		for (int k = 1; k <= 20; k++)
+		{
+			bufMgr->allocPage(&file, pageno1, page);
+			sprintf((char*)tmpbuf, "page %d", k);
+			page->insertRecord(tmpbuf);
+			bufMgr->unPinPage(&file, pageno1, true);
+		}
+		bufMgr->flushFile(&file);
+
+		//The first backup holds everything
+		File restored = File::create(restorename);
+		if (IncrementalBackup::take(&file, "test.inc.1") != 20 ||
+				IncrementalBackup::apply("test.inc.1", &restored) != 20)
+		{
+			PRINT_ERROR("ERROR :: FULL BACKUP DID NOT COPY ALL PAGES");
+		}
+
+		//The next one only the pages written since
+		bufMgr->readPage(&file, 17, page);
+		page->insertRecord("changed");
+		bufMgr->unPinPage(&file, 17, true);
+		bufMgr->readPage(&file, 3, page);
+		page->insertRecord("changed");
+		bufMgr->unPinPage(&file, 3, true);
+		bufMgr->flushFile(&file);
+		std::vector<PageId> changed;
+		file.changedPages(changed);
+		if (changed.size() != 2 || changed[0] != 3 || changed[1] != 17)
+		{
+			PRINT_ERROR("ERROR :: CHANGED PAGES DID NOT MATCH");
+		}
+		if (IncrementalBackup::take(&file, "test.inc.2") != 2 ||
+				IncrementalBackup::apply("test.inc.2", &restored) != 2)
+		{
+			PRINT_ERROR("ERROR :: INCREMENTAL BACKUP DID NOT COPY THE CHANGED PAGES");
+		}
+		for (PageId pageNo = 1; pageNo <= 20; pageNo++)
+		{
+			if (!sameRecords(&file, &restored, pageNo))
+			{
+				PRINT_ERROR("ERROR :: RESTORED PAGE DID NOT MATCH");
+			}
+		}
+
+		bufMgr->readPage(&file, 8, page);
+		page->insertRecord("changed");
+		bufMgr->unPinPage(&file, 8, true);
+		bufMgr->flushFile(&file);
+	}
+	{
+		//The bitmap survives closing the file
+		File file = File::open(filename);
+		file.setChangeTracking(true);
+		std::vector<PageId> changed;
+		file.changedPages(changed);
+		if (changed.size() != 1 || changed[0] != 8)
+		{
+			PRINT_ERROR("ERROR :: CHANGED-PAGE BITMAP NOT PERSISTENT");
+		}
+		if (IncrementalBackup::take(&file, "test.inc.3") != 1)
+		{
+			PRINT_ERROR("ERROR :: REOPENED FILE DID NOT BACK UP ITS CHANGED PAGE");
+		}
+	}
+	{
+		//Tracking is back on after reopening, without being asked for
+		File file = File::open(filename);
+		if (!file.changeTracking())
+		{
+			PRINT_ERROR("ERROR :: CHANGE TRACKING OFF AFTER REOPENING");
+		}
+		bufMgr->readPage(&file, 2, page);
+		page->insertRecord("changed after reopening");
+		bufMgr->unPinPage(&file, 2, true);
+		bufMgr->flushFile(&file);
+	}
+	{
+		File file = File::open(filename);
+		if (IncrementalBackup::take(&file, "test.inc.4") != 1)
+		{
+			PRINT_ERROR("ERROR :: WRITE AFTER REOPENING MISSING FROM THE DELTA");
+		}
+
+		//Writes made while tracking is off make the next delta hold every page
+		file.setChangeTracking(false);
+		bufMgr->readPage(&file, 5, page);
+		page->insertRecord("changed untracked");
+		bufMgr->unPinPage(&file, 5, true);
+		bufMgr->flushFile(&file);
+		file.setChangeTracking(true);
+		std::vector<PageId> changed;
+		file.changedPages(changed);
+		if (changed.size() != 20)
+		{
+			PRINT_ERROR("ERROR :: UNTRACKED WRITES NOT COVERED AFTER TRACKING RESUMED");
+		}
+	}
+	File::remove(filename);
+	File::remove(restorename);
+	std::remove("test.inc.3");
+	std::remove("test.inc.4");
+	std::remove("test.inc.1");
+	std::remove("test.inc.2");
+
+	std::cout << "Test 20 passed" << "\n";
+}
+
+Task readAsync(File* file, const PageId pageNo, int& matched)
+{
+	PageGuard guard = co_await bufMgr->readPageAsync(file, pageNo);
+	sprintf((char*)tmpbuf, "async page %d", pageNo);
+	if (guard->getRecord(RecordId{pageNo, 1}) == tmpbuf)
+		matched++;
+}
+
+Task updateAsync(File* file, const PageId pageNo)
+{
+	PageGuard guard = co_await bufMgr->readPageAsync(file, pageNo);
+	guard->insertRecord("updated");
+	guard.markDirty();
+}
+
+void test21()
+{
+	const std::string& filename = "test.async";
+	std::remove(filename.c_str());
+	std::remove((filename + ".cmp").c_str());
+	{
+		File file = File::create(filename);
+		for (int k = 1; k <= 150; k++)
+		{
+			bufMgr->allocPage(&file, pageno1, page);
+			sprintf((char*)tmpbuf, "async page %d", pageno1);
+			page->insertRecord(tmpbuf);
+			bufMgr->unPinPage(&file, pageno1, true);
+		}
+		bufMgr->flushFile(&file);
+
+		EventLoop loop(4);
+		int matched = 0;
+		for (int k = 0; k < 240; k++)
+			loop.spawn(readAsync(&file, k % 60 + 1, matched));
+		loop.run();
+		if (matched != 240)
+		{
+			PRINT_ERROR("ERROR :: ASYNC READ RETURNED WRONG CONTENTS");
+		}
+		//Requests for a page that is being read share the read
+		if (loop.readsIssued() != 60 || loop.readsShared() != 180 || loop.maxInFlight() != 60)
+		{
+			PRINT_ERROR("ERROR :: ASYNC READS WERE NOT OVERLAPPED");
+		}
+
+		//Resident pages do not suspend
+		matched = 0;
+		for (int k = 0; k < 60; k++)
+			loop.spawn(readAsync(&file, k + 1, matched));
+		loop.spawn(updateAsync(&file, 7));
+		loop.run();
+		if (matched != 60 || loop.readsIssued() != 60)
+		{
+			PRINT_ERROR("ERROR :: ASYNC READ OF RESIDENT PAGE WENT TO DISK");
+		}
+
+		//More concurrent misses than frames wait for frames to be freed
+		bufMgr->flushFile(&file);
+		matched = 0;
+		for (int k = 0; k < 300; k++)
+			loop.spawn(readAsync(&file, k % 150 + 1, matched));
+		loop.run();
+		if (matched != 300 || loop.readsDelayed() == 0 || loop.maxInFlight() > num)
+		{
+			PRINT_ERROR("ERROR :: ASYNC READS BEYOND THE POOL SIZE FAILED");
+		}
+
+		//Errors are rethrown by run() and release the reserved frame
+		loop.spawn(readAsync(&file, 500, matched));
+		try
+		{
+			loop.run();
+			PRINT_ERROR("ERROR :: ASYNC READ OF MISSING PAGE SUCCEEDED");
+		}
+		catch(InvalidPageException &e)
+		{
+		}
+
+		//Every guard unpinned its page, so the file can be flushed
+		bufMgr->flushFile(&file);
+		Page updated = file.readPage(7);
+		if (updated.getRecord(RecordId{7, 2}) != "updated")
+		{
+			PRINT_ERROR("ERROR :: DIRTY ASYNC PAGE NOT WRITTEN BACK");
+		}
+
+		//The last page of a compressed file ends before its slot does
+		File compressed = File::create(filename + ".cmp");
+		compressed.setCompression(true);
+		for (int k = 1; k <= 3; k++)
+		{
+			bufMgr->allocPage(&compressed, pageno1, page);
+			sprintf((char*)tmpbuf, "async page %d", pageno1);
+			page->insertRecord(tmpbuf);
+			bufMgr->unPinPage(&compressed, pageno1, true);
+		}
+		bufMgr->flushFile(&compressed);
+		matched = 0;
+		for (int k = 1; k <= 3; k++)
+			loop.spawn(readAsync(&compressed, k, matched));
+		loop.run();
+		if (matched != 3)
+		{
+			PRINT_ERROR("ERROR :: ASYNC READ OF COMPRESSED PAGE FAILED");
+		}
+		bufMgr->flushFile(&compressed);
+	}
+	File::remove(filename);
+	File::remove(filename + ".cmp");
+
+	std::cout << "Test 21 passed" << "\n";
+}
+
+void test22()
+{
+	const std::string& filename = "test.batch";
+	std::remove(filename.c_str());
+	{
+		File file = File::create(filename);
+
+		//Batch lookups agree with single lookups, including chained buckets and misses
+		BufHashTbl table(7);
+		for (PageId pageNo = 1; pageNo <= 50; pageNo += 2)
+			table.insert(&file, pageNo, pageNo * 10);
+		PageId pageNos[100];
+		FrameId frameNos[100];
+		bool found[100];
+		for (int k = 0; k < 100; k++)
+			pageNos[k] = (k * 37) % 60 + 1;
+		std::size_t hits = table.lookupBatch(&file, pageNos, 100, frameNos, found);
+		for (int k = 0; k < 100; k++)
+		{
+			bool present = pageNos[k] % 2 == 1 && pageNos[k] <= 50;
+			if (found[k] != present || (present && frameNos[k] != pageNos[k] * 10))
+			{
+				PRINT_ERROR("ERROR :: BATCH LOOKUP DISAGREES WITH LOOKUP");
+			}
+			if (present)
+				hits--;
+		}
+		if (hits != 0)
+		{
+			PRINT_ERROR("ERROR :: BATCH LOOKUP FOUND WRONG NUMBER OF PAGES");
+		}
+
+		//readPages pins resident pages and reads missing ones
+		for (int k = 1; k <= 20; k++)
+		{
+			bufMgr->allocPage(&file, pageno1, page);
+			sprintf((char*)tmpbuf, "batch page %d", pageno1);
+			page->insertRecord(tmpbuf);
+			bufMgr->unPinPage(&file, pageno1, true);
+		}
+		bufMgr->flushFile(&file);
+		for (PageId pageNo = 1; pageNo <= 10; pageNo++)
+		{
+			bufMgr->readPage(&file, pageNo, page);
+			bufMgr->unPinPage(&file, pageNo, false);
+		}
+		Page* pages[20];
+		for (int k = 0; k < 20; k++)
+			pageNos[k] = 20 - k;
+		bufMgr->readPages(&file, pageNos, 20, pages);
+		for (int k = 0; k < 20; k++)
+		{
+			sprintf((char*)tmpbuf, "batch page %d", pageNos[k]);
+			if (pages[k]->getRecord(RecordId{pageNos[k], 1}) != tmpbuf)
+			{
+				PRINT_ERROR("ERROR :: BATCH READ RETURNED WRONG PAGE");
+			}
+			bufMgr->unPinPage(&file, pageNos[k], false);
+		}
+
+		//A failing batch leaves nothing pinned
+		pageNos[5] = 500;
+		try
+		{
+			bufMgr->readPages(&file, pageNos, 20, pages);
+			PRINT_ERROR("ERROR :: BATCH READ OF MISSING PAGE SUCCEEDED");
+		}
+		catch(InvalidPageException &e)
+		{
+		}
+		bufMgr->flushFile(&file);
+	}
+	File::remove(filename);
+
+	std::cout << "Test 22 passed" << "\n";
+}
+
+void test23()
+{
+	const std::string& filename = "test.numa";
+	std::remove(filename.c_str());
+	{
+		File file = File::create(filename);
+		//Two simulated nodes with 10 frames each
+		BufMgr numaMgr(20, 2);
+		if (numaMgr.getNumPartitions() != 2 || numaMgr.partitionOf(9) != 0 || numaMgr.partitionOf(10) != 1)
+		{
+			PRINT_ERROR("ERROR :: FRAMES NOT SPLIT INTO PARTITIONS");
+		}
+		//The page data of each partition's frames is taken from the partition's own region
+		if (numaMgr.getPartitionArena(0).freeSlots() != 0 || numaMgr.getPartitionArena(1).freeSlots() != 0)
+		{
+			PRINT_ERROR("ERROR :: FRAME DATA NOT IN PARTITION MEMORY");
+		}
+
+		//Misses of a thread on node 1 get frames of partition 1
+		BufMgr::setThreadNode(1);
+		PageId pageNos[5];
+		for (int k = 0; k < 5; k++)
+		{
+			numaMgr.allocPage(&file, pageNos[k], page);
+			if (numaMgr.partitionOf(page - numaMgr.bufPool) != 1)
+			{
+				PRINT_ERROR("ERROR :: MISS NOT SERVED BY LOCAL PARTITION");
+			}
+			numaMgr.unPinPage(&file, pageNos[k], true);
+		}
+		if (numaMgr.getBufStats().localAccesses != 5 || numaMgr.getBufStats().remoteAccesses != 0)
+		{
+			PRINT_ERROR("ERROR :: LOCAL ACCESSES NOT COUNTED");
+		}
+
+		//The same pages are remote for a thread on node 0
+		BufMgr::setThreadNode(0);
+		for (int k = 0; k < 5; k++)
+		{
+			numaMgr.readPage(&file, pageNos[k], page);
+			numaMgr.unPinPage(&file, pageNos[k], false);
+		}
+		if (numaMgr.getBufStats().remoteAccesses != 5)
+		{
+			PRINT_ERROR("ERROR :: REMOTE ACCESSES NOT COUNTED");
+		}
+
+		//Once the local partition is pinned full, misses spill to the other one
+		numaMgr.clearBufStats();
+		PageId pinned[20];
+		for (int k = 0; k < 20; k++)
+			numaMgr.allocPage(&file, pinned[k], page);
+		if (numaMgr.getBufStats().remoteAllocs != 10 || numaMgr.getBufStats().localAccesses != 10)
+		{
+			PRINT_ERROR("ERROR :: FULL PARTITION DID NOT SPILL");
+		}
+		try
+		{
+			numaMgr.allocPage(&file, pageno1, page);
+			PRINT_ERROR("ERROR :: PINNED POOL ALLOCATED A FRAME");
+		}
+		catch(BufferExceededException &e)
+		{
+		}
+		for (int k = 0; k < 20; k++)
+			numaMgr.unPinPage(&file, pinned[k], true);
+		numaMgr.flushFile(&file);
+
+		//Pages read into frames are copied into the partition's memory rather than replacing it
+		for (int k = 0; k < 5; k++)
+		{
+			numaMgr.readPage(&file, pinned[k], page);
+			numaMgr.unPinPage(&file, pinned[k], false);
+		}
+		if (numaMgr.getPartitionArena(0).freeSlots() != 0 || numaMgr.getPartitionArena(1).freeSlots() != 0)
+		{
+			PRINT_ERROR("ERROR :: READ PAGE LEFT PARTITION MEMORY");
+		}
+
+		//The node set through BufMgr applies to every kind of buffer manager
+		BufMgrT<ClockPolicy, BufHashTbl, AtomicLatching> latchedMgr(20, 2);
+		BufMgr::setThreadNode(1);
+		latchedMgr.allocPage(&file, pageno1, page);
+		if (latchedMgr.partitionOf(page - latchedMgr.bufPool) != 1)
+		{
+			PRINT_ERROR("ERROR :: THREAD NODE NOT SHARED BY BUFFER MANAGERS");
+		}
+		latchedMgr.unPinPage(&file, pageno1, true);
+		latchedMgr.flushFile(&file);
+		BufMgr::setThreadNode(-1);
+	}
+	File::remove(filename);
+
+	std::cout << "Test 23 passed" << "\n";
+}
+
+void test24()
+{
+	const std::string& filename = "test.shm";
+	const std::string& cachename = "/badgerdb_test24";
+	std::remove(filename.c_str());
+	SharedPageCache::remove(cachename);
+	{
+		File file = File::create(filename);
+		SharedPageCache cache(cachename, 64);
+		BufMgr sharedMgr(5);
+		sharedMgr.setSharedCache(&cache);
+		for (int k = 1; k <= 10; k++)
+		{
+			sharedMgr.allocPage(&file, pageno1, page);
+			sprintf((char*)tmpbuf, "shared page %d", pageno1);
+			page->insertRecord(tmpbuf);
+			sharedMgr.unPinPage(&file, pageno1, true);
+		}
+		//Unpinned pages are kept in the shared pool only, dirty ones too
+		std::vector<DirtyPageEntry> dirty;
+		sharedMgr.getDirtyPages(dirty);
+		if (dirty.size() != 10)
+		{
+			PRINT_ERROR("ERROR :: DIRTY PAGES NOT HANDED TO THE SHARED POOL");
+		}
+
+		//Another process with a pool of five frames reads them from there, although they are not on disk yet
+		std::cout.flush();
+		pid_t child = fork();
+		if (child == 0)
+		{
+			SharedPageCache childCache(cachename, 64);
+			BufMgr childMgr(5);
+			childMgr.setSharedCache(&childCache);
+			std::uint64_t bytesRead = file.bytesRead();
+			int matched = 0;
+			for (PageId pageNo = 1; pageNo <= 10; pageNo++)
+			{
+				Page* childPage;
+				childMgr.readPage(&file, pageNo, childPage);
+				sprintf((char*)tmpbuf, "shared page %d", pageNo);
+				if (childPage->getRecord(RecordId{pageNo, 1}) == tmpbuf)
+					matched++;
+				childMgr.unPinPage(&file, pageNo, false);
+			}
+			Page* childPage;
+			childMgr.readPage(&file, 5, childPage);
+			childPage->insertRecord("changed by the child");
+			childMgr.unPinPage(&file, 5, true);
+			_exit(matched == 10 && file.bytesRead() == bytesRead ? 0 : 1);
+		}
+		int status = -1;
+		waitpid(child, &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || cache.hits() != 11 || cache.misses() != 0)
+		{
+			PRINT_ERROR("ERROR :: OTHER PROCESS DID NOT READ FROM THE SHARED POOL");
+		}
+
+		//The change of the other process is seen here without going to disk
+		sharedMgr.readPage(&file, 5, page);
+		if (page->getRecord(RecordId{5, 2}) != "changed by the child")
+		{
+			PRINT_ERROR("ERROR :: CHANGE OF OTHER PROCESS NOT IN THE SHARED POOL");
+		}
+		sharedMgr.unPinPage(&file, 5, false);
+
+		//Flushing the file writes back the dirty pages of the shared pool
+		sharedMgr.flushFile(&file);
+		dirty.clear();
+		sharedMgr.getDirtyPages(dirty);
+		if (!dirty.empty() || file.readPage(5).getRecord(RecordId{5, 2}) != "changed by the child")
+		{
+			PRINT_ERROR("ERROR :: SHARED POOL NOT WRITTEN BACK");
+		}
+
+		//A page missing from the shared pool is read from disk once
+		cache.invalidate(&file, 7);
+		Page copy;
+		if (cache.read(&file, 7, copy) || !cache.read(&file, 7, copy) || cache.misses() != 1 ||
+				copy.getRecord(RecordId{7, 1}) != "shared page 7")
+		{
+			PRINT_ERROR("ERROR :: MISSING PAGE NOT LOADED INTO THE SHARED POOL");
+		}
+
+		//Disposed pages leave the shared pool
+		sharedMgr.disposePage(&file, 3);
+		try
+		{
+			cache.read(&file, 3, copy);
+			PRINT_ERROR("ERROR :: DISPOSED PAGE STILL IN SHARED POOL");
+		}
+		catch(InvalidPageException &e)
+		{
+		}
+		if (!cache.read(&file, 4, copy))
+		{
+			PRINT_ERROR("ERROR :: PAGE DROPPED FROM SHARED POOL");
+		}
+		cache.invalidateFile(&file);
+	}
+	File::remove(filename);
+	SharedPageCache::remove(cachename);
+
+	//Dirty pages replaced in a small shared pool are written back by the process replacing them
+	{
+		File file = File::create(filename);
+		SharedPageCache cache(cachename, 4);
+		BufMgr sharedMgr(2);
+		sharedMgr.setSharedCache(&cache);
+		for (int k = 1; k <= 10; k++)
+		{
+			sharedMgr.allocPage(&file, pageno1, page);
+			sprintf((char*)tmpbuf, "small pool page %d", pageno1);
+			page->insertRecord(tmpbuf);
+			sharedMgr.unPinPage(&file, pageno1, true);
+		}
+		for (PageId pageNo = 1; pageNo <= 6; pageNo++)
+		{
+			sprintf((char*)tmpbuf, "small pool page %d", pageNo);
+			if (file.readPage(pageNo).getRecord(RecordId{pageNo, 1}) != tmpbuf)
+			{
+				PRINT_ERROR("ERROR :: REPLACED DIRTY PAGE NOT WRITTEN BACK");
+			}
+		}
+		for (PageId pageNo = 1; pageNo <= 10; pageNo++)
+		{
+			sharedMgr.readPage(&file, pageNo, page);
+			sprintf((char*)tmpbuf, "small pool page %d", pageNo);
+			if (page->getRecord(RecordId{pageNo, 1}) != tmpbuf)
+			{
+				PRINT_ERROR("ERROR :: PAGE LOST IN SMALL SHARED POOL");
+			}
+			sharedMgr.unPinPage(&file, pageNo, false);
+		}
+		sharedMgr.flushFile(&file);
+		cache.invalidateFile(&file);
+	}
+	File::remove(filename);
+	SharedPageCache::remove(cachename);
+
+	std::cout << "Test 24 passed" << "\n";
+}
+
+void test25()
+{
+	const std::string& oltpname = "test.oltp";
+	const std::string& scanname = "test.scan";
+	std::remove(oltpname.c_str());
+	std::remove(scanname.c_str());
+	{
+		File oltpFile = File::create(oltpname);
+		File scanFile = File::create(scanname);
+		BufMgr quotaMgr(10);
+		TenantId oltp = quotaMgr.createTenant("oltp", 4, 10);
+		TenantId scan = quotaMgr.createTenant("scan", 0, 6);
+		quotaMgr.assignFile(&oltpFile, oltp);
+		quotaMgr.assignFile(&scanFile, scan);
+
+		//Quotas that cannot be honoured are rejected
+		try
+		{
+			quotaMgr.createTenant("bad", 5, 4);
+			PRINT_ERROR("ERROR :: MINIMUM ABOVE MAXIMUM ACCEPTED");
+		}
+		catch(InvalidQuotaException &e)
+		{
+		}
+		try
+		{
+			quotaMgr.createTenant("greedy", 7, 10);
+			PRINT_ERROR("ERROR :: MINIMUMS ABOVE POOL SIZE ACCEPTED");
+		}
+		catch(InvalidQuotaException &e)
+		{
+		}
+
+		//The scan alone may not take more than its maximum, even with free frames left
+		PageId scanPages[30];
+		for (int k = 0; k < 30; k++)
+		{
+			quotaMgr.allocPage(&scanFile, scanPages[k], page);
+			quotaMgr.unPinPage(&scanFile, scanPages[k], true);
+			if (quotaMgr.getTenantStats(scan).frames > 6)
+			{
+				PRINT_ERROR("ERROR :: TENANT EXCEEDED ITS MAXIMUM");
+			}
+		}
+
+		//The oltp tenant fills the rest, then keeps its minimum against a competing scan
+		PageId oltpPages[4];
+		for (int k = 0; k < 4; k++)
+		{
+			quotaMgr.allocPage(&oltpFile, oltpPages[k], page);
+			quotaMgr.unPinPage(&oltpFile, oltpPages[k], true);
+		}
+		quotaMgr.assignFile(&scanFile, 0);
+		for (int k = 0; k < 30; k++)
+		{
+			quotaMgr.readPage(&scanFile, scanPages[k], page);
+			quotaMgr.unPinPage(&scanFile, scanPages[k], false);
+		}
+		if (quotaMgr.getTenantStats(oltp).frames != 4)
+		{
+			PRINT_ERROR("ERROR :: TENANT EVICTED BELOW ITS MINIMUM");
+		}
+		quotaMgr.clearBufStats();
+		for (int k = 0; k < 4; k++)
+		{
+			quotaMgr.readPage(&oltpFile, oltpPages[k], page);
+			quotaMgr.unPinPage(&oltpFile, oltpPages[k], false);
+		}
+		if (quotaMgr.getTenantStats(oltp).hits != 4 || quotaMgr.getTenantStats(oltp).misses != 0)
+		{
+			PRINT_ERROR("ERROR :: PROTECTED PAGES NOT RESIDENT");
+		}
+
+		//Minimums are not reserved: frames an idle tenant does not use serve others
+		quotaMgr.flushFile(&oltpFile);
+		quotaMgr.flushFile(&scanFile);
+		for (int k = 0; k < 10; k++)
+		{
+			quotaMgr.readPage(&scanFile, scanPages[k], page);
+			quotaMgr.unPinPage(&scanFile, scanPages[k], false);
+		}
+		if (quotaMgr.getTenantStats(0).frames != 10 || quotaMgr.getTenantStats(oltp).frames != 0)
+		{
+			PRINT_ERROR("ERROR :: IDLE MINIMUM LEFT FRAMES UNUSED");
+		}
+		quotaMgr.flushFile(&scanFile);
+
+		//Victims come from tenants above their minimum first, the allocating tenant's own pages only after that
+		BufMgr fairMgr(9);
+		TenantId small = fairMgr.createTenant("small", 5, 9);
+		TenantId big = fairMgr.createTenant("big", 2, 9);
+		fairMgr.assignFile(&scanFile, small);
+		fairMgr.assignFile(&oltpFile, big);
+		for (int k = 0; k < 5; k++)
+		{
+			fairMgr.readPage(&scanFile, scanPages[k], page);
+			fairMgr.unPinPage(&scanFile, scanPages[k], false);
+		}
+		for (int k = 0; k < 4; k++)
+		{
+			fairMgr.readPage(&oltpFile, oltpPages[k], page);
+			fairMgr.unPinPage(&oltpFile, oltpPages[k], false);
+		}
+		const std::uint32_t expectSmall[3] = {6, 7, 7};
+		const std::uint32_t expectBig[3] = {3, 2, 2};
+		for (int k = 0; k < 3; k++)
+		{
+			fairMgr.readPage(&scanFile, scanPages[5 + k], page);
+			fairMgr.unPinPage(&scanFile, scanPages[5 + k], false);
+			if (fairMgr.getTenantStats(small).frames != expectSmall[k] || fairMgr.getTenantStats(big).frames != expectBig[k])
+			{
+				PRINT_ERROR("ERROR :: TENANT ABOVE ITS MINIMUM NOT REPLACED FIRST");
+			}
+		}
+	}
+	File::remove(oltpname);
+	File::remove(scanname);
+
+	std::cout << "Test 25 passed" << "\n";
+}
+
+void test26()
+{
+	const std::string& filename = "test.lru";
+	std::remove(filename.c_str());
+	{
+		File file = File::create(filename);
+		BufMgr lruMgr(10);
+		MidpointLru policy(40, std::chrono::milliseconds(0));
+		lruMgr.setReplacementPolicy(&policy);
+
+		//Pages enter old and are promoted when accessed again
+		PageId hot[5];
+		for (int k = 0; k < 5; k++)
+		{
+			lruMgr.allocPage(&file, hot[k], page);
+			if (policy.isYoung(page - lruMgr.bufPool))
+			{
+				PRINT_ERROR("ERROR :: NEW PAGE NOT INSERTED AT THE MIDPOINT");
+			}
+			lruMgr.unPinPage(&file, hot[k], true);
+		}
+		for (int k = 0; k < 5; k++)
+		{
+			lruMgr.readPage(&file, hot[k], page);
+			if (!policy.isYoung(page - lruMgr.bufPool))
+			{
+				PRINT_ERROR("ERROR :: ACCESSED PAGE NOT PROMOTED");
+			}
+			lruMgr.unPinPage(&file, hot[k], false);
+		}
+
+		//Hits in the young sublist leave it alone
+		for (int k = 0; k < 5; k++)
+		{
+			lruMgr.readPage(&file, hot[k], page);
+			lruMgr.unPinPage(&file, hot[k], false);
+		}
+		if (policy.promotions() != 5 || policy.youngFrames() != 5)
+		{
+			PRINT_ERROR("ERROR :: YOUNG HIT CHANGED THE LISTS");
+		}
+
+		//A scan twice the size of the pool only cycles through the old sublist
+		for (int k = 0; k < 20; k++)
+		{
+			lruMgr.allocPage(&file, pageno1, page);
+			lruMgr.unPinPage(&file, pageno1, true);
+		}
+		lruMgr.clearBufStats();
+		for (int k = 0; k < 5; k++)
+		{
+			lruMgr.readPage(&file, hot[k], page);
+			lruMgr.unPinPage(&file, hot[k], false);
+		}
+		if (lruMgr.getTenantStats(0).hits != 5)
+		{
+			PRINT_ERROR("ERROR :: SCAN EVICTED YOUNG PAGES");
+		}
+
+		//Accesses within the promotion delay do not promote
+		MidpointLru slowPolicy(40, std::chrono::hours(1));
+		lruMgr.setReplacementPolicy(&slowPolicy);
+		for (int k = 0; k < 5; k++)
+		{
+			lruMgr.readPage(&file, hot[k], page);
+			lruMgr.unPinPage(&file, hot[k], false);
+		}
+		if (slowPolicy.promotions() != 0 || slowPolicy.youngFrames() != 0)
+		{
+			PRINT_ERROR("ERROR :: PAGE PROMOTED BEFORE THE DELAY");
+		}
+		lruMgr.setReplacementPolicy(NULL);
+		lruMgr.flushFile(&file);
+	}
+	File::remove(filename);
+
+	std::cout << "Test 26 passed" << "\n";
+}
+
+void test27()
+{
+	const std::string& hotname = "test.hot";
+	const std::string& coldname = "test.cold";
+	std::remove(hotname.c_str());
+	std::remove(coldname.c_str());
+	{
+		//Estimates count accesses and are halved once the sample is full
+		TinyLfu sketch(16);
+		for (int k = 0; k < 20; k++)
+			sketch.recordAccess(NULL, 1);
+		if (sketch.estimate(NULL, 1) != 15 || sketch.estimate(NULL, 2) != 0)
+		{
+			PRINT_ERROR("ERROR :: SKETCH ESTIMATE WRONG");
+		}
+		for (PageId k = 100; sketch.resets() == 0; k++)
+			sketch.recordAccess(NULL, k);
+		if (sketch.estimate(NULL, 1) > 7)
+		{
+			PRINT_ERROR("ERROR :: SKETCH NOT AGED");
+		}
+
+		File hotFile = File::create(hotname);
+		File coldFile = File::create(coldname);
+		for (int k = 0; k < 30; k++)
+		{
+			Page coldPage = coldFile.allocatePage();
+			coldFile.writePage(coldPage);
+		}
+		//The sketch is sized for 100 frames so that collisions cannot lift a cold page over a hot one
+		BufMgr lfuMgr(10);
+		TinyLfu filter(100);
+		lfuMgr.setAdmissionFilter(&filter);
+
+		//Eight frequently used pages
+		PageId hot[8];
+		for (int k = 0; k < 8; k++)
+		{
+			lfuMgr.allocPage(&hotFile, hot[k], page);
+			lfuMgr.unPinPage(&hotFile, hot[k], true);
+		}
+		for (int round = 0; round < 3; round++)
+		{
+			for (int k = 0; k < 8; k++)
+			{
+				lfuMgr.readPage(&hotFile, hot[k], page);
+				lfuMgr.unPinPage(&hotFile, hot[k], false);
+			}
+		}
+
+		//One-hit wonders replace each other in the window
+		for (PageId pageNo = 1; pageNo <= 30; pageNo++)
+		{
+			lfuMgr.readPage(&coldFile, pageNo, page);
+			lfuMgr.unPinPage(&coldFile, pageNo, false);
+		}
+		if (filter.rejections() < 25)
+		{
+			PRINT_ERROR("ERROR :: COLD PAGES ADMITTED");
+		}
+		lfuMgr.clearBufStats();
+		for (int k = 0; k < 8; k++)
+		{
+			lfuMgr.readPage(&hotFile, hot[k], page);
+			lfuMgr.unPinPage(&hotFile, hot[k], false);
+		}
+		if (lfuMgr.getTenantStats(0).hits + filter.windowFrames() < 8)
+		{
+			PRINT_ERROR("ERROR :: COLD PAGES EVICTED FREQUENT PAGES");
+		}
+
+		//A cold page that becomes frequent is admitted when it leaves the window
+		for (int round = 0; round < 6; round++)
+		{
+			lfuMgr.readPage(&coldFile, 15, page);
+			lfuMgr.unPinPage(&coldFile, 15, false);
+		}
+		lfuMgr.readPage(&coldFile, 16, page);
+		lfuMgr.unPinPage(&coldFile, 16, false);
+		if (filter.admissions() == 0)
+		{
+			PRINT_ERROR("ERROR :: FREQUENT PAGE NOT ADMITTED");
+		}
+		lfuMgr.setAdmissionFilter(NULL);
+		lfuMgr.flushFile(&hotFile);
+		lfuMgr.flushFile(&coldFile);
+	}
+	File::remove(hotname);
+	File::remove(coldname);
+
+	std::cout << "Test 27 passed" << "\n";
+}
+
+void test28()
+{
+	const std::string& filename = "test.sampled";
+	std::remove(filename.c_str());
+	{
+		File file = File::create(filename);
+		PageId pageNos[40];
+		for (int k = 0; k < 40; k++)
+		{
+			Page newPage = file.allocatePage();
+			pageNos[k] = newPage.page_number();
+			file.writePage(newPage);
+		}
+
+		//Sampling every frame of a small pool evicts the least recently used page
+		BufMgr lruMgr(10);
+		SampledEviction lru(SampledEviction::LRU, 20, 4);
+		lruMgr.setReplacementPolicy(&lru);
+		for (int k = 0; k < 10; k++)
+		{
+			lruMgr.readPage(&file, pageNos[k], page);
+			lruMgr.unPinPage(&file, pageNos[k], false);
+		}
+		for (int k = 9; k >= 0; k--)
+		{
+			lruMgr.readPage(&file, pageNos[k], page);
+			lruMgr.unPinPage(&file, pageNos[k], false);
+		}
+		//Page 9 is now the least recently used one
+		lruMgr.readPage(&file, pageNos[10], page);
+		lruMgr.unPinPage(&file, pageNos[10], false);
+		lruMgr.clearBufStats();
+		for (int k = 0; k < 9; k++)
+		{
+			lruMgr.readPage(&file, pageNos[k], page);
+			lruMgr.unPinPage(&file, pageNos[k], false);
+		}
+		if (lruMgr.getTenantStats(0).hits != 9 || lru.framesSampled() == 0)
+		{
+			PRINT_ERROR("ERROR :: SAMPLED LRU EVICTED A RECENT PAGE");
+		}
+
+		//Pinned frames are never sampled as victims
+		Page* pinned[10];
+		for (int k = 0; k < 10; k++)
+			lruMgr.readPage(&file, pageNos[k], pinned[k]);
+		try
+		{
+			lruMgr.readPage(&file, pageNos[20], page);
+			PRINT_ERROR("ERROR :: SAMPLING EVICTED A PINNED PAGE");
+		}
+		catch(BufferExceededException &e)
+		{
+		}
+		for (int k = 0; k < 10; k++)
+			lruMgr.unPinPage(&file, pageNos[k], false);
+		lruMgr.setReplacementPolicy(NULL);
+
+		//In LFU mode frequent pages survive a scan
+		BufMgr lfuMgr(10);
+		SampledEviction lfu(SampledEviction::LFU, 5, 16);
+		lfuMgr.setReplacementPolicy(&lfu);
+		for (int round = 0; round < 50; round++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				lfuMgr.readPage(&file, pageNos[k], page);
+				lfuMgr.unPinPage(&file, pageNos[k], false);
+			}
+		}
+		if (lfu.frequency(page - lfuMgr.bufPool) <= 5)
+		{
+			PRINT_ERROR("ERROR :: ACCESS COUNTER NOT INCREMENTED");
+		}
+		for (int k = 3; k < 40; k++)
+		{
+			lfuMgr.readPage(&file, pageNos[k], page);
+			lfuMgr.unPinPage(&file, pageNos[k], false);
+		}
+		lfuMgr.clearBufStats();
+		for (int k = 0; k < 3; k++)
+		{
+			lfuMgr.readPage(&file, pageNos[k], page);
+			lfuMgr.unPinPage(&file, pageNos[k], false);
+		}
+		if (lfuMgr.getTenantStats(0).hits != 3)
+		{
+			PRINT_ERROR("ERROR :: SAMPLED LFU EVICTED FREQUENT PAGES");
+		}
+		lfuMgr.setReplacementPolicy(NULL);
+	}
+	File::remove(filename);
+
+	std::cout << "Test 28 passed" << "\n";
+}
+
+void test29()
+{
+	const std::string& filename = "test.hint";
+	std::remove(filename.c_str());
+	{
+		File file = File::create(filename);
+		PageId pageNos[30];
+		for (int k = 0; k < 30; k++)
+		{
+			Page newPage = file.allocatePage();
+			pageNos[k] = newPage.page_number();
+			file.writePage(newPage);
+		}
+		BufMgr hintMgr(5);
+
+		//A page kept hot survives a scan; the hint stays when it is later pinned normally
+		hintMgr.readPage(&file, pageNos[0], page, HINT_KEEP_HOT);
+		hintMgr.unPinPage(&file, pageNos[0], false);
+		hintMgr.readPage(&file, pageNos[0], page);
+		hintMgr.unPinPage(&file, pageNos[0], false);
+		for (int k = 10; k < 30; k++)
+		{
+			hintMgr.readPage(&file, pageNos[k], page);
+			hintMgr.unPinPage(&file, pageNos[k], false);
+		}
+		hintMgr.clearBufStats();
+		hintMgr.readPage(&file, pageNos[0], page);
+		hintMgr.unPinPage(&file, pageNos[0], false);
+		if (hintMgr.getTenantStats(0).hits != 1)
+		{
+			PRINT_ERROR("ERROR :: KEEP_HOT PAGE EVICTED BY A SCAN");
+		}
+
+		//A page to be evicted soon goes first, even though it was used last
+		for (int k = 1; k < 4; k++)
+		{
+			hintMgr.readPage(&file, pageNos[k], page);
+			hintMgr.unPinPage(&file, pageNos[k], false);
+		}
+		hintMgr.allocPage(&file, pageno1, page);
+		hintMgr.unPinPage(&file, pageno1, true, HINT_EVICT_SOON);
+		hintMgr.readPage(&file, pageNos[4], page);
+		hintMgr.unPinPage(&file, pageNos[4], false);
+		hintMgr.clearBufStats();
+		for (int k = 0; k < 5; k++)
+		{
+			hintMgr.readPage(&file, pageNos[k], page);
+			hintMgr.unPinPage(&file, pageNos[k], false);
+		}
+		if (hintMgr.getTenantStats(0).hits != 5)
+		{
+			PRINT_ERROR("ERROR :: EVICT_SOON PAGE NOT EVICTED FIRST");
+		}
+
+		//Kept-hot pages are still replaced when nothing else can be
+		for (int k = 0; k < 5; k++)
+		{
+			hintMgr.readPage(&file, pageNos[k], page, HINT_KEEP_HOT);
+			hintMgr.unPinPage(&file, pageNos[k], false);
+		}
+		hintMgr.readPage(&file, pageNos[5], page);
+		hintMgr.unPinPage(&file, pageNos[5], false);
+
+		//Replacement policies honour the hints as well
+		MidpointLru lru(40, std::chrono::milliseconds(0));
+		hintMgr.setReplacementPolicy(&lru);
+		hintMgr.readPage(&file, pageNos[6], page, HINT_EVICT_SOON);
+		hintMgr.unPinPage(&file, pageNos[6], false);
+		hintMgr.readPage(&file, pageNos[7], page);
+		hintMgr.unPinPage(&file, pageNos[7], false);
+		hintMgr.clearBufStats();
+		hintMgr.readPage(&file, pageNos[6], page);
+		hintMgr.unPinPage(&file, pageNos[6], false);
+		if (hintMgr.getTenantStats(0).misses != 1)
+		{
+			PRINT_ERROR("ERROR :: POLICY IGNORED EVICT_SOON");
+		}
+		hintMgr.setReplacementPolicy(NULL);
+		hintMgr.flushFile(&file);
+	}
+	File::remove(filename);
+
+	std::cout << "Test 29 passed" << "\n";
+}
+
+void test30()
+{
+	const std::string& filename = "test.latch";
+	std::remove(filename.c_str());
+	{
+		File file = File::create(filename);
+		PageId pageNos[40];
+		for (int k = 0; k < 40; k++)
+		{
+			Page newPage = file.allocatePage();
+			pageNos[k] = newPage.page_number();
+			file.writePage(newPage);
+		}
+
+		//The clock specialization replaces the same pages as BufMgr without a policy
+		BufMgr dynamicMgr(10);
+		BufMgrT<> clockMgr(10);
+		for (int k = 0; k < 200; k++)
+		{
+			const PageId pageNo = pageNos[(k * k) % 23];
+			dynamicMgr.readPage(&file, pageNo, page);
+			dynamicMgr.unPinPage(&file, pageNo, false);
+			clockMgr.readPage(&file, pageNo, page);
+			clockMgr.unPinPage(&file, pageNo, false);
+		}
+		if (clockMgr.getTenantStats(0).hits != dynamicMgr.getTenantStats(0).hits)
+		{
+			PRINT_ERROR("ERROR :: CLOCK SPECIALIZATION DIFFERS FROM BufMgr");
+		}
+
+		//Threads share a latched pool; every access is counted once and every pin released
+		BufMgrT<ClockPolicy, BufHashTbl, AtomicLatching> latchedMgr(10);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; t++)
+		{
+			threads.push_back(std::thread([&, t] {
+				Page* threadPage;
+				for (int k = 0; k < 500; k++)
+				{
+					const PageId pageNo = pageNos[(k * 7 + t) % 40];
+					latchedMgr.readPage(&file, pageNo, threadPage);
+					latchedMgr.unPinPage(&file, pageNo, k % 3 == 0);
+				}
+			}));
+		}
+		for (std::size_t t = 0; t < threads.size(); t++)
+		{
+			threads[t].join();
+		}
+		const TenantStats& stats = latchedMgr.getTenantStats(0);
+		if (stats.hits + stats.misses != 2000)
+		{
+			PRINT_ERROR("ERROR :: LATCHED POOL LOST ACCESSES");
+		}
+
+		//Dirty pages are collected and written back while other threads dirty them
+		threads.clear();
+		std::atomic<bool> stop(false);
+		std::thread writer([&] {
+			std::vector<DirtyPageEntry> dirtyPages;
+			while (!stop.load())
+			{
+				dirtyPages.clear();
+				latchedMgr.getDirtyPages(dirtyPages);
+				latchedMgr.writeBackDirty(1, 4);
+				std::this_thread::yield();
+			}
+		});
+		for (int t = 0; t < 2; t++)
+		{
+			threads.push_back(std::thread([&, t] {
+				Page* threadPage;
+				for (int k = 0; k < 500; k++)
+				{
+					const PageId pageNo = pageNos[(k * 3 + t) % 40];
+					latchedMgr.readPage(&file, pageNo, threadPage);
+					latchedMgr.unPinPage(&file, pageNo, true);
+				}
+			}));
+		}
+		for (std::size_t t = 0; t < threads.size(); t++)
+		{
+			threads[t].join();
+		}
+		stop = true;
+		writer.join();
+		latchedMgr.writeBackDirty(1, 10);
+		std::vector<DirtyPageEntry> dirtyPages;
+		latchedMgr.getDirtyPages(dirtyPages);
+		if (!dirtyPages.empty())
+		{
+			PRINT_ERROR("ERROR :: LATCHED POOL KEPT DIRTY PAGES");
+		}
+		latchedMgr.flushFile(&file);
+		dynamicMgr.flushFile(&file);
+		clockMgr.flushFile(&file);
+	}
+	File::remove(filename);
+
+	std::cout << "Test 30 passed" << "\n";
+}
+
+bool fileContains(const std::string& filename, const std::string& bytes)
+{
+	std::ifstream in(filename.c_str(), std::ios::binary);
+	const std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	return contents.find(bytes) != std::string::npos;
+}
+
+void test31()
+{
+	const std::string& filename = "test.durable";
+	std::remove(filename.c_str());
+	{
+		File file = File::create(filename);
+		if (file.durability() != DURABILITY_FLUSH_ON_SYNC || file.syncCount() != 0)
+		{
+			PRINT_ERROR("ERROR :: NEW FILE NOT IN FLUSH ON SYNC MODE");
+		}
+		Page newPage = file.allocatePage();
+		const PageId pageNo = newPage.page_number();
+
+		//Without durability sync() does nothing
+		file.setDurability(DURABILITY_NONE);
+		newPage.insertRecord("durability none");
+		file.writePage(newPage);
+		file.sync();
+		if (file.syncCount() != 0)
+		{
+			PRINT_ERROR("ERROR :: SYNC WITHOUT DURABILITY");
+		}
+
+		//Flush on sync hands the page to the kernel but never waits for the disk
+		file.setDurability(DURABILITY_FLUSH_ON_SYNC);
+		newPage.insertRecord("durability flush");
+		file.writePage(newPage);
+		file.sync();
+		if (file.syncCount() != 0 || !fileContains(filename, "durability flush"))
+		{
+			PRINT_ERROR("ERROR :: FLUSH ON SYNC NOT FLUSHED OR SYNCED");
+		}
+
+		//Fdatasync on sync makes writes durable only when sync() is called, with one sync for all of them
+		file.setDurability(DURABILITY_FDATASYNC_ON_SYNC);
+		for (int k = 0; k < 3; k++)
+		{
+			newPage.insertRecord("durability fdatasync");
+			file.writePage(newPage);
+		}
+		if (file.syncCount() != 0)
+		{
+			PRINT_ERROR("ERROR :: WRITE SYNCED BEFORE SYNC");
+		}
+		file.sync();
+		if (file.syncCount() != 1)
+		{
+			PRINT_ERROR("ERROR :: SYNC NOT DURABLE");
+		}
+
+		//Fsync per write makes every write durable before it returns
+		file.setDurability(DURABILITY_FSYNC_PER_WRITE);
+		for (int k = 0; k < 3; k++)
+		{
+			newPage.insertRecord("durability fsync");
+			file.writePage(newPage);
+		}
+		if (file.syncCount() != 1 + 3 || !fileContains(filename, "durability fsync"))
+		{
+			PRINT_ERROR("ERROR :: WRITE NOT DURABLE ON RETURN");
+		}
+
+		//A dirty page in the buffer pool becomes durable when its file is flushed
+		file.setDurability(DURABILITY_FDATASYNC_ON_SYNC);
+		std::uint64_t syncs = file.syncCount();
+		BufMgr syncMgr(5);
+		syncMgr.readPage(&file, pageNo, page);
+		page->insertRecord("durability flushFile");
+		syncMgr.unPinPage(&file, pageNo, true);
+		if (file.syncCount() != syncs || fileContains(filename, "durability flushFile"))
+		{
+			PRINT_ERROR("ERROR :: DIRTY PAGE WRITTEN BEFORE FLUSH");
+		}
+		syncMgr.flushFile(&file);
+		if (file.syncCount() != syncs + 1 || !fileContains(filename, "durability flushFile"))
+		{
+			PRINT_ERROR("ERROR :: FLUSHED FILE NOT DURABLE");
+		}
+		syncMgr.readPage(&file, pageNo, page);
+		page->insertRecord("durability flushPage");
+		syncMgr.unPinPage(&file, pageNo, true);
+		syncMgr.flushPage(&file, pageNo);
+		if (file.syncCount() != syncs + 2 || !fileContains(filename, "durability flushPage"))
+		{
+			PRINT_ERROR("ERROR :: FLUSHED PAGE NOT DURABLE");
+		}
+	}
+	{
+		//The mode and the count are reset when the file is closed
+		File file = File::open(filename);
+		if (file.durability() != DURABILITY_FLUSH_ON_SYNC || file.syncCount() != 0)
+		{
+			PRINT_ERROR("ERROR :: DURABILITY NOT RESET ON CLOSE");
+		}
+	}
+	File::remove(filename);
+
+	std::cout << "Test 31 passed" << "\n";
+}
@@ -0,0 +1,135 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "midpoint_lru.h"
+
+namespace badgerdb {
+
+MidpointLru::MidpointLru(const std::uint32_t old_percent,
+                         const std::chrono::milliseconds promotion_delay)
+    : old_percent_(old_percent > 100 ? 100 : old_percent),
+      promotion_delay_(promotion_delay),
+      young_capacity_(0),
+      promotions_(0) {
+  reset(0);
+}
+
+void MidpointLru::reset(const std::uint32_t frames) {
+  prev_.assign(frames, -1);
+  next_.assign(frames, -1);
+  young_.assign(frames, false);
+  read_time_.assign(frames, std::chrono::steady_clock::time_point());
+  for (int list = YOUNG; list <= OLD; ++list) {
+    lists_[list].head = -1;
+    lists_[list].tail = -1;
+    lists_[list].size = 0;
+  }
+  for (FrameId frame = 0; frame < frames; ++frame) {
+    pushTail(OLD, frame);
+  }
+  young_capacity_ = frames - frames * old_percent_ / 100;
+  promotions_ = 0;
+}
+
+void MidpointLru::pageInstalled(const FrameId frame) {
+  unlink(frame);
+  pushHead(OLD, frame);
+  read_time_[frame] = std::chrono::steady_clock::now();
+}
+
+void MidpointLru::pageAccessed(const FrameId frame) {
+  if (young_[frame]) {
+    return;
+  }
+  if (std::chrono::steady_clock::now() - read_time_[frame] <
+      promotion_delay_) {
+    return;
+  }
+  makeYoung(frame);
+  ++promotions_;
+}
+
+void MidpointLru::pageHinted(const FrameId frame, const AccessHint hint) {
+  if (hint == HINT_KEEP_HOT) {
+    makeYoung(frame);
+  } else if (hint == HINT_EVICT_SOON) {
+    unlink(frame);
+    pushTail(OLD, frame);
+  }
+}
+
+void MidpointLru::pageRemoved(const FrameId frame) {
+  unlink(frame);
+  pushTail(OLD, frame);
+}
+
+bool MidpointLru::pickVictim(const Evictable& evictable, FrameId& frame) {
+  for (int list = OLD; list >= YOUNG; --list) {
+    for (std::int32_t f = lists_[list].tail; f >= 0; f = prev_[f]) {
+      if (evictable(f)) {
+        frame = f;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void MidpointLru::makeYoung(const FrameId frame) {
+  unlink(frame);
+  pushHead(YOUNG, frame);
+  while (lists_[YOUNG].size > young_capacity_) {
+    const FrameId demoted = lists_[YOUNG].tail;
+    unlink(demoted);
+    pushHead(OLD, demoted);
+  }
+}
+
+void MidpointLru::unlink(const FrameId frame) {
+  List& list = lists_[young_[frame] ? YOUNG : OLD];
+  if (prev_[frame] >= 0) {
+    next_[prev_[frame]] = next_[frame];
+  } else {
+    list.head = next_[frame];
+  }
+  if (next_[frame] >= 0) {
+    prev_[next_[frame]] = prev_[frame];
+  } else {
+    list.tail = prev_[frame];
+  }
+  prev_[frame] = -1;
+  next_[frame] = -1;
+  --list.size;
+}
+
+void MidpointLru::pushHead(const int list, const FrameId frame) {
+  List& l = lists_[list];
+  young_[frame] = list == YOUNG;
+  next_[frame] = l.head;
+  if (l.head >= 0) {
+    prev_[l.head] = frame;
+  } else {
+    l.tail = frame;
+  }
+  l.head = frame;
+  ++l.size;
+}
+
+void MidpointLru::pushTail(const int list, const FrameId frame) {
+  List& l = lists_[list];
+  young_[frame] = list == YOUNG;
+  prev_[frame] = l.tail;
+  if (l.tail >= 0) {
+    next_[l.tail] = frame;
+  } else {
+    l.head = frame;
+  }
+  l.tail = frame;
+  ++l.size;
+}
+
+}
@@ -0,0 +1,106 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "replacement_policy.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief LRU with midpoint insertion: a young and an old sublist.
+ *
+ * Pages read into the pool enter at the head of the old sublist, which holds
+ * the tail end of the LRU order, instead of at the head of the whole list.
+ * An old page is promoted to the head of the young sublist only when it is
+ * accessed again at least <promotion delay> after it was read, so the
+ * repeated accesses of a scan to the same page in quick succession do not
+ * count.  Pages of a scan or of read-ahead therefore leave through the old
+ * sublist without displacing the young pages.  When the young sublist grows
+ * beyond its share, its tail is demoted to the head of the old sublist.
+ *
+ * A hit on a young page does nothing at all.  The young sublist is thus kept
+ * in promotion order rather than exact LRU order, which is what makes hot
+ * hits cheap; a hot page that drifts out to the old sublist is promoted
+ * again by its next access.
+ *
+ * Victims are taken from the tail of the old sublist, then from the tail of
+ * the young sublist.  Free frames are kept at the very tail.  A page hinted
+ * HINT_KEEP_HOT moves to the head of the young sublist and one hinted
+ * HINT_EVICT_SOON to the tail of the old sublist.
+ */
+class MidpointLru : public ReplacementPolicy {
+ public:
+  /**
+   * @param old_percent      Share of the frames kept in the old sublist.
+   * @param promotion_delay  Time an old page must have been resident before
+   *                         an access promotes it.
+   */
+  MidpointLru(const std::uint32_t old_percent,
+              const std::chrono::milliseconds promotion_delay);
+
+  void reset(const std::uint32_t frames) override;
+  void pageInstalled(const FrameId frame) override;
+  void pageAccessed(const FrameId frame) override;
+  void pageHinted(const FrameId frame, const AccessHint hint) override;
+  void pageRemoved(const FrameId frame) override;
+  bool pickVictim(const Evictable& evictable, FrameId& frame) override;
+
+  /**
+   * Returns true if <frame> is in the young sublist.
+   */
+  bool isYoung(const FrameId frame) const { return young_[frame]; }
+
+  /**
+   * Returns the number of frames in the young sublist.
+   */
+  std::uint32_t youngFrames() const { return lists_[YOUNG].size; }
+
+  /**
+   * Returns the number of promotions from the old to the young sublist.
+   */
+  std::uint64_t promotions() const { return promotions_; }
+
+ private:
+  enum { YOUNG = 0, OLD = 1 };
+
+  /**
+   * Ends and length of a sublist; -1 marks the end of a chain.
+   */
+  struct List {
+    std::int32_t head;
+    std::int32_t tail;
+    std::uint32_t size;
+  };
+
+  /**
+   * Moves <frame> to the head of the young sublist, demoting the tail of the
+   * young sublist if it grows beyond its share.
+   */
+  void makeYoung(const FrameId frame);
+
+  void unlink(const FrameId frame);
+  void pushHead(const int list, const FrameId frame);
+  void pushTail(const int list, const FrameId frame);
+
+  std::uint32_t old_percent_;
+  std::chrono::steady_clock::duration promotion_delay_;
+  std::uint32_t young_capacity_;
+  List lists_[2];
+  std::vector<std::int32_t> prev_;
+  std::vector<std::int32_t> next_;
+  std::vector<bool> young_;
+  std::vector<std::chrono::steady_clock::time_point> read_time_;
+  std::uint64_t promotions_;
+};
+
+}
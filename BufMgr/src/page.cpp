@@ -20,6 +20,10 @@ Page::Page() {
   initialize();
 }
 
+Page::Page(FrameArena* arena) : data_(FrameAllocator<char>(arena)) {
+  initialize();
+}
+
 void Page::initialize() {
   header_.free_space_lower_bound = 0;
   header_.free_space_upper_bound = DATA_SIZE;
@@ -27,6 +31,9 @@ void Page::initialize() {
   header_.num_free_slots = 0;
   header_.current_page_number = INVALID_NUMBER;
   header_.next_page_number = INVALID_NUMBER;
+  header_.page_lsn = 0;
+  header_.stored_length = 0;
+  header_.checksum = 0;
   data_.assign(DATA_SIZE, char());
 }
 
@@ -43,7 +50,7 @@ RecordId Page::insertRecord(const std::string& record_data) {
 std::string Page::getRecord(const RecordId& record_id) const {
   validateRecordId(record_id);
   const PageSlot& slot = getSlot(record_id.slot_number);
-  return data_.substr(slot.item_offset, slot.item_length);
+  return std::string(&data_[slot.item_offset], slot.item_length);
 }
 
 void Page::updateRecord(const RecordId& record_id,
@@ -90,7 +97,7 @@ void Page::deleteRecord(const RecordId& record_id,
   }
   // If we have data to move, shift it to the right.
   if (move_bytes > 0) {
-    const std::string& data_to_move = data_.substr(move_offset, move_bytes);
+    const Data data_to_move = data_.substr(move_offset, move_bytes);
     data_.replace(move_offset + slot->item_length, move_bytes, data_to_move);
   }
   header_.free_space_upper_bound += slot->item_length;
@@ -180,7 +187,8 @@ void Page::insertRecordInSlot(const SlotId slot_number,
   slot->item_offset = header_.free_space_upper_bound - record_length;
   header_.free_space_upper_bound = slot->item_offset;
   --header_.num_free_slots;
-  data_.replace(slot->item_offset, slot->item_length, record_data);
+  data_.replace(slot->item_offset, slot->item_length, record_data.data(),
+                record_data.length());
 }
 
 void Page::validateRecordId(const RecordId& record_id) const {
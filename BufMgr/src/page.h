@@ -12,6 +12,7 @@
 #include <memory>
 #include <string>
 
+#include "frame_arena.h"
 #include "types.h"
 
 namespace badgerdb {
@@ -57,6 +58,24 @@ struct PageHeader {
    */
   PageId next_page_number;
 
+  /**
+   * LSN of the log record describing the latest change to this page, or 0 if
+   * the page was never changed under logging.
+   */
+  Lsn page_lsn;
+
+  /**
+   * Size of the page data as stored on disk when it is compressed, or 0 if it
+   * is stored uncompressed.  Only meaningful on disk; File clears it on read.
+   */
+  std::uint32_t stored_length;
+
+  /**
+   * CRC32C of the page as stored on disk, set by File when the page is
+   * written.  Covers the header fields before this one and the page data.
+   */
+  std::uint32_t checksum;
+
   /**
    * Returns true if this page header is equal to the other.
    *
@@ -93,6 +112,8 @@ struct PageSlot {
 };
 
 class PageIterator;
+template <class Policy, class PageTable, class Latching>
+class BufMgrT;
 
 /**
  * @brief Class which represents a fixed-size database page containing records.
@@ -199,6 +220,13 @@ class Page {
    */
   PageId next_page_number() const { return header_.next_page_number; }
 
+  /**
+   * Returns the LSN of the latest logged change to this page.
+   *
+   * @return  Page LSN.
+   */
+  Lsn page_lsn() const { return header_.page_lsn; }
+
   /**
    * Returns an iterator at the first record in the page.
    *
@@ -215,6 +243,20 @@ class Page {
   PageIterator end();
 
  private:
+  /**
+   * Storage for the data of a page; frames of the buffer pool draw it from the
+   * arena of their partition.
+   */
+  typedef std::basic_string<char, std::char_traits<char>, FrameAllocator<char> >
+      Data;
+
+  /**
+   * Constructs a new, uninitialized page whose data is taken from <arena>.
+   *
+   * @param arena   Arena to allocate the data from.
+   */
+  explicit Page(FrameArena* arena);
+
   /**
    * Initializes this page as a new page with no header information or data.
    */
@@ -238,6 +280,15 @@ class Page {
     header_.next_page_number = new_next_page_number;
   }
 
+  /**
+   * Sets the LSN of the latest logged change to this page.
+   *
+   * @param new_page_lsn  LSN of log record.
+   */
+  void set_page_lsn(const Lsn new_page_lsn) {
+    header_.page_lsn = new_page_lsn;
+  }
+
   /**
    * Deletes the record with the given ID.  Page is compacted upon delete to
    * ensure that data of all records is contiguous.  Slot array is compacted if
@@ -329,11 +380,17 @@ class Page {
    * Data stored on the page.  Includes bookkeeping information about slots as
    * well as actual content.
    */
+  Data data_;
 
-  std::string data_;
-
+  template <class Policy, class PageTable, class Latching>
+  friend class BufMgrT;
+  friend class DoubleWriteBuffer;
+  friend class EventLoop;
   friend class File;
+  friend class LogManager;
   friend class PageIterator;
+  friend class SharedPageCache;
+  friend class Snapshot;
   friend class PageTest;
   friend class BufferTest;
 };
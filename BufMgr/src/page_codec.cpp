@@ -0,0 +1,180 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "page_codec.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Shortest back reference worth encoding.
+ */
+const std::size_t MIN_MATCH = 4;
+
+/**
+ * Farthest back reference a 16-bit offset can express.
+ */
+const std::size_t MAX_OFFSET = 65535;
+
+const int HASH_BITS = 12;
+
+std::uint32_t load32(const char* p) {
+  std::uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+std::uint32_t hash(const std::uint32_t sequence) {
+  return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+/**
+ * Appends the continuation bytes of a length whose nibble was saturated.
+ */
+bool putLength(std::size_t length, char*& out, const char* out_end) {
+  while (length >= 255) {
+    if (out == out_end) return false;
+    *out++ = static_cast<char>(255);
+    length -= 255;
+  }
+  if (out == out_end) return false;
+  *out++ = static_cast<char>(length);
+  return true;
+}
+
+/**
+ * Appends one sequence: a literal run optionally followed by a match.
+ */
+bool putSequence(const char* literals, const std::size_t literal_length,
+                 const std::size_t offset, const std::size_t match_length,
+                 char*& out, const char* out_end) {
+  if (out == out_end) return false;
+  const std::size_t match_code =
+      match_length == 0 ? 0 : match_length - MIN_MATCH;
+  char* token = out++;
+  *token = static_cast<char>(
+      ((literal_length < 15 ? literal_length : 15) << 4) |
+      (match_code < 15 ? match_code : 15));
+  if (literal_length >= 15 && !putLength(literal_length - 15, out, out_end)) {
+    return false;
+  }
+  if (static_cast<std::size_t>(out_end - out) < literal_length) return false;
+  std::memcpy(out, literals, literal_length);
+  out += literal_length;
+  if (match_length == 0) {
+    return true;
+  }
+  if (out_end - out < 2) return false;
+  *out++ = static_cast<char>(offset & 0xFF);
+  *out++ = static_cast<char>(offset >> 8);
+  return match_code < 15 || putLength(match_code - 15, out, out_end);
+}
+
+/**
+ * Reads the continuation bytes of a saturated length.
+ */
+bool getLength(std::size_t& length, const unsigned char*& in,
+               const unsigned char* in_end) {
+  unsigned char byte;
+  do {
+    if (in == in_end) return false;
+    byte = *in++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+}
+
+std::size_t lzCompress(const char* source, const std::size_t length,
+                       char* dest, const std::size_t capacity) {
+  int table[1 << HASH_BITS];
+  for (int i = 0; i < (1 << HASH_BITS); ++i) {
+    table[i] = -1;
+  }
+
+  char* out = dest;
+  const char* out_end = dest + capacity;
+  std::size_t anchor = 0;
+  std::size_t pos = 0;
+  while (pos + MIN_MATCH <= length) {
+    const std::uint32_t sequence = load32(source + pos);
+    const std::uint32_t slot = hash(sequence);
+    const int candidate = table[slot];
+    table[slot] = static_cast<int>(pos);
+    if (candidate < 0 || pos - candidate > MAX_OFFSET ||
+        load32(source + candidate) != sequence) {
+      ++pos;
+      continue;
+    }
+    std::size_t match_length = MIN_MATCH;
+    while (pos + match_length < length &&
+           source[candidate + match_length] == source[pos + match_length]) {
+      ++match_length;
+    }
+    if (!putSequence(source + anchor, pos - anchor, pos - candidate,
+                     match_length, out, out_end)) {
+      return 0;
+    }
+    pos += match_length;
+    anchor = pos;
+  }
+  if (!putSequence(source + anchor, length - anchor, 0, 0, out, out_end)) {
+    return 0;
+  }
+  return out - dest;
+}
+
+bool lzDecompress(const char* source, const std::size_t length, char* dest,
+                  const std::size_t expected) {
+  const unsigned char* in = reinterpret_cast<const unsigned char*>(source);
+  const unsigned char* in_end = in + length;
+  char* out = dest;
+  char* out_end = dest + expected;
+  while (in < in_end) {
+    const unsigned char token = *in++;
+    std::size_t literal_length = token >> 4;
+    if (literal_length == 15 && !getLength(literal_length, in, in_end)) {
+      return false;
+    }
+    if (static_cast<std::size_t>(in_end - in) < literal_length ||
+        static_cast<std::size_t>(out_end - out) < literal_length) {
+      return false;
+    }
+    std::memcpy(out, in, literal_length);
+    in += literal_length;
+    out += literal_length;
+    if (in == in_end) {
+      break;
+    }
+
+    if (in_end - in < 2) return false;
+    const std::size_t offset = in[0] | (in[1] << 8);
+    in += 2;
+    std::size_t match_length = token & 0x0F;
+    if (match_length == 15 && !getLength(match_length, in, in_end)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > static_cast<std::size_t>(out - dest) ||
+        static_cast<std::size_t>(out_end - out) < match_length) {
+      return false;
+    }
+    // Byte by byte: the match may overlap the bytes it produces.
+    const char* match = out - offset;
+    for (std::size_t i = 0; i < match_length; ++i) {
+      *out++ = match[i];
+    }
+  }
+  return out == out_end;
+}
+
+}
@@ -0,0 +1,43 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace badgerdb {
+
+/**
+ * Compresses a buffer with a small LZ77 codec in the style of LZ4: the output
+ * is a sequence of (literal run, back reference) pairs with byte-aligned
+ * lengths and 16-bit offsets.  It favours speed over ratio, which suits
+ * slotted pages whose free space between the slot array and the records is
+ * mostly zeros.
+ *
+ * @param source    Bytes to compress.
+ * @param length    Number of bytes.
+ * @param dest      Output buffer.
+ * @param capacity  Size of the output buffer.
+ * @return  Size of the compressed data, or 0 if it does not fit in <capacity>.
+ */
+std::size_t lzCompress(const char* source, const std::size_t length,
+                       char* dest, const std::size_t capacity);
+
+/**
+ * Decompresses data produced by lzCompress().
+ *
+ * @param source    Compressed bytes.
+ * @param length    Number of compressed bytes.
+ * @param dest      Output buffer.
+ * @param expected  Exact size of the decompressed data.
+ * @return  False if the data is malformed or does not decompress to exactly
+ *          <expected> bytes.
+ */
+bool lzDecompress(const char* source, const std::size_t length, char* dest,
+                  const std::size_t expected);
+
+}
@@ -101,6 +101,13 @@ class PageIterator {
 		return page_->getRecord(current_record_); 
 	}
 
+  /**
+   * Returns the ID of the record the iterator is currently pointing to.
+   *
+   * @return  ID of current record.
+   */
+  const RecordId& record_id() const { return current_record_; }
+
   /**
    * Returns the next used slot in the page after the given slot or
    * Page::INVALID_SLOT if no slots are used after the given slot.
@@ -0,0 +1,300 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "recovery.h"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <queue>
+#include <thread>
+
+#include "async_io.h"
+#include "exceptions/invalid_page_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Pins a page to redo into <guard>, leaving it empty if the page has since
+ * been deleted.
+ */
+Task pinForRedo(BufMgr* buf_mgr, File* file, const PageId page_number,
+                PageGuard* guard) {
+  try {
+    *guard = co_await buf_mgr->readPageAsync(file, page_number);
+  } catch (InvalidPageException&) {
+    // Nothing to redo.
+  }
+}
+
+}
+
+struct RecoveryManager::RedoPage {
+  PageKey key;
+  File* file;
+  PageGuard guard;
+  Page* frame;
+  std::vector<Lsn> lsns;
+  bool changed;
+  Lsn first_redone;
+};
+
+RecoveryManager::RecoveryManager(BufMgr* buf_mgr, LogManager* log,
+                                 const FileMap& files,
+                                 const unsigned redo_threads,
+                                 const std::uint32_t pages_per_round,
+                                 const std::uint32_t read_threads)
+    : buf_mgr_(buf_mgr),
+      log_(log),
+      files_(files),
+      redo_threads_(redo_threads == 0 ? 1 : redo_threads),
+      pages_per_round_(pages_per_round == 0 ? 1 : pages_per_round),
+      read_threads_(read_threads == 0 ? 1 : read_threads),
+      redone_(0),
+      undone_(0),
+      losers_(0),
+      max_reads_in_flight_(0) {
+}
+
+void RecoveryManager::recover() {
+  redone_ = undone_ = losers_ = 0;
+  max_reads_in_flight_ = 0;
+  std::map<PageKey, Lsn> dirty_pages;
+  std::map<TxnId, Lsn> losers;
+  analysis(dirty_pages, losers);
+  losers_ = losers.size();
+  redo(dirty_pages);
+  undo(losers);
+
+  std::vector<DirtyPageEntry> dirty;
+  buf_mgr_->getDirtyPages(dirty);
+  log_->logCheckpoint(dirty);
+}
+
+void RecoveryManager::analysis(std::map<PageKey, Lsn>& dirty_pages,
+                               std::map<TxnId, Lsn>& losers) {
+  Lsn lsn = log_->checkpointLsn();
+  LogRecord record;
+  Lsn next;
+  if (lsn == 0) {
+    lsn = LogManager::firstLsn();
+  } else if (log_->readRecord(lsn, record, next) &&
+             record.type == LOG_CHECKPOINT) {
+    std::vector<ActiveTxnEntry> active_txns;
+    std::vector<DirtyPageEntry> checkpoint_pages;
+    LogManager::decodeCheckpoint(record, active_txns, checkpoint_pages);
+    for (std::size_t i = 0; i < active_txns.size(); ++i) {
+      losers[active_txns[i].txn] = active_txns[i].last_lsn;
+    }
+    for (std::size_t i = 0; i < checkpoint_pages.size(); ++i) {
+      // A recovery LSN of 0 means the page was dirtied before logging was
+      // enabled; redo it from the start of the log to be safe.
+      const Lsn rec_lsn = checkpoint_pages[i].rec_lsn == 0
+          ? LogManager::firstLsn() : checkpoint_pages[i].rec_lsn;
+      dirty_pages[PageKey(checkpoint_pages[i].filename,
+                          checkpoint_pages[i].page_number)] = rec_lsn;
+    }
+    lsn = next;
+  }
+
+  while (log_->readRecord(lsn, record, next)) {
+    switch (record.type) {
+      case LOG_UPDATE:
+      case LOG_CLR: {
+        losers[record.txn] = record.lsn;
+        const PageKey key(record.filename, record.page_number);
+        if (dirty_pages.find(key) == dirty_pages.end()) {
+          dirty_pages[key] = record.lsn;
+        }
+        break;
+      }
+      case LOG_COMMIT:
+      case LOG_ABORT:
+        losers.erase(record.txn);
+        break;
+      case LOG_CHECKPOINT:
+        break;
+    }
+    lsn = next;
+  }
+}
+
+void RecoveryManager::redo(const std::map<PageKey, Lsn>& dirty_pages) {
+  if (dirty_pages.empty()) {
+    return;
+  }
+  Lsn lsn = dirty_pages.begin()->second;
+  for (std::map<PageKey, Lsn>::const_iterator iter = dirty_pages.begin();
+       iter != dirty_pages.end(); ++iter) {
+    lsn = std::min(lsn, iter->second);
+  }
+
+  // Only LSNs are collected here; the workers read the records themselves so
+  // the log is read in parallel and the images never pile up in memory.
+  std::map<PageKey, std::vector<Lsn> > records;
+  LogRecord record;
+  Lsn next;
+  while (log_->readRecord(lsn, record, next)) {
+    if (record.type == LOG_UPDATE || record.type == LOG_CLR) {
+      const PageKey key(record.filename, record.page_number);
+      std::map<PageKey, Lsn>::const_iterator dirty = dirty_pages.find(key);
+      if (dirty != dirty_pages.end() && record.lsn >= dirty->second &&
+          findFile(record.filename) != NULL) {
+        records[key].push_back(record.lsn);
+      }
+    }
+    lsn = next;
+  }
+
+  EventLoop loop(read_threads_);
+  std::map<PageKey, std::vector<Lsn> >::iterator iter = records.begin();
+  while (iter != records.end()) {
+    // Prefetch: pin every page of this round, with the reads of the missing
+    // ones in flight at the same time.
+    std::vector<RedoPage> round(
+        std::min<std::size_t>(pages_per_round_,
+                              std::distance(iter, records.end())));
+    for (std::size_t i = 0; i < round.size(); ++i, ++iter) {
+      round[i].key = iter->first;
+      round[i].file = findFile(iter->first.first);
+      round[i].lsns.swap(iter->second);
+      round[i].changed = false;
+      round[i].first_redone = 0;
+      loop.spawn(pinForRedo(buf_mgr_, round[i].file, round[i].key.second,
+                            &round[i].guard));
+    }
+    loop.run();
+    max_reads_in_flight_ = loop.maxInFlight();
+
+    std::vector<std::vector<RedoPage*> > partitions(redo_threads_);
+    std::hash<std::string> hash_name;
+    for (std::size_t i = 0; i < round.size(); ++i) {
+      round[i].frame = round[i].guard.get();
+      if (round[i].frame == NULL) {
+        continue;
+      }
+      const std::size_t partition =
+          (hash_name(round[i].key.first) + round[i].key.second) %
+          redo_threads_;
+      partitions[partition].push_back(&round[i]);
+    }
+
+    std::vector<std::uint64_t> redone(redo_threads_, 0);
+    std::vector<std::exception_ptr> errors(redo_threads_);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < redo_threads_; ++t) {
+      workers.push_back(std::thread([&, t]() {
+        try {
+          redoPartition(partitions[t], redone[t]);
+        } catch (...) {
+          errors[t] = std::current_exception();
+        }
+      }));
+    }
+    for (unsigned t = 0; t < redo_threads_; ++t) {
+      workers[t].join();
+      redone_ += redone[t];
+    }
+
+    for (std::size_t i = 0; i < round.size(); ++i) {
+      // The frame must stay dirty since its oldest redone change, or a crash
+      // after the final checkpoint would skip it.
+      if (round[i].changed) {
+        buf_mgr_->lowerRecLsn(round[i].file, round[i].key.second,
+                              round[i].first_redone);
+        round[i].guard.markDirty();
+      }
+      round[i].guard.release();
+    }
+    for (unsigned t = 0; t < redo_threads_; ++t) {
+      if (errors[t]) {
+        std::rethrow_exception(errors[t]);
+      }
+    }
+  }
+}
+
+void RecoveryManager::redoPartition(const std::vector<RedoPage*>& pages,
+                                    std::uint64_t& redone) {
+  LogRecord record;
+  Lsn next;
+  for (std::size_t i = 0; i < pages.size(); ++i) {
+    RedoPage* page = pages[i];
+    for (std::size_t j = 0; j < page->lsns.size(); ++j) {
+      if (page->frame->page_lsn() >= page->lsns[j]) {
+        // The change already reached the disk before the crash.
+        continue;
+      }
+      if (!log_->readRecord(page->lsns[j], record, next)) {
+        continue;
+      }
+      LogManager::decodePage(record.after, *page->frame);
+      if (!page->changed) {
+        page->first_redone = page->lsns[j];
+      }
+      page->changed = true;
+      ++redone;
+    }
+  }
+}
+
+void RecoveryManager::undo(std::map<TxnId, Lsn>& losers) {
+  // Always undo the newest remaining change of any loser next.
+  std::priority_queue<std::pair<Lsn, TxnId> > to_undo;
+  for (std::map<TxnId, Lsn>::const_iterator iter = losers.begin();
+       iter != losers.end(); ++iter) {
+    if (iter->second != 0) {
+      // Chain the compensation records to what the loser logged before.
+      log_->resume(iter->first, iter->second);
+      to_undo.push(std::make_pair(iter->second, iter->first));
+    } else {
+      log_->abort(iter->first);
+    }
+  }
+
+  LogRecord record;
+  Lsn next;
+  while (!to_undo.empty()) {
+    const Lsn lsn = to_undo.top().first;
+    const TxnId txn = to_undo.top().second;
+    to_undo.pop();
+    if (!log_->readRecord(lsn, record, next)) {
+      continue;
+    }
+    // A compensation record means an earlier undo got this far already.
+    const Lsn undo_next =
+        record.type == LOG_CLR ? record.undo_next_lsn : record.prev_lsn;
+    File* file = findFile(record.filename);
+    if (record.type == LOG_UPDATE && file != NULL) {
+      Page* frame;
+      try {
+        buf_mgr_->readPage(file, record.page_number, frame);
+        LogManager::decodePage(record.before, *frame);
+        log_->logCompensation(txn, file, *frame, undo_next);
+        buf_mgr_->unPinPage(file, record.page_number, true /* dirty */);
+        ++undone_;
+      } catch (InvalidPageException&) {
+      }
+    }
+    if (undo_next != 0) {
+      to_undo.push(std::make_pair(undo_next, txn));
+    } else {
+      log_->abort(txn);
+    }
+  }
+  log_->flushAll();
+}
+
+File* RecoveryManager::findFile(const std::string& filename) const {
+  FileMap::const_iterator iter = files_.find(filename);
+  return iter == files_.end() ? NULL : iter->second;
+}
+
+}
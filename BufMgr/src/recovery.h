@@ -0,0 +1,152 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "log_manager.h"
+
+namespace badgerdb {
+
+/**
+ * @brief ARIES-style restart recovery over the write-ahead log.
+ *
+ * Recovery runs in three passes:
+ *
+ * - Analysis scans the log forward from the latest checkpoint, rebuilding
+ *   the dirty page table (page -> recovery LSN) and the table of transactions
+ *   that never committed or aborted (the losers).
+ * - Redo repeats history from the smallest recovery LSN: every logged update
+ *   whose LSN is newer than the LSN on the page is re-applied.  Redo work is
+ *   partitioned by (file, page number) across worker threads.  Pages are
+ *   processed in rounds; the pages of a round are first pinned (prefetched)
+ *   through an EventLoop, whose I/O threads read the missing pages at the
+ *   same time, and then the workers apply their partitions' records in
+ *   parallel, reading the records from the log themselves.  Since a page
+ *   belongs to exactly one partition, workers never touch the same frame.
+ *   A redone page keeps the LSN of its oldest redone record as recovery LSN,
+ *   so a crash before it is written back redoes it again.
+ * - Undo rolls back the losers, newest change first, by restoring the before
+ *   images.  Each restore is logged as a compensation record (LOG_CLR)
+ *   pointing at the loser's next record to undo.  Redo repeats compensation
+ *   records like updates, and undo skips from a compensation record straight
+ *   to that record, so a crash during undo neither undoes a restore nor rolls
+ *   back an update twice.  An abort record is written once a loser is fully
+ *   rolled back.
+ *
+ * Finally a checkpoint is taken so the next restart does not repeat the work.
+ * Recovery must run before any new transaction uses the log.
+ */
+class RecoveryManager {
+ public:
+  /**
+   * Files recovery may touch, keyed by file name.  Log records for other
+   * files are ignored.
+   */
+  typedef std::map<std::string, File*> FileMap;
+
+  /**
+   * Constructs a recovery manager.
+   *
+   * @param buf_mgr           Buffer manager through which pages are changed.
+   * @param log               Log to recover from; also set on <buf_mgr>.
+   * @param files             Open files keyed by name.
+   * @param redo_threads      Number of redo worker threads.
+   * @param pages_per_round   Number of pages pinned at once during redo; must
+   *                          not exceed the size of the buffer pool.
+   * @param read_threads      Number of page reads in flight at once during
+   *                          redo.
+   */
+  RecoveryManager(BufMgr* buf_mgr, LogManager* log, const FileMap& files,
+                  const unsigned redo_threads = 1,
+                  const std::uint32_t pages_per_round = 64,
+                  const std::uint32_t read_threads = 4);
+
+  /**
+   * Runs analysis, redo and undo.
+   */
+  void recover();
+
+  /**
+   * Returns the number of updates re-applied by redo.
+   */
+  std::uint64_t redoneCount() const { return redone_; }
+
+  /**
+   * Returns the number of updates rolled back by undo.
+   */
+  std::uint64_t undoneCount() const { return undone_; }
+
+  /**
+   * Returns the number of loser transactions found by analysis.
+   */
+  std::uint64_t loserCount() const { return losers_; }
+
+  /**
+   * Returns the largest number of page reads redo had in flight at once.
+   */
+  std::size_t maxReadsInFlight() const { return max_reads_in_flight_; }
+
+ private:
+  /**
+   * A page, identified by file name and page number.
+   */
+  typedef std::pair<std::string, PageId> PageKey;
+
+  /**
+   * Rebuilds the dirty page table and the loser table.
+   */
+  void analysis(std::map<PageKey, Lsn>& dirty_pages,
+                std::map<TxnId, Lsn>& losers);
+
+  /**
+   * Repeats history for the pages in <dirty_pages>.
+   */
+  void redo(const std::map<PageKey, Lsn>& dirty_pages);
+
+  /**
+   * A pinned page of the current redo round with the records to apply.
+   */
+  struct RedoPage;
+
+  /**
+   * Applies, on one worker, the redo records of the pages assigned to it.
+   */
+  void redoPartition(const std::vector<RedoPage*>& pages,
+                     std::uint64_t& redone);
+
+  /**
+   * Rolls back every transaction in <losers>.
+   */
+  void undo(std::map<TxnId, Lsn>& losers);
+
+  /**
+   * Returns the open file with the given name, or NULL.
+   */
+  File* findFile(const std::string& filename) const;
+
+  BufMgr* buf_mgr_;
+  LogManager* log_;
+  FileMap files_;
+  unsigned redo_threads_;
+  std::uint32_t pages_per_round_;
+  std::uint32_t read_threads_;
+  std::uint64_t redone_;
+  std::uint64_t undone_;
+  std::uint64_t losers_;
+  std::size_t max_reads_in_flight_;
+};
+
+}
@@ -0,0 +1,74 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Page replacement policy a BufMgr can use instead of its built-in
+ *        clock (see BufMgr::setReplacementPolicy()).
+ *
+ * The policy only orders frames; BufMgr still decides which frames may be
+ * replaced (unpinned, within the allocating partition and tenant quota) and
+ * does the write-back and unmapping itself.  It tells the policy about every
+ * page that enters or leaves a frame and about every hit.
+ */
+class ReplacementPolicy {
+ public:
+  /**
+   * Returns true if BufMgr may reuse a frame right now.
+   */
+  typedef std::function<bool(FrameId)> Evictable;
+
+  virtual ~ReplacementPolicy() {}
+
+  /**
+   * Forgets all history and starts with <frames> free frames.
+   *
+   * @param frames  Number of frames in the buffer pool.
+   */
+  virtual void reset(const std::uint32_t frames) = 0;
+
+  /**
+   * A page was read or allocated into <frame>.
+   */
+  virtual void pageInstalled(const FrameId frame) = 0;
+
+  /**
+   * A page already in <frame> was pinned again.
+   */
+  virtual void pageAccessed(const FrameId frame) = 0;
+
+  /**
+   * The access hint of the page in <frame> changed.  Pages hinted
+   * HINT_EVICT_SOON should become the preferred victims.  BufMgr itself keeps
+   * HINT_KEEP_HOT pages from being chosen while other frames can be.
+   */
+  virtual void pageHinted(const FrameId frame, const AccessHint hint) = 0;
+
+  /**
+   * The page in <frame> was dropped; the frame is free.
+   */
+  virtual void pageRemoved(const FrameId frame) = 0;
+
+  /**
+   * Chooses the frame to reuse, preferring free frames.
+   *
+   * @param evictable  Tells which frames may be chosen.
+   * @param frame      Receives the chosen frame.
+   * @return  False if no frame may be chosen.
+   */
+  virtual bool pickVictim(const Evictable& evictable, FrameId& frame) = 0;
+};
+
+}
@@ -0,0 +1,190 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "sampled_eviction.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Makes each counter step about ten times less likely than the last.
+ */
+const std::uint32_t LOG_FACTOR = 10;
+
+/**
+ * Rounds of sampling before falling back to a scan of all frames.
+ */
+const int SAMPLE_ROUNDS = 4;
+
+}
+
+SampledEviction::SampledEviction(const Mode mode, const std::uint32_t samples,
+                                 const std::uint32_t pool_size)
+    : mode_(mode),
+      samples_(samples > 0 ? samples : 1),
+      pool_size_(pool_size > 0 ? pool_size : 1),
+      clock_(0),
+      rng_(42),
+      frames_sampled_(0) {
+  reset(0);
+}
+
+void SampledEviction::reset(const std::uint32_t frames) {
+  state_.assign(frames, FrameState());
+  free_.clear();
+  free_index_.assign(frames, 0);
+  for (FrameId frame = 0; frame < frames; ++frame) {
+    state_[frame].free = false;
+    state_[frame].evict_soon = false;
+    pushFree(frame);
+  }
+  pool_.clear();
+  clock_ = 0;
+  frames_sampled_ = 0;
+}
+
+void SampledEviction::pageInstalled(const FrameId frame) {
+  popFree(frame);
+  state_[frame].stamp = ++clock_;
+  state_[frame].count = INITIAL_COUNT;
+  state_[frame].evict_soon = false;
+}
+
+void SampledEviction::pageAccessed(const FrameId frame) {
+  FrameState& state = state_[frame];
+  if (mode_ == LFU) {
+    std::uint32_t count = frequency(frame);
+    if (count < 255) {
+      const std::uint32_t base =
+          count > INITIAL_COUNT ? count - INITIAL_COUNT : 0;
+      if (rng_() % (base * LOG_FACTOR + 1) == 0) {
+        ++count;
+      }
+    }
+    state.count = count;
+  }
+  state.stamp = ++clock_;
+}
+
+void SampledEviction::pageHinted(const FrameId frame, const AccessHint hint) {
+  state_[frame].evict_soon = hint == HINT_EVICT_SOON;
+  // A new stamp makes candidates sampled with the old hint stale.
+  state_[frame].stamp = ++clock_;
+}
+
+void SampledEviction::pageRemoved(const FrameId frame) {
+  pushFree(frame);
+}
+
+bool SampledEviction::pickVictim(const Evictable& evictable, FrameId& frame) {
+  for (std::size_t i = free_.size(); i > 0; --i) {
+    if (evictable(free_[i - 1])) {
+      frame = free_[i - 1];
+      return true;
+    }
+  }
+  const std::uint32_t frames = state_.size();
+  if (frames == 0) {
+    return false;
+  }
+  for (int round = 0; round <= SAMPLE_ROUNDS; ++round) {
+    if (round < SAMPLE_ROUNDS) {
+      for (std::uint32_t i = 0; i < samples_; ++i) {
+        const FrameId sample = rng_() % frames;
+        if (!state_[sample].free && evictable(sample)) {
+          offer(sample);
+        }
+      }
+      frames_sampled_ += samples_;
+    } else {
+      // Nearly everything is pinned; look at every frame once.
+      for (FrameId f = 0; f < frames; ++f) {
+        if (!state_[f].free && evictable(f)) {
+          offer(f);
+        }
+      }
+      frames_sampled_ += frames;
+    }
+    while (!pool_.empty()) {
+      const Candidate best = pool_.back();
+      pool_.pop_back();
+      // Candidates used or reused since they were sampled are stale.
+      if (!state_[best.frame].free && state_[best.frame].stamp == best.stamp &&
+          evictable(best.frame)) {
+        frame = best.frame;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+std::uint32_t SampledEviction::frequency(const FrameId frame) const {
+  const FrameState& state = state_[frame];
+  const std::uint32_t frames = state_.size();
+  const std::uint32_t decay = (clock_ - state.stamp) / frames;
+  return decay < state.count ? state.count - decay : 0;
+}
+
+std::uint64_t SampledEviction::scoreOf(const FrameId frame) const {
+  if (state_[frame].evict_soon) {
+    return ~static_cast<std::uint64_t>(0);
+  }
+  const std::uint64_t idle = clock_ - state_[frame].stamp;
+  if (mode_ == LRU) {
+    return idle;
+  }
+  // Least frequent first, and the longest idle among equally frequent.
+  return (static_cast<std::uint64_t>(255 - frequency(frame)) << 32) | idle;
+}
+
+void SampledEviction::offer(const FrameId frame) {
+  Candidate candidate = {frame, state_[frame].stamp, scoreOf(frame)};
+  for (std::size_t i = 0; i < pool_.size(); ++i) {
+    if (pool_[i].frame == frame) {
+      if (pool_[i].stamp == candidate.stamp) {
+        return;
+      }
+      pool_.erase(pool_.begin() + i);
+      break;
+    }
+  }
+  if (pool_.size() == pool_size_) {
+    if (candidate.score <= pool_.front().score) {
+      return;
+    }
+    pool_.erase(pool_.begin());
+  }
+  std::size_t position = pool_.size();
+  while (position > 0 && pool_[position - 1].score > candidate.score) {
+    --position;
+  }
+  pool_.insert(pool_.begin() + position, candidate);
+}
+
+void SampledEviction::pushFree(const FrameId frame) {
+  if (state_[frame].free) {
+    return;
+  }
+  state_[frame].free = true;
+  free_index_[frame] = free_.size();
+  free_.push_back(frame);
+}
+
+void SampledEviction::popFree(const FrameId frame) {
+  if (!state_[frame].free) {
+    return;
+  }
+  state_[frame].free = false;
+  const FrameId last = free_.back();
+  free_[free_index_[frame]] = last;
+  free_index_[last] = free_index_[frame];
+  free_.pop_back();
+}
+
+}
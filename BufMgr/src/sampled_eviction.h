@@ -0,0 +1,125 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "replacement_policy.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Approximated LRU or LFU by random sampling, for very large pools.
+ *
+ * No list is kept.  A hit only writes the frame's slot of a compact array:
+ * the value of a logical access clock and, in LFU mode, a logarithmic 8-bit
+ * access counter that decays by one for every <frames> accesses of the pool
+ * since the frame was last used.  A hit thus costs a few stores to a single
+ * cache line whatever the pool size.
+ *
+ * To choose a victim, <samples> random frames are examined and the ones that
+ * may be replaced are merged into a small eviction pool sorted by how good a
+ * victim they are: longest idle in LRU mode, lowest counter in LFU mode.  The
+ * best candidate of the pool is taken, unless it was used since it was
+ * sampled.  The pool carries good candidates over to later evictions, which
+ * makes the approximation much closer to the exact order than sampling alone.
+ * Free frames are kept on a separate stack and always taken first, and pages
+ * hinted HINT_EVICT_SOON are the best victims among the sampled ones.
+ */
+class SampledEviction : public ReplacementPolicy {
+ public:
+  enum Mode { LRU, LFU };
+
+  /**
+   * @param mode       Evict the least recently or the least frequently used.
+   * @param samples    Frames sampled per eviction.
+   * @param pool_size  Candidates kept between evictions.
+   */
+  SampledEviction(const Mode mode, const std::uint32_t samples,
+                  const std::uint32_t pool_size);
+
+  void reset(const std::uint32_t frames) override;
+  void pageInstalled(const FrameId frame) override;
+  void pageAccessed(const FrameId frame) override;
+  void pageHinted(const FrameId frame, const AccessHint hint) override;
+  void pageRemoved(const FrameId frame) override;
+  bool pickVictim(const Evictable& evictable, FrameId& frame) override;
+
+  /**
+   * Returns the access counter of <frame> after decay, used in LFU mode.
+   */
+  std::uint32_t frequency(const FrameId frame) const;
+
+  /**
+   * Returns the number of frames examined by all evictions.
+   */
+  std::uint64_t framesSampled() const { return frames_sampled_; }
+
+ private:
+  /**
+   * Initial counter of a new page, so that it is not the first victim.
+   */
+  static constexpr std::uint8_t INITIAL_COUNT = 5;
+
+  /**
+   * State of a frame.
+   */
+  struct FrameState {
+    std::uint32_t stamp;
+    std::uint8_t count;
+    bool free;
+    bool evict_soon;
+  };
+
+  /**
+   * A sampled frame and its stamp at that time.
+   */
+  struct Candidate {
+    FrameId frame;
+    std::uint32_t stamp;
+    std::uint64_t score;
+  };
+
+  /**
+   * Returns how good a victim <frame> is; higher is better.
+   */
+  std::uint64_t scoreOf(const FrameId frame) const;
+
+  /**
+   * Adds a frame to the eviction pool if it beats the worst candidate.
+   */
+  void offer(const FrameId frame);
+
+  void pushFree(const FrameId frame);
+  void popFree(const FrameId frame);
+
+  Mode mode_;
+  std::uint32_t samples_;
+  std::uint32_t pool_size_;
+  std::vector<FrameState> state_;
+  std::uint32_t clock_;
+
+  /**
+   * Eviction pool, best candidate last.
+   */
+  std::vector<Candidate> pool_;
+
+  /**
+   * Free frames, and the index of each free frame in it.
+   */
+  std::vector<FrameId> free_;
+  std::vector<std::uint32_t> free_index_;
+
+  std::minstd_rand rng_;
+  std::uint64_t frames_sampled_;
+};
+
+}
@@ -0,0 +1,657 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "shared_page_cache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "exceptions/file_io_exception.h"
+#include "exceptions/file_not_found_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Written by the creator once the segment is initialized.
+ */
+const std::uint64_t SEGMENT_MAGIC = 0x4244425348415245ULL;  // "BDBSHARE"
+
+std::size_t alignUp(const std::size_t value, const std::size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+}
+
+struct SharedPageCache::Header {
+  std::uint64_t magic;
+  std::uint32_t frames;
+  std::uint32_t hand;
+  std::uint64_t hits;
+  std::uint64_t misses;
+  /**
+   * Slot whose image is being changed, or -1; dropped if its writer dies.
+   */
+  std::int32_t busy;
+  pthread_mutex_t mutex;
+};
+
+struct SharedPageCache::FileEntry {
+  std::uint64_t device;
+  std::uint64_t inode;
+  /**
+   * Number of slots holding pages of the file.
+   */
+  std::uint32_t pages;
+  std::uint8_t in_use;
+  /**
+   * Name the file was opened with, for dirty page tables.
+   */
+  char name[256];
+  /**
+   * Absolute path, for processes that write back pages of a file they have
+   * not opened.
+   */
+  char path[PATH_MAX];
+};
+
+struct SharedPageCache::Slot {
+  Lsn rec_lsn;
+  PageId page_number;
+  std::int32_t file;
+  std::int32_t next;
+  /**
+   * Process reading the page from disk while <loading> is set.
+   */
+  std::int32_t loader;
+  std::uint8_t valid;
+  std::uint8_t refbit;
+  std::uint8_t dirty;
+  std::uint8_t loading;
+};
+
+/**
+ * Holds the mutex of the segment, which waitForLoad() releases for a while.
+ */
+class SharedPageCache::Guard {
+ public:
+  explicit Guard(const SharedPageCache* cache) : cache_(cache), held_(false) {
+    lock();
+  }
+  ~Guard() {
+    if (held_) {
+      cache_->unlock();
+    }
+  }
+  void lock() {
+    cache_->lock();
+    held_ = true;
+  }
+  void unlock() {
+    held_ = false;
+    cache_->unlock();
+  }
+
+ private:
+  const SharedPageCache* cache_;
+  bool held_;
+};
+
+SharedPageCache::SharedPageCache(const std::string& name,
+                                 const std::uint32_t frames)
+    : name_(name),
+      frames_(frames),
+      buckets_(frames + frames / 4 + 1),
+      open_files_(MAX_FILES) {
+  const std::size_t files_offset = alignUp(sizeof(Header), 64);
+  const std::size_t heads_offset =
+      alignUp(files_offset + MAX_FILES * sizeof(FileEntry), 64);
+  const std::size_t slots_offset =
+      alignUp(heads_offset + buckets_ * sizeof(std::int32_t), 64);
+  const std::size_t images_offset =
+      alignUp(slots_offset + frames_ * sizeof(Slot), 4096);
+  size_ = images_offset + static_cast<std::size_t>(frames_) * Page::SIZE;
+
+  bool creator = true;
+  int fd = ::shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0 && errno == EEXIST) {
+    creator = false;
+    fd = ::shm_open(name_.c_str(), O_RDWR, 0);
+  }
+  if (fd < 0) {
+    throw FileIOException(name_, "shm_open", errno);
+  }
+  if (creator) {
+    if (::ftruncate(fd, size_) != 0) {
+      const int error = errno;
+      ::close(fd);
+      ::shm_unlink(name_.c_str());
+      throw FileIOException(name_, "ftruncate", error);
+    }
+  } else {
+    // The creator sizes the segment right after creating it.
+    struct stat info;
+    while (::fstat(fd, &info) == 0 && info.st_size == 0) {
+      ::usleep(1000);
+    }
+    if (static_cast<std::size_t>(info.st_size) != size_) {
+      ::close(fd);
+      throw FileIOException(name_, "attach (size mismatch)", EINVAL);
+    }
+  }
+
+  base_ = ::mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  const int error = errno;
+  ::close(fd);
+  if (base_ == MAP_FAILED) {
+    throw FileIOException(name_, "mmap", error);
+  }
+  unsigned char* bytes = static_cast<unsigned char*>(base_);
+  header_ = reinterpret_cast<Header*>(bytes);
+  files_ = reinterpret_cast<FileEntry*>(bytes + files_offset);
+  heads_ = reinterpret_cast<std::int32_t*>(bytes + heads_offset);
+  slots_ = reinterpret_cast<Slot*>(bytes + slots_offset);
+  images_ = bytes + images_offset;
+
+  if (creator) {
+    // The segment is zero-filled, so all files and slots start out unused.
+    for (std::uint32_t i = 0; i < buckets_; ++i) {
+      heads_[i] = -1;
+    }
+    header_->frames = frames_;
+    header_->hand = 0;
+    header_->busy = -1;
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    // A process dying while holding the mutex must not block all others.
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&header_->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    __atomic_store_n(&header_->magic, SEGMENT_MAGIC, __ATOMIC_RELEASE);
+  } else {
+    while (__atomic_load_n(&header_->magic, __ATOMIC_ACQUIRE) !=
+           SEGMENT_MAGIC) {
+      ::usleep(1000);
+    }
+  }
+}
+
+SharedPageCache::~SharedPageCache() {
+  for (std::size_t i = 0; i < open_files_.size(); ++i) {
+    delete open_files_[i].file;
+  }
+  ::munmap(base_, size_);
+}
+
+void SharedPageCache::remove(const std::string& name) {
+  if (::shm_unlink(name.c_str()) != 0 && errno != ENOENT) {
+    throw FileIOException(name, "shm_unlink", errno);
+  }
+}
+
+bool SharedPageCache::read(const File* file, const PageId page_number,
+                           Page& page) {
+  const FileKey key = keyOf(file);
+  Guard guard(this);
+  const std::int32_t index = indexOf(key, file);
+  while (true) {
+    std::int32_t slot = find(index, page_number);
+    if (slot >= 0 && slots_[slot].loading) {
+      waitForLoad(guard, slot);
+      continue;
+    }
+    if (slot >= 0) {
+      copyOut(slot, page);
+      slots_[slot].refbit = 1;
+      ++header_->hits;
+      return true;
+    }
+    slot = evict();
+    if (slot < 0) {
+      guard.unlock();
+      ::usleep(100);
+      guard.lock();
+      continue;
+    }
+    // Enter the page before reading it, so that no other process reads it
+    // too and stores its image over one written meanwhile.
+    header_->busy = slot;
+    link(slot, index, page_number);
+    slots_[slot].loading = 1;
+    slots_[slot].loader = ::getpid();
+    header_->busy = -1;
+    ++header_->misses;
+    guard.unlock();
+    Page loaded;
+    try {
+      loaded = file->readPage(page_number);
+    } catch (...) {
+      guard.lock();
+      unlink(slot);
+      throw;
+    }
+    guard.lock();
+    header_->busy = slot;
+    copyIn(slot, loaded);
+    slots_[slot].loading = 0;
+    slots_[slot].refbit = 1;
+    header_->busy = -1;
+    page = loaded;
+    return false;
+  }
+}
+
+void SharedPageCache::write(const File* file, const Page& page,
+                            const bool dirty, const Lsn rec_lsn) {
+  const FileKey key = keyOf(file);
+  const PageId page_number = page.page_number();
+  Guard guard(this);
+  const std::int32_t index = indexOf(key, file);
+  std::int32_t slot;
+  while (true) {
+    slot = find(index, page_number);
+    if (slot >= 0 && slots_[slot].loading) {
+      // The image being read is older than this one and is replaced by it
+      // once there.
+      waitForLoad(guard, slot);
+      continue;
+    }
+    if (slot < 0) {
+      slot = evict();
+      if (slot < 0) {
+        guard.unlock();
+        ::usleep(100);
+        guard.lock();
+        continue;
+      }
+      header_->busy = slot;
+      link(slot, index, page_number);
+    }
+    break;
+  }
+  Slot& entry = slots_[slot];
+  header_->busy = slot;
+  copyIn(slot, page);
+  if (!dirty) {
+    entry.dirty = 0;
+    entry.rec_lsn = 0;
+  } else if (!entry.dirty) {
+    entry.dirty = 1;
+    entry.rec_lsn = rec_lsn;
+  }
+  entry.refbit = 1;
+  header_->busy = -1;
+}
+
+bool SharedPageCache::flush(const File* file, const PageId page_number) {
+  const FileKey key = keyOf(file);
+  Guard guard(this);
+  const std::int32_t slot = find(indexOf(key, file), page_number);
+  if (slot < 0 || slots_[slot].loading || !slots_[slot].dirty) {
+    return false;
+  }
+  writeBack(slot);
+  return true;
+}
+
+std::uint32_t SharedPageCache::flushFile(const File* file) {
+  const FileKey key = keyOf(file);
+  Guard guard(this);
+  const std::int32_t index = indexOf(key, file);
+  std::uint32_t written = 0;
+  for (std::uint32_t i = 0; i < frames_; ++i) {
+    const Slot& entry = slots_[i];
+    if (entry.valid && entry.file == index && entry.dirty && !entry.loading) {
+      writeBack(i);
+      ++written;
+    }
+  }
+  return written;
+}
+
+std::uint32_t SharedPageCache::writeBackDirty(const Lsn rec_lsn_limit,
+                                              const std::uint32_t max_pages) {
+  Guard guard(this);
+  std::vector<std::int32_t> candidates;
+  for (std::uint32_t i = 0; i < frames_; ++i) {
+    const Slot& entry = slots_[i];
+    if (entry.valid && entry.dirty && !entry.loading &&
+        entry.rec_lsn < rec_lsn_limit) {
+      candidates.push_back(i);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [this](std::int32_t a, std::int32_t b) {
+              return slots_[a].rec_lsn < slots_[b].rec_lsn;
+            });
+  if (candidates.size() > max_pages) {
+    candidates.resize(max_pages);
+  }
+  for (std::size_t i = 0; i < candidates.size(); ++i) {
+    writeBack(candidates[i]);
+  }
+  return candidates.size();
+}
+
+void SharedPageCache::dirtyPages(std::vector<DirtyPageEntry>& dirty_pages) {
+  Guard guard(this);
+  for (std::uint32_t i = 0; i < frames_; ++i) {
+    const Slot& entry = slots_[i];
+    if (entry.valid && entry.dirty && !entry.loading) {
+      DirtyPageEntry dirty;
+      dirty.filename = files_[entry.file].name;
+      dirty.page_number = entry.page_number;
+      dirty.rec_lsn = entry.rec_lsn;
+      dirty_pages.push_back(dirty);
+    }
+  }
+}
+
+void SharedPageCache::copyDirtyPages(const File* file,
+                                     std::vector<Page>& pages) {
+  const FileKey key = keyOf(file);
+  Guard guard(this);
+  const std::int32_t index = indexOf(key, file);
+  for (std::uint32_t i = 0; i < frames_; ++i) {
+    const Slot& entry = slots_[i];
+    if (entry.valid && entry.file == index && entry.dirty && !entry.loading) {
+      pages.push_back(Page());
+      copyOut(i, pages.back());
+    }
+  }
+}
+
+void SharedPageCache::invalidate(const File* file, const PageId page_number) {
+  const FileKey key = keyOf(file);
+  Guard guard(this);
+  const std::int32_t index = indexOf(key, file);
+  while (true) {
+    const std::int32_t slot = find(index, page_number);
+    if (slot >= 0 && slots_[slot].loading) {
+      waitForLoad(guard, slot);
+      continue;
+    }
+    if (slot >= 0) {
+      unlink(slot);
+    }
+    return;
+  }
+}
+
+void SharedPageCache::invalidateFile(const File* file) {
+  const FileKey key = keyOf(file);
+  Guard guard(this);
+  const std::int32_t index = indexOf(key, file);
+  for (std::uint32_t i = 0; i < frames_; ++i) {
+    while (slots_[i].valid && slots_[i].file == index && slots_[i].loading) {
+      waitForLoad(guard, i);
+    }
+    if (slots_[i].valid && slots_[i].file == index) {
+      unlink(i);
+    }
+  }
+  files_[index].in_use = 0;
+  delete open_files_[index].file;
+  open_files_[index].file = NULL;
+}
+
+std::uint64_t SharedPageCache::hits() const {
+  Guard guard(this);
+  return header_->hits;
+}
+
+std::uint64_t SharedPageCache::misses() const {
+  Guard guard(this);
+  return header_->misses;
+}
+
+SharedPageCache::FileKey SharedPageCache::keyOf(const File* file) const {
+  struct stat info;
+  if (::fstat(file->descriptor(), &info) != 0) {
+    throw FileIOException(file->filename(), "fstat", errno);
+  }
+  FileKey key = {static_cast<std::uint64_t>(info.st_dev),
+                 static_cast<std::uint64_t>(info.st_ino)};
+  return key;
+}
+
+std::int32_t SharedPageCache::indexOf(const FileKey& key, const File* file) {
+  std::int32_t index = -1;
+  std::int32_t unused = -1;
+  for (std::uint32_t i = 0; i < MAX_FILES; ++i) {
+    const FileEntry& entry = files_[i];
+    if (entry.in_use && entry.device == key.device &&
+        entry.inode == key.inode) {
+      index = i;
+      break;
+    }
+    if (unused < 0 && (!entry.in_use || entry.pages == 0)) {
+      unused = i;
+    }
+  }
+  if (index < 0) {
+    if (unused < 0) {
+      throw FileIOException(name_, "enter file (file table full)", ENFILE);
+    }
+    index = unused;
+    FileEntry& entry = files_[index];
+    entry.device = key.device;
+    entry.inode = key.inode;
+    entry.pages = 0;
+    std::snprintf(entry.name, sizeof(entry.name), "%s",
+                  file->filename().c_str());
+    if (::realpath(file->filename().c_str(), entry.path) == NULL) {
+      std::snprintf(entry.path, sizeof(entry.path), "%s", entry.name);
+    }
+    entry.in_use = 1;
+  }
+  // Keep a copy of the caller's File, which shares its stream, so that pages
+  // written back here are seen by its later reads.
+  OpenFile& open = open_files_[index];
+  if (open.file == NULL || open.key.device != key.device ||
+      open.key.inode != key.inode ||
+      open.file->filename() != file->filename()) {
+    delete open.file;
+    open.file = new File(*file);
+    open.key = key;
+  }
+  return index;
+}
+
+File* SharedPageCache::fileAt(const std::int32_t index) {
+  const FileEntry& entry = files_[index];
+  OpenFile& open = open_files_[index];
+  if (open.file != NULL && open.key.device == entry.device &&
+      open.key.inode == entry.inode) {
+    return open.file;
+  }
+  delete open.file;
+  open.file = NULL;
+  try {
+    File* file = new File(File::open(entry.path));
+    const FileKey key = keyOf(file);
+    if (key.device != entry.device || key.inode != entry.inode) {
+      delete file;
+      return NULL;
+    }
+    open.file = file;
+    open.key = key;
+  } catch (FileNotFoundException&) {
+    return NULL;
+  }
+  return open.file;
+}
+
+std::uint32_t SharedPageCache::bucketOf(const std::int32_t index,
+                                        const PageId page_number) const {
+  std::uint64_t hash = static_cast<std::uint64_t>(index) * 0x9E3779B97F4A7C15ULL;
+  hash ^= page_number * 0x165667B19E3779F9ULL;
+  hash ^= hash >> 29;
+  return static_cast<std::uint32_t>(hash % buckets_);
+}
+
+std::int32_t SharedPageCache::find(const std::int32_t index,
+                                   const PageId page_number) const {
+  std::int32_t slot = heads_[bucketOf(index, page_number)];
+  while (slot >= 0) {
+    const Slot& entry = slots_[slot];
+    if (entry.page_number == page_number && entry.file == index) {
+      return slot;
+    }
+    slot = entry.next;
+  }
+  return -1;
+}
+
+void SharedPageCache::link(const std::int32_t slot, const std::int32_t index,
+                           const PageId page_number) {
+  Slot& entry = slots_[slot];
+  entry.file = index;
+  entry.page_number = page_number;
+  entry.dirty = 0;
+  entry.rec_lsn = 0;
+  entry.loading = 0;
+  entry.refbit = 1;
+  const std::uint32_t bucket = bucketOf(index, page_number);
+  entry.next = heads_[bucket];
+  heads_[bucket] = slot;
+  ++files_[index].pages;
+  entry.valid = 1;
+}
+
+void SharedPageCache::unlink(const std::int32_t slot) {
+  Slot& entry = slots_[slot];
+  std::int32_t* link = &heads_[bucketOf(entry.file, entry.page_number)];
+  while (*link >= 0 && *link != slot) {
+    link = &slots_[*link].next;
+  }
+  if (*link == slot) {
+    *link = entry.next;
+  }
+  --files_[entry.file].pages;
+  entry.valid = 0;
+  entry.loading = 0;
+  entry.dirty = 0;
+}
+
+std::int32_t SharedPageCache::evict() {
+  // Two turns of the hand clear every reference bit, so a third only finds
+  // frames being loaded.
+  for (std::uint32_t step = 0; step < 3 * frames_; ++step) {
+    const std::int32_t slot = header_->hand;
+    header_->hand = (header_->hand + 1) % frames_;
+    Slot& entry = slots_[slot];
+    if (!entry.valid) {
+      return slot;
+    }
+    if (entry.loading) {
+      continue;
+    }
+    if (entry.refbit) {
+      entry.refbit = 0;
+      continue;
+    }
+    if (entry.dirty) {
+      writeBack(slot);
+    }
+    unlink(slot);
+    return slot;
+  }
+  return -1;
+}
+
+void SharedPageCache::writeBack(const std::int32_t slot) {
+  Slot& entry = slots_[slot];
+  File* file = fileAt(entry.file);
+  if (file != NULL) {
+    Page page;
+    copyOut(slot, page);
+    file->writePage(page);
+    // Other processes read the file through their own streams.
+    file->stream_->flush();
+  }
+  entry.dirty = 0;
+  entry.rec_lsn = 0;
+}
+
+void SharedPageCache::waitForLoad(Guard& guard, const std::int32_t slot) {
+  const pid_t loader = slots_[slot].loader;
+  if (::kill(loader, 0) != 0 && errno == ESRCH) {
+    unlink(slot);
+    return;
+  }
+  guard.unlock();
+  ::usleep(100);
+  guard.lock();
+}
+
+void SharedPageCache::copyIn(const std::int32_t slot, const Page& page) {
+  unsigned char* image = images_ + static_cast<std::size_t>(slot) * Page::SIZE;
+  std::memcpy(image, &page.header_, sizeof(page.header_));
+  std::memcpy(image + sizeof(page.header_), page.data_.data(),
+              Page::DATA_SIZE);
+}
+
+void SharedPageCache::copyOut(const std::int32_t slot, Page& page) const {
+  const unsigned char* image = images_ + static_cast<std::size_t>(slot) *
+                                             Page::SIZE;
+  std::memcpy(&page.header_, image, sizeof(page.header_));
+  std::memcpy(&page.data_[0], image + sizeof(page.header_), Page::DATA_SIZE);
+}
+
+void SharedPageCache::lock() const {
+  const int result = pthread_mutex_lock(&header_->mutex);
+  if (result == EOWNERDEAD) {
+    repair();
+    pthread_mutex_consistent(&header_->mutex);
+  } else if (result != 0) {
+    throw FileIOException(name_, "pthread_mutex_lock", result);
+  }
+}
+
+void SharedPageCache::unlock() const {
+  pthread_mutex_unlock(&header_->mutex);
+}
+
+void SharedPageCache::repair() const {
+  // The process that died may have been changing the image of one slot, and
+  // linking or unlinking a slot, but the valid flags are set last and cleared
+  // last, so the chains can be rebuilt from them.  Slots it was loading are
+  // dropped by the next process waiting for them.
+  if (header_->busy >= 0) {
+    slots_[header_->busy].valid = 0;
+    header_->busy = -1;
+  }
+  for (std::uint32_t i = 0; i < buckets_; ++i) {
+    heads_[i] = -1;
+  }
+  for (std::uint32_t i = 0; i < MAX_FILES; ++i) {
+    files_[i].pages = 0;
+  }
+  for (std::uint32_t i = 0; i < frames_; ++i) {
+    Slot& entry = slots_[i];
+    if (entry.valid) {
+      const std::uint32_t bucket = bucketOf(entry.file, entry.page_number);
+      entry.next = heads_[bucket];
+      heads_[bucket] = i;
+      ++files_[entry.file].pages;
+    }
+  }
+}
+
+}
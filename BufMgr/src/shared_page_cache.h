@@ -0,0 +1,283 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+#include "file.h"
+#include "log_manager.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Buffer pool in POSIX shared memory that several processes on one
+ *        host use instead of caching pages themselves.
+ *
+ * Everything lives in one shm_open() segment and is addressed by index rather
+ * than by pointer, since every process maps the segment at its own address:
+ * a header with a process-shared robust mutex and the clock hand, a table of
+ * the files the pool holds pages of, the bucket array and chains of the page
+ * table, the frame descriptors and the frames.  Files are identified by their
+ * index in the file table, which records the device and inode, the name and
+ * the absolute path of each file, instead of by a File*, which is only
+ * meaningful inside one process.
+ *
+ * A BufMgr using the pool (see BufMgr::setSharedCache()) keeps a private copy
+ * of a page only while it has the page pinned, since a Page holds its bytes
+ * in a std::string that cannot point into the segment.  All unpinned pages,
+ * clean or dirty, are in the pool only, so each is cached once for all
+ * processes.  A page missing from the pool is read from disk by exactly one
+ * process: its frame is entered in the page table as loading before the read,
+ * and others needing the page wait until it is there instead of reading an
+ * image that may be older than a dirty one stored meanwhile.
+ *
+ * A dirty frame is written back by whichever process replaces or flushes it,
+ * through that process's own File for the file or, if it has none, one it
+ * opens by path.  Write-backs go directly to the file, not through a double-
+ * write buffer.  The pool does not serialize changes to a page: two processes
+ * must not have the same page pinned for writing at the same time.
+ *
+ * Because inode numbers are reused, a file must be dropped with
+ * invalidateFile(), which also closes the pool's copy of its File, before it
+ * is removed.  Dirty pages still in the pool when the last process detaches
+ * are lost, so each process flushes its files first.
+ */
+class SharedPageCache {
+ public:
+  /**
+   * Maximum number of files the pool holds pages of at the same time.
+   */
+  static const std::uint32_t MAX_FILES = 64;
+
+  /**
+   * Attaches to the shared segment <name>, creating and initializing it if
+   * it does not exist.
+   *
+   * @param name    Name of the segment, starting with '/'.
+   * @param frames  Number of pages the pool holds; must be the same in every
+   *                process attaching to the segment.
+   * @throws  FileIOException  If the segment cannot be created or mapped, or
+   *                           exists with a different size.
+   */
+  SharedPageCache(const std::string& name, const std::uint32_t frames);
+
+  /**
+   * Detaches from the segment and closes the files opened for write-backs.
+   * The segment and the pages in it stay until remove().
+   */
+  ~SharedPageCache();
+
+  /**
+   * Removes the segment <name>.  Processes attached to it keep using it.
+   *
+   * @param name    Name of the segment.
+   */
+  static void remove(const std::string& name);
+
+  /**
+   * Copies a page into <page>, first reading it from <file> into a frame of
+   * the pool if it is not there.  A dirty frame replaced for it is written
+   * back.
+   *
+   * @param file        File of the page.
+   * @param page_number Number of the page.
+   * @param page        Receives the page.
+   * @return  True if the page was already in the pool.
+   * @throws  FileIOException  If the file table is full.
+   */
+  bool read(const File* file, const PageId page_number, Page& page);
+
+  /**
+   * Stores the current image of a page, replacing the one in the pool.
+   *
+   * @param file    File of the page.
+   * @param page    The page.
+   * @param dirty   True if the image is newer than the file; false if it was
+   *                just written to the file, which makes the frame clean.
+   * @param rec_lsn Recovery LSN of a dirty image; kept if the frame already
+   *                was dirty.
+   */
+  void write(const File* file, const Page& page, const bool dirty,
+             const Lsn rec_lsn = 0);
+
+  /**
+   * Writes back a page if it is in the pool and dirty.
+   *
+   * @param file        File of the page.
+   * @param page_number Number of the page.
+   * @return  True if the page was written.
+   */
+  bool flush(const File* file, const PageId page_number);
+
+  /**
+   * Writes back every dirty page of a file.  The caller syncs the file.
+   *
+   * @param file  File whose pages are written.
+   * @return  Number of pages written.
+   */
+  std::uint32_t flushFile(const File* file);
+
+  /**
+   * Writes back at most <max_pages> dirty pages whose recovery LSN is below
+   * <rec_lsn_limit>, oldest first.
+   *
+   * @return  Number of pages written.
+   */
+  std::uint32_t writeBackDirty(const Lsn rec_lsn_limit,
+                               const std::uint32_t max_pages);
+
+  /**
+   * Appends an entry for every dirty page in the pool to <dirty_pages>.
+   */
+  void dirtyPages(std::vector<DirtyPageEntry>& dirty_pages);
+
+  /**
+   * Appends a copy of every dirty page of <file> in the pool to <pages>.
+   */
+  void copyDirtyPages(const File* file, std::vector<Page>& pages);
+
+  /**
+   * Drops a page from the pool without writing it back.
+   *
+   * @param file        File of the page.
+   * @param page_number Number of the page.
+   */
+  void invalidate(const File* file, const PageId page_number);
+
+  /**
+   * Drops every page of a file from the pool without writing it back and
+   * closes the pool's copy of the File in this process.
+   *
+   * @param file  File whose pages are dropped.
+   */
+  void invalidateFile(const File* file);
+
+  /**
+   * Returns the number of read() calls of all processes that found the page.
+   */
+  std::uint64_t hits() const;
+
+  /**
+   * Returns the number of read() calls of all processes that read the page
+   * from disk.
+   */
+  std::uint64_t misses() const;
+
+  /**
+   * Returns the number of frames.
+   */
+  std::uint32_t frames() const { return frames_; }
+
+ private:
+  struct Header;
+  struct FileEntry;
+  struct Slot;
+  class Guard;
+
+  /**
+   * Identity of a file that is the same in every process.
+   */
+  struct FileKey {
+    std::uint64_t device;
+    std::uint64_t inode;
+  };
+
+  /**
+   * File this process writes back the pages of one file table entry with.
+   */
+  struct OpenFile {
+    FileKey key;
+    File* file;
+  };
+
+  FileKey keyOf(const File* file) const;
+
+  /**
+   * Returns the file table index of <file>, entering it if needed.  Must be
+   * called with the mutex held.
+   */
+  std::int32_t indexOf(const FileKey& key, const File* file);
+
+  /**
+   * Returns the File to write back pages of file table entry <index> with,
+   * or NULL if the file no longer exists.  Must be called with the mutex
+   * held.
+   */
+  File* fileAt(const std::int32_t index);
+
+  std::uint32_t bucketOf(const std::int32_t index,
+                         const PageId page_number) const;
+
+  /**
+   * Returns the slot holding a page, or -1.  Must be called with the mutex
+   * held.
+   */
+  std::int32_t find(const std::int32_t index, const PageId page_number) const;
+
+  /**
+   * Enters <slot> in the page table for a page.  Must be called with the
+   * mutex held.
+   */
+  void link(const std::int32_t slot, const std::int32_t index,
+            const PageId page_number);
+
+  /**
+   * Removes <slot> from the page table.  Must be called with the mutex held.
+   */
+  void unlink(const std::int32_t slot);
+
+  /**
+   * Picks a slot to reuse with the clock algorithm, writes it back if it is
+   * dirty and unlinks it.  Returns -1 if every frame is being loaded.  Must
+   * be called with the mutex held.
+   */
+  std::int32_t evict();
+
+  /**
+   * Writes back the dirty page in <slot>.  Must be called with the mutex
+   * held.
+   */
+  void writeBack(const std::int32_t slot);
+
+  /**
+   * Lets the process loading <slot> finish, or drops the slot if that process
+   * died.  Releases the mutex while waiting.
+   */
+  void waitForLoad(Guard& guard, const std::int32_t slot);
+
+  void copyIn(const std::int32_t slot, const Page& page);
+  void copyOut(const std::int32_t slot, Page& page) const;
+
+  void lock() const;
+  void unlock() const;
+
+  /**
+   * Rebuilds the page table after a process died holding the mutex.
+   */
+  void repair() const;
+
+  std::string name_;
+  std::uint32_t frames_;
+  std::uint32_t buckets_;
+  std::size_t size_;
+  void* base_;
+  Header* header_;
+  FileEntry* files_;
+  std::int32_t* heads_;
+  Slot* slots_;
+  unsigned char* images_;
+  std::vector<OpenFile> open_files_;
+};
+
+}
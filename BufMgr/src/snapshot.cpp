@@ -0,0 +1,133 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "snapshot.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+#include "exceptions/file_io_exception.h"
+#include "exceptions/invalid_page_exception.h"
+#include "log_manager.h"
+
+namespace badgerdb {
+
+namespace {
+
+const std::size_t IMAGE_SIZE = sizeof(PageHeader) + Page::DATA_SIZE;
+
+}
+
+Snapshot::Snapshot(BufMgr* buf_mgr, File* file, const std::string& store_name)
+    : file_(file),
+      store_name_(store_name),
+      fd_(-1),
+      store_end_(0) {
+  fd_ = ::open(store_name_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    throw FileIOException(store_name_, "open", errno);
+  }
+  header_ = file_->readHeader();
+
+  // Dirty frames are newer than the disk; their next page pointers, which only
+  // File changes, are taken from the disk.
+  std::vector<Page> dirty;
+  buf_mgr->copyDirtyPages(file_, dirty);
+  for (std::size_t i = 0; i < dirty.size(); ++i) {
+    const PageId page_number = dirty[i].page_number();
+    dirty[i].set_next_page_number(
+        file_->readPageHeader(page_number).next_page_number);
+    store(page_number, dirty[i]);
+  }
+  File::open_states_[file_->filename()].snapshots.push_back(this);
+}
+
+Snapshot::~Snapshot() {
+  File::StateMap::iterator state =
+      File::open_states_.find(file_->filename());
+  if (state != File::open_states_.end()) {
+    std::vector<Snapshot*>& snapshots = state->second.snapshots;
+    for (std::size_t i = 0; i < snapshots.size(); ++i) {
+      if (snapshots[i] == this) {
+        snapshots.erase(snapshots.begin() + i);
+        break;
+      }
+    }
+  }
+  ::close(fd_);
+  std::remove(store_name_.c_str());
+}
+
+Page Snapshot::readPage(const PageId page_number) const {
+  if (page_number == Page::INVALID_NUMBER ||
+      page_number >= header_.num_pages) {
+    throw InvalidPageException(page_number, file_->filename());
+  }
+  Page page = image(page_number);
+  if (page.page_number() == Page::INVALID_NUMBER) {
+    throw InvalidPageException(page_number, file_->filename());
+  }
+  return page;
+}
+
+void Snapshot::copyTo(const std::string& filename) const {
+  File copy = File::create(filename);
+  for (PageId page_number = 1; page_number < header_.num_pages;
+       ++page_number) {
+    copy.writePage(page_number, image(page_number));
+  }
+  copy.writeHeader(header_);
+}
+
+void Snapshot::beforeWrite(const PageId page_number) {
+  if (page_number >= header_.num_pages ||
+      offsets_.find(page_number) != offsets_.end()) {
+    return;
+  }
+  store(page_number, file_->readPage(page_number, true /* allow_free */));
+}
+
+void Snapshot::store(const PageId page_number, const Page& page) {
+  const std::string image = LogManager::encodePage(page);
+  std::size_t done = 0;
+  while (done < image.size()) {
+    const ssize_t n = ::pwrite(fd_, image.data() + done, image.size() - done,
+                               store_end_ + done);
+    if (n < 0) {
+      throw FileIOException(store_name_, "pwrite", errno);
+    }
+    done += n;
+  }
+  offsets_[page_number] = store_end_;
+  store_end_ += image.size();
+}
+
+Page Snapshot::image(const PageId page_number) const {
+  std::map<PageId, off_t>::const_iterator found = offsets_.find(page_number);
+  if (found == offsets_.end()) {
+    // Not overwritten since the snapshot was taken.
+    return file_->readPage(page_number, true /* allow_free */);
+  }
+  std::string image(IMAGE_SIZE, '\0');
+  std::size_t done = 0;
+  while (done < image.size()) {
+    const ssize_t n = ::pread(fd_, &image[done], image.size() - done,
+                              found->second + done);
+    if (n <= 0) {
+      throw FileIOException(store_name_, "pread", n < 0 ? errno : EIO);
+    }
+    done += n;
+  }
+  Page page;
+  LogManager::decodePage(image, page);
+  return page;
+}
+
+}
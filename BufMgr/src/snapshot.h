@@ -0,0 +1,114 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Point-in-time image of a file, kept with copy-on-write while the
+ *        file continues to be updated.
+ *
+ * Creating a snapshot records the file header and copies the pages that are
+ * dirty in the buffer pool, since their disk versions are already out of
+ * date.  Every other page is read from the file itself until something is
+ * about to overwrite it: File then hands the page to the snapshot first, which
+ * preserves the disk version (the pre-image) in a side file.  Writers never
+ * wait for the snapshot beyond that one extra read and append per page, and
+ * only for the first write of each page.
+ *
+ * Typical use is an online backup: create a snapshot, copyTo() a backup file,
+ * destroy the snapshot.  Snapshots of several files are only consistent with
+ * each other if they are created without updates in between.
+ *
+ * @warning This class is not threadsafe.
+ */
+class Snapshot {
+ public:
+  /**
+   * Starts a snapshot of a file.
+   *
+   * @param buf_mgr       Buffer manager caching pages of the file.
+   * @param file          File to take the snapshot of.
+   * @param store_name    Name of the side file receiving pre-images; it is
+   *                      removed when the snapshot is destroyed.
+   * @throws  FileIOException   If the side file cannot be created.
+   */
+  Snapshot(BufMgr* buf_mgr, File* file, const std::string& store_name);
+
+  /**
+   * Ends the snapshot and removes its side file.
+   */
+  ~Snapshot();
+
+  /**
+   * Reads a page as it was when the snapshot was taken.
+   *
+   * @param page_number   Number of page to read.
+   * @return  The page.
+   * @throws  InvalidPageException  If the page did not exist or was not used
+   *                                at that time.
+   */
+  Page readPage(const PageId page_number) const;
+
+  /**
+   * Writes the image of the file as it was when the snapshot was taken into a
+   * new file, which can then be opened as a regular File.
+   *
+   * @param filename  Name of the file to create.
+   * @throws  FileExistsException   If the file already exists.
+   */
+  void copyTo(const std::string& filename) const;
+
+  /**
+   * Returns the number of pre-images preserved so far.
+   */
+  std::uint64_t pagesPreserved() const { return offsets_.size(); }
+
+ private:
+  /**
+   * Called by File before it overwrites a page of the file.
+   */
+  void beforeWrite(const PageId page_number);
+
+  /**
+   * Appends a page image to the side file.
+   */
+  void store(const PageId page_number, const Page& page);
+
+  /**
+   * Returns the page image at snapshot time, whether used or not.
+   */
+  Page image(const PageId page_number) const;
+
+  File* file_;
+  std::string store_name_;
+  int fd_;
+
+  /**
+   * File header at snapshot time.
+   */
+  FileHeader header_;
+
+  /**
+   * Offset of every preserved page in the side file.
+   */
+  std::map<PageId, off_t> offsets_;
+  off_t store_end_;
+
+  friend class File;
+};
+
+}
@@ -0,0 +1,118 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "tiny_lfu.h"
+
+#include <string>
+
+namespace badgerdb {
+
+namespace {
+
+std::uint64_t mix(std::uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xBF58476D1CE4E5B9ULL;
+  x ^= x >> 27;
+  x *= 0x94D049BB133111EBULL;
+  x ^= x >> 31;
+  return x;
+}
+
+/**
+ * FNV-1a hash of a file name.  Keying on the name rather than the address of
+ * the File object makes the estimates the same in every run.
+ */
+std::uint64_t hashName(const std::string& name) {
+  std::uint64_t hash = 0xCBF29CE484222325ULL;
+  for (std::size_t i = 0; i < name.length(); ++i) {
+    hash = (hash ^ static_cast<unsigned char>(name[i])) * 0x100000001B3ULL;
+  }
+  return hash;
+}
+
+}
+
+TinyLfu::TinyLfu(const std::uint32_t frames)
+    : width_(16),
+      sample_size_(10 * static_cast<std::uint64_t>(frames > 0 ? frames : 1)),
+      additions_(0),
+      window_frames_(frames / 100 > 0 ? frames / 100 : 1),
+      admissions_(0),
+      rejections_(0),
+      resets_(0) {
+  while (width_ < 4 * static_cast<std::uint64_t>(frames)) {
+    width_ *= 2;
+  }
+  table_.assign(DEPTH * width_ / 16, 0);
+}
+
+void TinyLfu::recordAccess(const File* file, const PageId page_number) {
+  const std::uint64_t hash = hashOf(file, page_number);
+  bool added = false;
+  for (int row = 0; row < DEPTH; ++row) {
+    const std::uint64_t counter = counterOf(hash, row);
+    std::uint64_t& word = table_[counter / 16];
+    const int shift = (counter % 16) * 4;
+    if (((word >> shift) & 0xF) != 0xF) {
+      word += 1ULL << shift;
+      added = true;
+    }
+  }
+  if (added && ++additions_ == sample_size_) {
+    halve();
+  }
+}
+
+std::uint32_t TinyLfu::estimate(const File* file,
+                                const PageId page_number) const {
+  const std::uint64_t hash = hashOf(file, page_number);
+  std::uint32_t frequency = 0xF;
+  for (int row = 0; row < DEPTH; ++row) {
+    const std::uint64_t counter = counterOf(hash, row);
+    const std::uint32_t value =
+        (table_[counter / 16] >> ((counter % 16) * 4)) & 0xF;
+    if (value < frequency) {
+      frequency = value;
+    }
+  }
+  return frequency;
+}
+
+bool TinyLfu::admit(const File* candidate_file, const PageId candidate_page,
+                    const File* victim_file, const PageId victim_page) {
+  if (estimate(candidate_file, candidate_page) >
+      estimate(victim_file, victim_page)) {
+    ++admissions_;
+    return true;
+  }
+  ++rejections_;
+  return false;
+}
+
+std::uint64_t TinyLfu::hashOf(const File* file,
+                              const PageId page_number) const {
+  const std::uint64_t file_hash =
+      file == NULL ? 0 : hashName(file->filename());
+  return mix(file_hash ^ mix(page_number + 0x9E3779B97F4A7C15ULL));
+}
+
+std::uint64_t TinyLfu::counterOf(const std::uint64_t hash,
+                                 const int row) const {
+  // Double hashing: row r probes h1 + r * h2, with h2 odd.
+  const std::uint64_t step = (hash >> 32) | 1;
+  return row * width_ + ((hash + row * step) & (width_ - 1));
+}
+
+void TinyLfu::halve() {
+  for (std::size_t i = 0; i < table_.size(); ++i) {
+    table_[i] = (table_[i] >> 1) & 0x7777777777777777ULL;
+  }
+  additions_ /= 2;
+  ++resets_;
+}
+
+}
@@ -0,0 +1,106 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "file.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Frequency-based admission filter for the buffer pool (TinyLFU).
+ *
+ * The access frequency of every page is estimated with a count-min sketch of
+ * four rows of 4-bit counters, four counters per frame and row or eight bytes
+ * per frame of the pool.  After ten accesses per frame all counters are
+ * halved, so the estimates follow the recent workload and old popularity
+ * fades.
+ *
+ * BufMgr uses the filter as in W-TinyLFU (see BufMgr::setAdmissionFilter()).
+ * A missed page always gets a frame, since the caller pins it, but it enters
+ * a small LRU window of about 1% of the frames.  The page leaving the window
+ * is admitted into the main part of the pool only if it is estimated to be
+ * more frequent than the victim chosen there by the replacement policy, so
+ * one-hit wonders replace each other in the window instead of replacing
+ * frequent pages.
+ */
+class TinyLfu {
+ public:
+  /**
+   * @param frames  Number of frames of the buffer pool the filter is for.
+   */
+  explicit TinyLfu(const std::uint32_t frames);
+
+  /**
+   * Counts an access to a page.
+   */
+  void recordAccess(const File* file, const PageId page_number);
+
+  /**
+   * Returns the estimated number of recent accesses to a page, at most 15.
+   */
+  std::uint32_t estimate(const File* file, const PageId page_number) const;
+
+  /**
+   * Decides whether a page leaving the window replaces the victim.
+   *
+   * @return  True if the candidate is estimated to be more frequent.
+   */
+  bool admit(const File* candidate_file, const PageId candidate_page,
+             const File* victim_file, const PageId victim_page);
+
+  /**
+   * Returns the number of frames of the window.
+   */
+  std::uint32_t windowFrames() const { return window_frames_; }
+
+  /**
+   * Returns the number of admit() calls that returned true.
+   */
+  std::uint64_t admissions() const { return admissions_; }
+
+  /**
+   * Returns the number of admit() calls that returned false.
+   */
+  std::uint64_t rejections() const { return rejections_; }
+
+  /**
+   * Returns the number of times the counters were halved.
+   */
+  std::uint64_t resets() const { return resets_; }
+
+ private:
+  static const int DEPTH = 4;
+
+  std::uint64_t hashOf(const File* file, const PageId page_number) const;
+
+  /**
+   * Returns the position of the counter of <hash> in row <row>.
+   */
+  std::uint64_t counterOf(const std::uint64_t hash, const int row) const;
+
+  void halve();
+
+  /**
+   * Counters, sixteen per word; row r occupies counters [r * width_,
+   * (r + 1) * width_).
+   */
+  std::vector<std::uint64_t> table_;
+  std::uint64_t width_;
+  std::uint64_t sample_size_;
+  std::uint64_t additions_;
+  std::uint32_t window_frames_;
+  std::uint64_t admissions_;
+  std::uint64_t rejections_;
+  std::uint64_t resets_;
+};
+
+}
@@ -0,0 +1,136 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "top_k.h"
+
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+#include "file_iterator.h"
+#include "page_iterator.h"
+
+namespace badgerdb {
+
+namespace {
+
+struct ScoreGreater {
+  bool operator()(const ScoredRecord& lhs, const ScoredRecord& rhs) const {
+    return lhs.score > rhs.score;
+  }
+};
+
+}
+
+TopKScan::TopKScan(BufMgr* buf_mgr, File* file, const ValueExtractor& value,
+                   const std::size_t k, const ZoneMap* zone_map)
+    : buf_mgr_(buf_mgr),
+      file_(file),
+      value_(value),
+      k_(k),
+      zone_map_(zone_map),
+      pages_read_(0),
+      pages_skipped_(0) {
+}
+
+void TopKScan::execute(std::vector<ScoredRecord>& results) {
+  pages_read_ = pages_skipped_ = 0;
+  if (k_ == 0) {
+    return;
+  }
+
+  // Visit pages with the most promising zones first.  Pages the zone map does
+  // not know about may hold anything, so they go to the front.
+  std::vector<std::pair<double, PageId> > order;
+  std::vector<std::pair<double, PageId> > zoned;
+  for (FileIterator iter = file_->begin(); iter != file_->end(); ++iter) {
+    Zone zone;
+    if (zone_map_ != NULL && zone_map_->lookup(iter.page_number(), zone)) {
+      if (zone.count > 0) {
+        zoned.push_back(std::make_pair(zone.max, iter.page_number()));
+      }
+    } else {
+      order.push_back(std::make_pair(0.0, iter.page_number()));
+    }
+  }
+  const std::size_t unknown = order.size();
+  std::stable_sort(zoned.begin(), zoned.end(),
+                   [](const std::pair<double, PageId>& lhs,
+                      const std::pair<double, PageId>& rhs) {
+                     return lhs.first > rhs.first;
+                   });
+  order.insert(order.end(), zoned.begin(), zoned.end());
+
+  std::priority_queue<ScoredRecord, std::vector<ScoredRecord>, ScoreGreater>
+      heap;
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    if (i >= unknown && heap.size() == k_ &&
+        order[i].first <= heap.top().score) {
+      // Zones are sorted, so none of the remaining pages can beat the cutoff.
+      pages_skipped_ += order.size() - i;
+      break;
+    }
+    Page* page;
+    const PageId page_number = order[i].second;
+    buf_mgr_->readPage(file_, page_number, page);
+    ++pages_read_;
+    for (PageIterator iter = page->begin(); iter != page->end(); ++iter) {
+      const std::string record = *iter;
+      const double score = value_(record);
+      if (heap.size() < k_) {
+        ScoredRecord scored = {score, iter.record_id(), record};
+        heap.push(scored);
+      } else if (score > heap.top().score) {
+        heap.pop();
+        ScoredRecord scored = {score, iter.record_id(), record};
+        heap.push(scored);
+      }
+    }
+    buf_mgr_->unPinPage(file_, page_number, false /* dirty */);
+  }
+
+  const std::size_t first = results.size();
+  while (!heap.empty()) {
+    results.push_back(heap.top());
+    heap.pop();
+  }
+  std::reverse(results.begin() + first, results.end());
+}
+
+LimitScan::LimitScan(BufMgr* buf_mgr, File* file, const std::size_t limit,
+                     const Predicate& predicate)
+    : buf_mgr_(buf_mgr),
+      file_(file),
+      limit_(limit),
+      predicate_(predicate),
+      pages_read_(0) {
+}
+
+void LimitScan::execute(std::vector<std::string>& results) {
+  pages_read_ = 0;
+  std::size_t found = 0;
+  for (FileIterator iter = file_->begin();
+       found < limit_ && iter != file_->end();
+       ++iter) {
+    Page* page;
+    const PageId page_number = iter.page_number();
+    buf_mgr_->readPage(file_, page_number, page);
+    ++pages_read_;
+    for (PageIterator record_iter = page->begin();
+         found < limit_ && record_iter != page->end();
+         ++record_iter) {
+      const std::string record = *record_iter;
+      if (!predicate_ || predicate_(record)) {
+        results.push_back(record);
+        ++found;
+      }
+    }
+    buf_mgr_->unPinPage(file_, page_number, false /* dirty */);
+  }
+}
+
+}
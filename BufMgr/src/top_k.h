@@ -0,0 +1,142 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "zone_map.h"
+
+namespace badgerdb {
+
+/**
+ * @brief A record together with the value it was ranked by.
+ */
+struct ScoredRecord {
+  /**
+   * Value extracted from the record.
+   */
+  double score;
+
+  /**
+   * ID of the record in its file.
+   */
+  RecordId record_id;
+
+  /**
+   * Copy of the record.
+   */
+  std::string record;
+};
+
+/**
+ * @brief Returns the K records of a heap file with the largest value of a
+ *        field, without sorting the whole file.
+ *
+ * A min-heap holds the best K records seen so far; once it is full its top is
+ * the cutoff a record has to beat.  When a ZoneMap over the same field is
+ * supplied, pages are visited in decreasing order of their zone maximum and a
+ * page whose maximum does not exceed the cutoff is skipped without being
+ * pinned.  Because of that order the scan stops at the first such page.
+ */
+class TopKScan {
+ public:
+  /**
+   * Extracts the ranking value of a record.
+   */
+  typedef std::function<double(const std::string&)> ValueExtractor;
+
+  /**
+   * Constructs a top-K scan.
+   *
+   * @param buf_mgr   Buffer manager used to read the pages.
+   * @param file      Heap file to scan.
+   * @param value     Extracts the ranking value of a record.
+   * @param k         Number of records to return.
+   * @param zone_map  Optional zone map over the same field, or NULL.
+   */
+  TopKScan(BufMgr* buf_mgr, File* file, const ValueExtractor& value,
+           const std::size_t k, const ZoneMap* zone_map = NULL);
+
+  /**
+   * Runs the scan.  <results> receives at most K records in decreasing order
+   * of their value.
+   *
+   * @param results   Vector receiving the output rows.
+   */
+  void execute(std::vector<ScoredRecord>& results);
+
+  /**
+   * Returns the number of pages read by the last execute().
+   */
+  std::size_t pagesRead() const { return pages_read_; }
+
+  /**
+   * Returns the number of pages pruned through the zone map by the last
+   * execute().
+   */
+  std::size_t pagesSkipped() const { return pages_skipped_; }
+
+ private:
+  BufMgr* buf_mgr_;
+  File* file_;
+  ValueExtractor value_;
+  std::size_t k_;
+  const ZoneMap* zone_map_;
+  std::size_t pages_read_;
+  std::size_t pages_skipped_;
+};
+
+/**
+ * @brief Returns the first N records of a heap file, optionally filtered by a
+ *        predicate, and stops pinning pages as soon as N records were found.
+ */
+class LimitScan {
+ public:
+  /**
+   * Decides whether a record qualifies.
+   */
+  typedef std::function<bool(const std::string&)> Predicate;
+
+  /**
+   * Constructs a limit scan.
+   *
+   * @param buf_mgr     Buffer manager used to read the pages.
+   * @param file        Heap file to scan.
+   * @param limit       Maximum number of records to return.
+   * @param predicate   Optional filter applied before counting records.
+   */
+  LimitScan(BufMgr* buf_mgr, File* file, const std::size_t limit,
+            const Predicate& predicate = Predicate());
+
+  /**
+   * Runs the scan, appending at most <limit> records in file order to
+   * <results>.
+   *
+   * @param results   Vector receiving the qualifying records.
+   */
+  void execute(std::vector<std::string>& results);
+
+  /**
+   * Returns the number of pages read by the last execute().
+   */
+  std::size_t pagesRead() const { return pages_read_; }
+
+ private:
+  BufMgr* buf_mgr_;
+  File* file_;
+  std::size_t limit_;
+  Predicate predicate_;
+  std::size_t pages_read_;
+};
+
+}
@@ -24,6 +24,45 @@ typedef std::uint16_t SlotId;
  */
 typedef std::uint32_t FrameId;
 
+/**
+ * @brief Log sequence number: byte offset of a record in the write-ahead log.
+ */
+typedef std::uint64_t Lsn;
+
+/**
+ * @brief Identifier for a transaction.
+ */
+typedef std::uint64_t TxnId;
+
+/**
+ * @brief Identifier for a tenant of the buffer pool.
+ */
+typedef std::uint32_t TenantId;
+
+/**
+ * @brief What a caller knows about the future use of a page it pins or
+ *        unpins, passed to BufMgr to steer page replacement.
+ */
+enum AccessHint {
+  /**
+   * The page is valuable, e.g. an index root or a catalog page.  It is only
+   * replaced when no page without this hint can be.
+   */
+  HINT_KEEP_HOT,
+
+  /**
+   * Nothing special is known.  Pinning a page with this hint cancels an
+   * earlier HINT_EVICT_SOON, since the page turned out to be used again.
+   */
+  HINT_NORMAL,
+
+  /**
+   * The page will not be needed again soon, e.g. bulk-load output.  It is
+   * replaced before pages that were not hinted.
+   */
+  HINT_EVICT_SOON
+};
+
 /**
  * @brief Identifier for a record in a page.
  */
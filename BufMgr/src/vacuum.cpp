@@ -0,0 +1,141 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "vacuum.h"
+
+#include <string>
+#include <utility>
+
+#include "exceptions/invalid_page_exception.h"
+#include "file_iterator.h"
+#include "page_iterator.h"
+
+namespace badgerdb {
+
+Vacuum::Vacuum(BufMgr* buf_mgr, File* file, const double max_fill,
+               const std::uint32_t pages_per_step, const RelocationHook& hook)
+    : buf_mgr_(buf_mgr),
+      file_(file),
+      max_fill_(max_fill),
+      pages_per_step_(pages_per_step == 0 ? 1 : pages_per_step),
+      hook_(hook),
+      started_(false),
+      next_target_(0),
+      end_source_(0),
+      records_moved_(0),
+      pages_freed_(0) {
+}
+
+void Vacuum::findCandidates() {
+  const std::size_t limit =
+      static_cast<std::size_t>(max_fill_ * Page::DATA_SIZE);
+  for (FileIterator iter = file_->begin(); iter != file_->end(); ++iter) {
+    // Free space is read through the buffer manager, whose copy of the page
+    // may be newer than the one on disk.
+    Page* page;
+    const PageId page_number = iter.page_number();
+    buf_mgr_->readPage(file_, page_number, page);
+    if (Page::DATA_SIZE - page->getFreeSpace() < limit) {
+      candidates_.push_back(page_number);
+    }
+    buf_mgr_->unPinPage(file_, page_number, false /* dirty */);
+  }
+  next_target_ = 0;
+  end_source_ = candidates_.size();
+}
+
+bool Vacuum::step() {
+  if (!started_) {
+    findCandidates();
+    started_ = true;
+  }
+
+  std::uint32_t drained = 0;
+  while (drained < pages_per_step_ && next_target_ + 1 < end_source_) {
+    const PageId source_number = candidates_[end_source_ - 1];
+    Page* source;
+    if (!pin(source_number, source)) {
+      --end_source_;
+      continue;
+    }
+    std::vector<std::pair<RecordId, std::string> > records;
+    for (PageIterator iter = source->begin(); iter != source->end(); ++iter) {
+      records.push_back(std::make_pair(iter.record_id(), *iter));
+    }
+
+    PageId target_number = Page::INVALID_NUMBER;
+    Page* target = NULL;
+    bool target_dirty = false;
+    bool drained_all = true;
+    for (std::size_t i = 0; i < records.size(); ++i) {
+      while (target == NULL || !target->hasSpaceForRecord(records[i].second)) {
+        if (target != NULL) {
+          // The target is full; move on to the next under-filled page, unless
+          // that is the source itself.
+          buf_mgr_->unPinPage(file_, target_number, target_dirty);
+          target = NULL;
+          ++next_target_;
+        }
+        if (!pinTarget(target_number, target)) {
+          break;
+        }
+        target_dirty = false;
+      }
+      if (target == NULL) {
+        drained_all = false;
+        break;
+      }
+      const RecordId to = target->insertRecord(records[i].second);
+      source->deleteRecord(records[i].first);
+      target_dirty = true;
+      ++records_moved_;
+      if (hook_) {
+        hook_(records[i].first, to);
+      }
+    }
+    if (target != NULL) {
+      buf_mgr_->unPinPage(file_, target_number, target_dirty);
+    }
+    buf_mgr_->unPinPage(file_, source_number, !records.empty());
+
+    if (!drained_all) {
+      break;
+    }
+    buf_mgr_->disposePage(file_, source_number);
+    ++pages_freed_;
+    --end_source_;
+    ++drained;
+  }
+  return next_target_ + 1 < end_source_;
+}
+
+bool Vacuum::pin(const PageId page_number, Page*& page) {
+  try {
+    buf_mgr_->readPage(file_, page_number, page);
+  } catch (InvalidPageException&) {
+    return false;
+  }
+  return true;
+}
+
+bool Vacuum::pinTarget(PageId& page_number, Page*& page) {
+  while (next_target_ + 1 < end_source_) {
+    page_number = candidates_[next_target_];
+    if (pin(page_number, page)) {
+      return true;
+    }
+    ++next_target_;
+  }
+  return false;
+}
+
+void Vacuum::run() {
+  while (step()) {
+  }
+}
+
+}
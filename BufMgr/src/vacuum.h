@@ -0,0 +1,121 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Online compaction of a heap file.
+ *
+ * After many deletes, pages are left mostly empty and a scan reads far more
+ * pages than the live records need.  The vacuum merges under-filled pages:
+ * records are moved from the under-filled pages at the end of the file's page
+ * chain into the under-filled pages at its front, and every page emptied this
+ * way is freed with BufMgr::disposePage().  All page accesses go through the
+ * buffer manager, so the file stays usable in between.
+ *
+ * Moving a record changes its RecordId.  Whoever keeps RecordIds (an index,
+ * for instance) is told about every move through the relocation hook and must
+ * fix up its references before the next step.
+ *
+ * Like the Checkpointer, the vacuum owns no thread: the thread driving the
+ * buffer manager calls step() whenever it has time, and each step drains at
+ * most <pages_per_step> source pages, which bounds the I/O it causes.
+ */
+class Vacuum {
+ public:
+  /**
+   * Called for every record moved, with its old and its new ID.
+   */
+  typedef std::function<void(const RecordId& from, const RecordId& to)>
+      RelocationHook;
+
+  /**
+   * Constructs a vacuum.
+   *
+   * @param buf_mgr         Buffer manager used to access the pages.
+   * @param file            Heap file to compact.
+   * @param max_fill        Pages filled below this fraction of their capacity
+   *                        take part in merging.
+   * @param pages_per_step  Maximum number of pages drained by one step().
+   * @param hook            Told about every record moved; may be empty.
+   */
+  Vacuum(BufMgr* buf_mgr, File* file, const double max_fill,
+         const std::uint32_t pages_per_step,
+         const RelocationHook& hook = RelocationHook());
+
+  /**
+   * Performs one increment of compaction.  The first step also determines
+   * which pages are under-filled; pages freed by others after that are
+   * skipped.
+   *
+   * @return  True if there is more work to do.
+   */
+  bool step();
+
+  /**
+   * Steps until the file is compacted.
+   */
+  void run();
+
+  /**
+   * Returns the number of records moved so far.
+   */
+  std::uint64_t recordsMoved() const { return records_moved_; }
+
+  /**
+   * Returns the number of pages freed so far.
+   */
+  std::uint64_t pagesFreed() const { return pages_freed_; }
+
+ private:
+  /**
+   * Collects the under-filled pages in chain order.
+   */
+  void findCandidates();
+
+  /**
+   * Pins a candidate page.  Returns false if the page has been freed since
+   * the candidates were collected.
+   */
+  bool pin(const PageId page_number, Page*& page);
+
+  /**
+   * Pins the candidate at <next_target_>, first skipping candidates that have
+   * been freed.  Returns false if no target is left before the source.
+   */
+  bool pinTarget(PageId& page_number, Page*& page);
+
+  BufMgr* buf_mgr_;
+  File* file_;
+  double max_fill_;
+  std::uint32_t pages_per_step_;
+  RelocationHook hook_;
+  bool started_;
+
+  /**
+   * Under-filled pages in chain order.  Pages before <next_target_> are full;
+   * pages from <end_source_> on have been freed.
+   */
+  std::vector<PageId> candidates_;
+  std::size_t next_target_;
+  std::size_t end_source_;
+
+  std::uint64_t records_moved_;
+  std::uint64_t pages_freed_;
+};
+
+}
@@ -0,0 +1,50 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "zone_map.h"
+
+#include "file_iterator.h"
+#include "page_iterator.h"
+
+namespace badgerdb {
+
+ZoneMap::ZoneMap(const ValueExtractor& value)
+    : value_(value) {
+}
+
+void ZoneMap::build(BufMgr* buf_mgr, File* file) {
+  zones_.clear();
+  for (FileIterator iter = file->begin(); iter != file->end(); ++iter) {
+    Page* page;
+    const PageId page_number = iter.page_number();
+    buf_mgr->readPage(file, page_number, page);
+    updatePage(*page);
+    buf_mgr->unPinPage(file, page_number, false /* dirty */);
+  }
+}
+
+void ZoneMap::updatePage(Page& page) {
+  Zone zone = {0 /* min */, 0 /* max */, 0 /* count */};
+  for (PageIterator iter = page.begin(); iter != page.end(); ++iter) {
+    const double value = value_(*iter);
+    if (zone.count == 0 || value < zone.min) zone.min = value;
+    if (zone.count == 0 || value > zone.max) zone.max = value;
+    ++zone.count;
+  }
+  zones_[page.page_number()] = zone;
+}
+
+bool ZoneMap::lookup(const PageId page_number, Zone& zone) const {
+  std::map<PageId, Zone>::const_iterator iter = zones_.find(page_number);
+  if (iter == zones_.end()) {
+    return false;
+  }
+  zone = iter->second;
+  return true;
+}
+
+}
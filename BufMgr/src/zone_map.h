@@ -0,0 +1,113 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+#include "buffer.h"
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Smallest and largest value of a field over the records of one page.
+ */
+struct Zone {
+  /**
+   * Smallest value on the page.
+   */
+  double min;
+
+  /**
+   * Largest value on the page.
+   */
+  double max;
+
+  /**
+   * Number of records the zone was computed over.
+   */
+  std::uint32_t count;
+};
+
+/**
+ * @brief Per-page min/max summary of one field of a heap file.
+ *
+ * Scans consult the zone map to skip pages which cannot contain qualifying
+ * records.  The map is not maintained automatically: callers that modify a
+ * page must call updatePage() (or removePage() when it is disposed), and pages
+ * missing from the map are always treated as possibly qualifying.
+ *
+ * @warning This class is not threadsafe.
+ */
+class ZoneMap {
+ public:
+  /**
+   * Extracts the summarized value of a record.
+   */
+  typedef std::function<double(const std::string&)> ValueExtractor;
+
+  /**
+   * Constructs an empty zone map for the field returned by <value>.
+   *
+   * @param value   Extracts the summarized value of a record.
+   */
+  explicit ZoneMap(const ValueExtractor& value);
+
+  /**
+   * Discards the current contents and computes a zone for every used page of
+   * the file, reading the pages through the buffer manager.
+   *
+   * @param buf_mgr   Buffer manager used to read the pages.
+   * @param file      File to summarize.
+   */
+  void build(BufMgr* buf_mgr, File* file);
+
+  /**
+   * Recomputes the zone of a single page.
+   *
+   * @param page  Page whose records are summarized.
+   */
+  void updatePage(Page& page);
+
+  /**
+   * Forgets the zone of a page, e.g. after it has been disposed.
+   *
+   * @param page_number   Number of page.
+   */
+  void removePage(const PageId page_number) { zones_.erase(page_number); }
+
+  /**
+   * Looks up the zone of a page.
+   *
+   * @param page_number   Number of page.
+   * @param zone          Receives the zone if one is known.
+   * @return  True if the page has a zone.
+   */
+  bool lookup(const PageId page_number, Zone& zone) const;
+
+  /**
+   * Returns the number of pages summarized.
+   */
+  std::size_t size() const { return zones_.size(); }
+
+ private:
+  /**
+   * Value extractor.
+   */
+  ValueExtractor value_;
+
+  /**
+   * Zone of every summarized page.
+   */
+  std::map<PageId, Zone> zones_;
+};
+
+}